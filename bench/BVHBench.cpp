@@ -0,0 +1,195 @@
+// CPU-only benchmark for DynamicBVH. Builds a tree over a generated grid of boxes and
+// measures build, refit and query throughput. Runs without a window or GL context.
+//
+// Usage: BVHBench [objectCount] [queryCount]
+
+#include "BVH.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::high_resolution_clock;
+
+    double ElapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    struct BenchObject {
+        BoundingBox bounds;
+        int proxy = DynamicBVH::NullNode;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    int objectCount = argc > 1 ? std::atoi(argv[1]) : 100000;
+    int queryCount = argc > 2 ? std::atoi(argv[2]) : 1000;
+    if (objectCount <= 0 || queryCount <= 0)
+    {
+        std::cerr << "Usage: BVHBench [objectCount] [queryCount]" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    // Unit boxes on a cubic grid with 3 units spacing, slightly jittered
+    int side = static_cast<int>(std::ceil(std::cbrt(static_cast<double>(objectCount))));
+    const float spacing = 3.0f;
+    float gridExtent = side * spacing;
+
+    std::vector<BenchObject> objects(objectCount);
+    for (int i = 0; i < objectCount; i++)
+    {
+        glm::vec3 cell(static_cast<float>(i % side), static_cast<float>((i / side) % side), static_cast<float>(i / (side * side)));
+        glm::vec3 center = cell * spacing + glm::vec3(unit(random), unit(random), unit(random)) * 0.5f;
+        glm::vec3 halfSize = glm::vec3(0.5f) + glm::vec3(unit(random), unit(random), unit(random)) * 0.25f;
+        objects[i].bounds = BoundingBox(center - halfSize, center + halfSize);
+    }
+
+    std::cout << "DynamicBVH benchmark: " << objectCount << " objects (" << side << "^3 grid), "
+              << queryCount << " queries per type" << std::endl;
+
+    // Incremental build
+    DynamicBVH tree(0.1f);
+    auto start = Clock::now();
+    for (int i = 0; i < objectCount; i++)
+        objects[i].proxy = tree.CreateProxy(objects[i].bounds, &objects[i]);
+    double buildMs = ElapsedMs(start);
+
+    std::cout << "  build:        " << buildMs << " ms (" << (buildMs * 1000.0 / objectCount) << " us/insert), height "
+              << tree.GetHeight() << ", area ratio " << tree.GetAreaRatio() << std::endl;
+
+    // Refit: small moves mostly stay inside the fat boxes, large moves force reinsertion
+    int moveCount = std::max(1, objectCount / 10);
+    int reinserted = 0;
+    start = Clock::now();
+    for (int i = 0; i < moveCount; i++)
+    {
+        BenchObject& object = objects[random() % objectCount];
+        float distance = (i % 2 == 0) ? 0.05f : spacing;
+        glm::vec3 offset = (glm::vec3(unit(random), unit(random), unit(random)) - glm::vec3(0.5f)) * (2.0f * distance);
+        object.bounds = BoundingBox(object.bounds.min + offset, object.bounds.max + offset);
+        if (tree.MoveProxy(object.proxy, object.bounds))
+            reinserted++;
+    }
+    double refitMs = ElapsedMs(start);
+
+    std::cout << "  refit:        " << refitMs << " ms for " << moveCount << " moves (" << reinserted << " reinserted), height "
+              << tree.GetHeight() << std::endl;
+
+    // Frustum queries from cameras inside and around the grid
+    std::vector<Frustum> frustums(queryCount);
+    for (int i = 0; i < queryCount; i++)
+    {
+        glm::vec3 eye = glm::vec3(unit(random), unit(random), unit(random)) * (gridExtent * 1.2f) - glm::vec3(gridExtent * 0.1f);
+        glm::vec3 target = glm::vec3(unit(random), unit(random), unit(random)) * gridExtent;
+        if (glm::length(target - eye) < 1.0f)
+            target = eye + glm::vec3(0.0f, 0.0f, -1.0f);
+        glm::vec3 up = std::abs(glm::normalize(target - eye).y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+        glm::mat4 view = glm::lookAt(eye, target, up);
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+        frustums[i].Update(projection * view);
+    }
+
+    std::vector<void*> results;
+    results.reserve(objectCount);
+    std::size_t frustumHits = 0;
+    start = Clock::now();
+    for (const Frustum& frustum : frustums)
+    {
+        results.clear();
+        tree.QueryFrustum(frustum, results);
+        frustumHits += results.size();
+    }
+    double frustumMs = ElapsedMs(start);
+
+    // Linear scan over the same fat boxes, timed on its own for the speedup
+    int bruteQueries = std::min(queryCount, 50);
+    std::vector<std::size_t> bruteCounts(bruteQueries, 0);
+    start = Clock::now();
+    for (int i = 0; i < bruteQueries; i++)
+    {
+        for (const BenchObject& object : objects)
+        {
+            if (frustums[i].Intersects(tree.GetFatBounds(object.proxy)))
+                bruteCounts[i]++;
+        }
+    }
+    double bruteMs = ElapsedMs(start) / bruteQueries;
+
+    // Correctness check outside the timed regions
+    for (int i = 0; i < bruteQueries; i++)
+    {
+        results.clear();
+        tree.QueryFrustum(frustums[i], results);
+        if (bruteCounts[i] != results.size())
+        {
+            std::cerr << "Mismatch in frustum query " << i << ": tree " << results.size() << ", brute force " << bruteCounts[i] << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "  frustum:      " << (frustumMs / queryCount) << " ms/query, " << (frustumHits / queryCount)
+              << " avg hits (linear scan " << bruteMs << " ms/query, " << (bruteMs * queryCount / frustumMs) << "x)" << std::endl;
+
+    // Box and sphere range queries of a few cells
+    std::size_t boxHits = 0;
+    start = Clock::now();
+    for (int i = 0; i < queryCount; i++)
+    {
+        glm::vec3 center = glm::vec3(unit(random), unit(random), unit(random)) * gridExtent;
+        results.clear();
+        tree.QueryBox(BoundingBox(center - glm::vec3(spacing * 2.0f), center + glm::vec3(spacing * 2.0f)), results);
+        boxHits += results.size();
+    }
+    double boxMs = ElapsedMs(start);
+    std::cout << "  box:          " << (boxMs / queryCount) << " ms/query, " << (boxHits / queryCount) << " avg hits" << std::endl;
+
+    std::size_t sphereHits = 0;
+    start = Clock::now();
+    for (int i = 0; i < queryCount; i++)
+    {
+        BoundingSphere sphere;
+        sphere.center = glm::vec3(unit(random), unit(random), unit(random)) * gridExtent;
+        sphere.radius = spacing * 2.0f;
+        results.clear();
+        tree.QuerySphere(sphere, results);
+        sphereHits += results.size();
+    }
+    double sphereMs = ElapsedMs(start);
+    std::cout << "  sphere:       " << (sphereMs / queryCount) << " ms/query, " << (sphereHits / queryCount) << " avg hits" << std::endl;
+
+    // Rays through the grid
+    std::vector<DynamicBVH::RayHit> rayHits;
+    std::size_t rayHitCount = 0;
+    start = Clock::now();
+    for (int i = 0; i < queryCount; i++)
+    {
+        Ray ray;
+        ray.origin = glm::vec3(unit(random), unit(random), unit(random)) * gridExtent;
+        ray.direction = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) - glm::vec3(0.5f));
+        rayHits.clear();
+        tree.QueryRay(ray, 50.0f, rayHits);
+        rayHitCount += rayHits.size();
+    }
+    double rayMs = ElapsedMs(start);
+    std::cout << "  ray:          " << (rayMs / queryCount) << " ms/query, " << (rayHitCount / queryCount) << " avg hits" << std::endl;
+
+    // Remove everything to exercise the free list
+    start = Clock::now();
+    for (const BenchObject& object : objects)
+        tree.DestroyProxy(object.proxy);
+    double removeMs = ElapsedMs(start);
+    std::cout << "  remove:       " << removeMs << " ms, " << tree.GetProxyCount() << " proxies left" << std::endl;
+
+    return tree.GetProxyCount() == 0 ? 0 : 1;
+}
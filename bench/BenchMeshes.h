@@ -0,0 +1,162 @@
+#pragma once
+
+#include "Vertex.h"
+#include <glm/glm.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Mesh sources shared by the CPU-only geometry benchmarks
+
+struct BenchMesh {
+    std::string name;
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+};
+
+// Resolves a 1-based (or negative, relative) OBJ index, -1 when absent or out of range
+inline int ResolveObjIndex(const std::string& token, std::size_t count)
+{
+    if (token.empty())
+        return -1;
+    int index = std::atoi(token.c_str());
+    int resolved = index < 0 ? static_cast<int>(count) + index : index - 1;
+    return (resolved >= 0 && resolved < static_cast<int>(count)) ? resolved : -1;
+}
+
+// Positions, texture coordinates and normals of faces; o/g lines start a new mesh.
+// Identical v/vt/vn triplets within a mesh share one vertex.
+inline bool LoadObj(const std::string& path, std::vector<BenchMesh>& meshes)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cerr << "Failed to open " << path << std::endl;
+        return false;
+    }
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> texCoords;
+    std::unordered_map<std::string, unsigned int> vertexLookup;
+    meshes.push_back({ path, {}, {} });
+
+    std::string line;
+    std::vector<unsigned int> face;
+    while (std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        std::string type;
+        stream >> type;
+
+        if (type == "v")
+        {
+            glm::vec3 p(0.0f);
+            stream >> p.x >> p.y >> p.z;
+            positions.push_back(p);
+        }
+        else if (type == "vn")
+        {
+            glm::vec3 n(0.0f);
+            stream >> n.x >> n.y >> n.z;
+            normals.push_back(n);
+        }
+        else if (type == "vt")
+        {
+            glm::vec2 t(0.0f);
+            stream >> t.x >> t.y;
+            texCoords.push_back(t);
+        }
+        else if (type == "o" || type == "g")
+        {
+            if (!meshes.back().indices.empty())
+                meshes.push_back({ {}, {}, {} });
+            std::getline(stream >> std::ws, meshes.back().name);
+            vertexLookup.clear();
+        }
+        else if (type == "f")
+        {
+            BenchMesh& mesh = meshes.back();
+            face.clear();
+            std::string corner;
+            while (stream >> corner)
+            {
+                auto found = vertexLookup.find(corner);
+                if (found != vertexLookup.end())
+                {
+                    face.push_back(found->second);
+                    continue;
+                }
+
+                std::size_t slash = corner.find('/');
+                std::size_t secondSlash = slash == std::string::npos ? std::string::npos : corner.find('/', slash + 1);
+                int position = ResolveObjIndex(corner.substr(0, slash), positions.size());
+                int texCoord = slash == std::string::npos ? -1 : ResolveObjIndex(corner.substr(slash + 1, secondSlash - slash - 1), texCoords.size());
+                int normal = secondSlash == std::string::npos ? -1 : ResolveObjIndex(corner.substr(secondSlash + 1), normals.size());
+                if (position < 0)
+                    continue;
+
+                Vertex vertex;
+                vertex.position = positions[position];
+                vertex.texCoords = texCoord >= 0 ? texCoords[texCoord] : glm::vec2(0.0f);
+                vertex.normal = normal >= 0 ? normals[normal] : glm::vec3(0.0f);
+
+                unsigned int index = static_cast<unsigned int>(mesh.vertices.size());
+                mesh.vertices.push_back(vertex);
+                vertexLookup.emplace(corner, index);
+                face.push_back(index);
+            }
+
+            // Polygons are fanned into triangles
+            for (std::size_t i = 2; i < face.size(); i++)
+            {
+                mesh.indices.push_back(face[0]);
+                mesh.indices.push_back(face[i - 1]);
+                mesh.indices.push_back(face[i]);
+            }
+        }
+    }
+
+    if (meshes.back().indices.empty())
+        meshes.pop_back();
+    return !meshes.empty();
+}
+
+// Height field grid with a few overlapping waves, so collapses have real curvature to trade off
+inline BenchMesh CreateWavyGrid(int resolution, float phase)
+{
+    BenchMesh mesh;
+    mesh.name = "grid " + std::to_string(resolution) + "^2";
+    mesh.vertices.reserve(static_cast<std::size_t>(resolution + 1) * (resolution + 1));
+    for (int y = 0; y <= resolution; y++)
+    {
+        for (int x = 0; x <= resolution; x++)
+        {
+            float u = static_cast<float>(x) / resolution;
+            float v = static_cast<float>(y) / resolution;
+            float height = 0.05f * std::sin(u * 12.0f + phase) * std::cos(v * 9.0f) + 0.02f * std::sin((u + v) * 31.0f);
+
+            Vertex vertex;
+            vertex.position = glm::vec3(u - 0.5f, height, v - 0.5f);
+            vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+            vertex.texCoords = glm::vec2(u, v);
+            mesh.vertices.push_back(vertex);
+        }
+    }
+
+    for (int y = 0; y < resolution; y++)
+    {
+        for (int x = 0; x < resolution; x++)
+        {
+            unsigned int topLeft = y * (resolution + 1) + x;
+            unsigned int bottomLeft = topLeft + resolution + 1;
+            mesh.indices.insert(mesh.indices.end(), { topLeft, bottomLeft, topLeft + 1, topLeft + 1, bottomLeft, bottomLeft + 1 });
+        }
+    }
+    return mesh;
+}
@@ -0,0 +1,145 @@
+// CPU-only benchmark for MeshOptimizer. Runs each reordering stage over the meshes of an OBJ file
+// and reports time and post-transform cache statistics (ACMR, ATVR) before and after, for the
+// cache size the optimiser targets and for a larger one. Without a file it generates dense grids
+// and shuffles their triangles, like the arbitrary face order of scanned models.
+//
+// Usage: MeshOptimizerBench [file.obj]
+
+#include "MeshOptimizer.h"
+#include "BenchMeshes.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::high_resolution_clock;
+
+    double ElapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    MeshOptimizer::Stats Analyze(const std::vector<BenchMesh>& meshes, int cacheSize)
+    {
+        MeshOptimizer::Stats total;
+        for (const BenchMesh& mesh : meshes)
+            total.Add(MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertices.size(), cacheSize));
+        return total;
+    }
+
+    void PrintStats(const char* label, const std::vector<BenchMesh>& meshes)
+    {
+        MeshOptimizer::Stats stats = Analyze(meshes, MeshOptimizer::CACHE_SIZE);
+        MeshOptimizer::Stats largeCache = Analyze(meshes, 32);
+        std::cout << "  " << label << "ACMR " << stats.GetAcmr() << ", ATVR " << stats.GetAtvr()
+                  << " (32 entries: ACMR " << largeCache.GetAcmr() << ", ATVR " << largeCache.GetAtvr() << ")" << std::endl;
+    }
+
+    // Sorted triangles with their rotation normalised, to check a reordering drew the same mesh
+    std::vector<glm::vec3> TriangleSet(const BenchMesh& mesh)
+    {
+        std::vector<std::vector<float>> triangles;
+        for (std::size_t t = 0; t + 2 < mesh.indices.size(); t += 3)
+        {
+            std::vector<float> corners;
+            for (int rotation = 0; rotation < 3; rotation++)
+            {
+                const glm::vec3& p = mesh.vertices[mesh.indices[t + rotation]].position;
+                corners.insert(corners.end(), { p.x, p.y, p.z });
+            }
+            std::vector<float> smallest = corners;
+            for (int rotation = 1; rotation < 3; rotation++)
+            {
+                std::rotate(corners.begin(), corners.begin() + 3, corners.end());
+                smallest = std::min(smallest, corners);
+            }
+            triangles.push_back(smallest);
+        }
+        std::sort(triangles.begin(), triangles.end());
+
+        std::vector<glm::vec3> flattened;
+        for (const std::vector<float>& triangle : triangles)
+            for (int corner = 0; corner < 3; corner++)
+                flattened.emplace_back(triangle[corner * 3], triangle[corner * 3 + 1], triangle[corner * 3 + 2]);
+        return flattened;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<BenchMesh> meshes;
+    if (argc > 1)
+    {
+        if (!LoadObj(argv[1], meshes))
+            return 1;
+    }
+    else
+    {
+        std::mt19937 random(1234);
+        for (int i = 0; i < 4; i++)
+        {
+            BenchMesh mesh = CreateWavyGrid(384, static_cast<float>(i));
+            std::vector<std::size_t> order(mesh.indices.size() / 3);
+            for (std::size_t t = 0; t < order.size(); t++)
+                order[t] = t;
+            std::shuffle(order.begin(), order.end(), random);
+
+            std::vector<unsigned int> shuffled;
+            shuffled.reserve(mesh.indices.size());
+            for (std::size_t t : order)
+                shuffled.insert(shuffled.end(), mesh.indices.begin() + t * 3, mesh.indices.begin() + t * 3 + 3);
+            mesh.indices.swap(shuffled);
+            meshes.push_back(std::move(mesh));
+        }
+    }
+
+    std::size_t totalTriangles = 0;
+    for (const BenchMesh& mesh : meshes)
+        totalTriangles += mesh.indices.size() / 3;
+
+    std::cout << "MeshOptimizer benchmark: " << meshes.size() << " meshes, " << totalTriangles << " triangles" << std::endl;
+    PrintStats("input:        ", meshes);
+
+    std::vector<BenchMesh> original = meshes;
+
+    auto start = Clock::now();
+    for (BenchMesh& mesh : meshes)
+        MeshOptimizer::OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+    double cacheMs = ElapsedMs(start);
+    std::cout << "  vertex cache: " << cacheMs << " ms (" << totalTriangles / (cacheMs * 1000.0) << " M tris/s)" << std::endl;
+    PrintStats("              ", meshes);
+
+    start = Clock::now();
+    for (BenchMesh& mesh : meshes)
+        MeshOptimizer::OptimizeOverdraw(mesh.vertices, mesh.indices);
+    double overdrawMs = ElapsedMs(start);
+    std::cout << "  overdraw:     " << overdrawMs << " ms (" << totalTriangles / (overdrawMs * 1000.0) << " M tris/s)" << std::endl;
+    PrintStats("              ", meshes);
+
+    start = Clock::now();
+    for (BenchMesh& mesh : meshes)
+        MeshOptimizer::OptimizeVertexFetch(mesh.vertices, mesh.indices);
+    double fetchMs = ElapsedMs(start);
+    std::cout << "  vertex fetch: " << fetchMs << " ms (" << totalTriangles / (fetchMs * 1000.0) << " M tris/s)" << std::endl;
+
+    // Same input, same output, and the same triangles as before
+    std::vector<BenchMesh> again = original;
+    for (std::size_t i = 0; i < again.size(); i++)
+    {
+        MeshOptimizer::Optimize(again[i].vertices, again[i].indices);
+        if (again[i].indices != meshes[i].indices)
+        {
+            std::cerr << "Optimize is not deterministic for mesh " << i << std::endl;
+            return 1;
+        }
+        if (TriangleSet(original[i]) != TriangleSet(meshes[i]))
+        {
+            std::cerr << "Optimized mesh " << i << " draws different triangles" << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
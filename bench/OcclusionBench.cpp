@@ -0,0 +1,244 @@
+// CPU-only benchmark for OcclusionCuller. Generates a city of blocks with one building each and
+// street props around them, then rasterises the buildings from street level cameras and tests
+// every building and prop against the depth buffer. Runs each SIMD path single and multithreaded,
+// and fails when a path's depth buffer differs from the scalar one in any bit.
+//
+// Usage: OcclusionBench [blocksPerSide] [frames]
+
+#include "OcclusionCuller.h"
+#include "ThreadPool.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::high_resolution_clock;
+
+    double ElapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Unit cube around the origin, counter-clockwise from outside, each face split into
+    // subdivisions^2 quads so occluders carry a realistic triangle count
+    void BuildBox(int subdivisions, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+    {
+        const glm::vec3 faces[6][3] = {
+            { glm::vec3(1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, 0, 1) },
+            { glm::vec3(-1, 0, 0), glm::vec3(0, 0, 1), glm::vec3(0, 1, 0) },
+            { glm::vec3(0, 1, 0), glm::vec3(0, 0, 1), glm::vec3(1, 0, 0) },
+            { glm::vec3(0, -1, 0), glm::vec3(1, 0, 0), glm::vec3(0, 0, 1) },
+            { glm::vec3(0, 0, 1), glm::vec3(1, 0, 0), glm::vec3(0, 1, 0) },
+            { glm::vec3(0, 0, -1), glm::vec3(0, 1, 0), glm::vec3(1, 0, 0) }
+        };
+
+        for (const auto& face : faces)
+        {
+            unsigned int base = static_cast<unsigned int>(vertices.size());
+            for (int j = 0; j <= subdivisions; j++)
+            {
+                for (int i = 0; i <= subdivisions; i++)
+                {
+                    float s = static_cast<float>(i) / subdivisions - 0.5f;
+                    float t = static_cast<float>(j) / subdivisions - 0.5f;
+                    vertices.push_back({ face[0] * 0.5f + face[1] * s + face[2] * t, face[0], glm::vec2(s, t) });
+                }
+            }
+
+            const unsigned int row = static_cast<unsigned int>(subdivisions + 1);
+            for (unsigned int j = 0; j < static_cast<unsigned int>(subdivisions); j++)
+            {
+                for (unsigned int i = 0; i < static_cast<unsigned int>(subdivisions); i++)
+                {
+                    unsigned int a = base + j * row + i;
+                    indices.insert(indices.end(), { a, a + 1, a + row + 1, a, a + row + 1, a + row });
+                }
+            }
+        }
+    }
+
+    struct Building {
+        glm::mat4 model;
+        BoundingBox bounds;
+    };
+
+    struct Frame {
+        glm::mat4 viewProjection;
+        std::vector<const Building*> occluders;
+        std::vector<BoundingBox> occludees;
+    };
+
+    struct PathResult {
+        double milliseconds = 0.0;
+        std::size_t rasterizedTriangles = 0;
+        int tested = 0;
+        int culled = 0;
+        bool matches = true;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    int blocksPerSide = argc > 1 ? std::atoi(argv[1]) : 16;
+    int frameCount = argc > 2 ? std::atoi(argv[2]) : 64;
+    if (blocksPerSide <= 0 || frameCount <= 0)
+    {
+        std::cerr << "Usage: OcclusionBench [blocksPerSide] [frames]" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<Vertex> boxVertices;
+    std::vector<unsigned int> boxIndices;
+    BuildBox(4, boxVertices, boxIndices);
+
+    // Blocks of 20 units with 8 unit streets between them; a building fills most of each block
+    // and props (cars, benches, lamps) line the pavement around it
+    const float blockSize = 20.0f;
+    const float streetWidth = 8.0f;
+    const float pitch = blockSize + streetWidth;
+    const int propsPerBlock = 24;
+    std::vector<Building> buildings;
+    std::vector<BoundingBox> props;
+    for (int z = 0; z < blocksPerSide; z++)
+    {
+        for (int x = 0; x < blocksPerSide; x++)
+        {
+            glm::vec3 corner(x * pitch, 0.0f, z * pitch);
+            glm::vec3 size(blockSize - 4.0f * unit(random), 8.0f + 40.0f * unit(random), blockSize - 4.0f * unit(random));
+            glm::vec3 center = corner + glm::vec3(blockSize * 0.5f, size.y * 0.5f, blockSize * 0.5f);
+            glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), center), size);
+            buildings.push_back({ model, BoundingBox(center - size * 0.5f, center + size * 0.5f) });
+
+            for (int p = 0; p < propsPerBlock; p++)
+            {
+                // Along one of the four sides, just off the building
+                float along = unit(random) * (blockSize + streetWidth * 0.5f) - streetWidth * 0.25f;
+                float across = -1.0f - 2.0f * unit(random);
+                int side = p % 4;
+                glm::vec3 position = corner + (side == 0 ? glm::vec3(along, 0.0f, across)
+                                             : side == 1 ? glm::vec3(along, 0.0f, blockSize - across)
+                                             : side == 2 ? glm::vec3(across, 0.0f, along)
+                                                         : glm::vec3(blockSize - across, 0.0f, along));
+                glm::vec3 halfSize(0.3f + 1.5f * unit(random), 0.5f + 1.0f * unit(random), 0.3f + 1.5f * unit(random));
+                props.push_back(BoundingBox(position - glm::vec3(halfSize.x, 0.0f, halfSize.z),
+                                            position + glm::vec3(halfSize.x, halfSize.y * 2.0f, halfSize.z)));
+            }
+        }
+    }
+
+    // Pedestrian cameras in random streets, looking along or across them. Like the renderer, only
+    // what survives frustum culling is drawn as an occluder or tested.
+    const float cityExtent = blocksPerSide * pitch;
+    const float aspect = static_cast<float>(OcclusionCuller::DEFAULT_WIDTH) / OcclusionCuller::DEFAULT_HEIGHT;
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), aspect, 0.1f, 1000.0f);
+    std::vector<Frame> frames(frameCount);
+    std::size_t candidateCount = 0;
+    for (Frame& frame : frames)
+    {
+        float street = static_cast<float>(random() % blocksPerSide) * pitch - streetWidth * 0.5f;
+        float along = unit(random) * cityExtent;
+        glm::vec3 eye = (random() % 2 == 0) ? glm::vec3(street, 1.7f, along) : glm::vec3(along, 1.7f, street);
+        float heading = unit(random) * 2.0f * glm::pi<float>();
+        glm::vec3 target = eye + glm::vec3(std::cos(heading), 0.05f, std::sin(heading));
+        frame.viewProjection = projection * glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+
+        Frustum frustum(frame.viewProjection);
+        for (const Building& building : buildings)
+        {
+            if (frustum.Intersects(building.bounds))
+            {
+                frame.occluders.push_back(&building);
+                frame.occludees.push_back(building.bounds);
+            }
+        }
+        for (const BoundingBox& prop : props)
+        {
+            if (frustum.Intersects(prop))
+                frame.occludees.push_back(prop);
+        }
+        candidateCount += frame.occludees.size();
+    }
+
+    std::cout << "Occlusion culling benchmark: " << buildings.size() << " buildings (" << boxIndices.size() / 3
+              << " triangles each), " << props.size() << " props, " << frameCount << " frames with "
+              << (candidateCount / frameCount) << " objects in the frustum on average, "
+              << ThreadPool::GetInstance()->GetThreadCount() << " worker threads" << std::endl;
+
+    const OcclusionCuller::SimdPath paths[] = {
+        OcclusionCuller::SimdPath::Scalar, OcclusionCuller::SimdPath::SSE2, OcclusionCuller::SimdPath::AVX2
+    };
+    const OcclusionCuller::SimdPath bestPath = OcclusionCuller::GetBestSimdPath();
+
+    std::vector<std::vector<float>> referenceBuffers(frameCount);
+    bool allMatch = true;
+    for (OcclusionCuller::SimdPath path : paths)
+    {
+        if (static_cast<int>(path) > static_cast<int>(bestPath))
+        {
+            std::cout << "  " << OcclusionCuller::GetSimdPathName(path) << ": not supported by this CPU" << std::endl;
+            continue;
+        }
+
+        for (bool multithreaded : { false, true })
+        {
+            OcclusionCuller culler;
+            culler.SetSimdPath(path);
+            culler.SetMultithreaded(multithreaded);
+
+            PathResult result;
+            double testMs = 0.0;
+            for (int i = 0; i < frameCount; i++)
+            {
+                const Frame& frame = frames[i];
+                auto start = Clock::now();
+                culler.BeginFrame(frame.viewProjection);
+                for (const Building* building : frame.occluders)
+                    culler.AddOccluder(boxVertices.data(), boxVertices.size(), boxIndices.data(), boxIndices.size(), building->model);
+                culler.RasterizeOccluders();
+                result.milliseconds += ElapsedMs(start);
+
+                start = Clock::now();
+                for (const BoundingBox& occludee : frame.occludees)
+                    culler.IsVisible(occludee);
+                testMs += ElapsedMs(start);
+
+                const OcclusionCuller::Stats& stats = culler.GetStats();
+                result.rasterizedTriangles += stats.rasterizedTriangles;
+                result.tested += stats.tested;
+                result.culled += stats.culled;
+
+                const std::vector<float>& buffer = culler.GetDepthBuffer();
+                if (referenceBuffers[i].empty())
+                    referenceBuffers[i] = buffer;
+                else if (std::memcmp(buffer.data(), referenceBuffers[i].data(), buffer.size() * sizeof(float)) != 0)
+                    result.matches = false;
+            }
+
+            double trianglesPerSecond = result.rasterizedTriangles / (result.milliseconds / 1000.0);
+            std::cout << "  " << OcclusionCuller::GetSimdPathName(path) << (multithreaded ? " mt: " : " st: ")
+                      << (result.milliseconds / frameCount) << " ms/frame rasterise, " << (trianglesPerSecond / 1.0e6)
+                      << " M tris/s, " << (testMs * 1000.0 / result.tested) << " us/test, culled "
+                      << (100.0 * result.culled / result.tested) << "% of " << (result.tested / frameCount)
+                      << (result.matches ? "" : "  DEPTH MISMATCH") << std::endl;
+            allMatch = allMatch && result.matches;
+        }
+    }
+
+    if (!allMatch)
+    {
+        std::cerr << "Depth buffers differ between paths" << std::endl;
+        return 1;
+    }
+    std::cout << "  depth buffers bit-identical across all paths" << std::endl;
+    return 0;
+}
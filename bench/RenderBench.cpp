@@ -0,0 +1,420 @@
+// Headless rendering benchmark. Renders benchmark scenes offscreen in every RenderMode along a
+// scripted orbit camera and writes per-frame CPU/GPU times, percentiles, draw calls and
+// triangle counts as JSON. Runs without a display, see BenchContext.h.
+//
+// Usage: OpenGLLearningBench [--scene file.json]... [--warmup N] [--frames N]
+//                            [--width W] [--height H] [--output results.json]
+//                            [--target-ms T]   (enables dynamic resolution with a T ms GPU budget)
+//                            [--vertex-format compact|float]
+//                            [--elevation degrees]   (orbit camera pitch, low values view grids edge-on)
+//                            [--front-to-back on|off]
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/constants.hpp>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Renderer.h"
+#include "GLState.h"
+#include "Scene.h"
+#include "SceneObject.h"
+#include "Camera.h"
+#include "ResourceManager.h"
+#include "BenchContext.h"
+
+using json = nlohmann::json;
+
+namespace {
+    using Clock = std::chrono::high_resolution_clock;
+
+    struct BenchConfig {
+        std::vector<std::string> scenes;
+        int warmupFrames = 30;
+        int measuredFrames = 300;
+        int width = 1280;
+        int height = 720;
+        std::string outputPath = "bench_results.json";
+        float targetFrameMs = 0.0f;
+        bool compactVertices = true;
+        float elevationDegrees = 30.0f;
+        bool frontToBack = true;
+    };
+
+    struct FrameSample {
+        double cpuMs = 0.0;
+        double gpuMs = 0.0;
+        RenderStats stats;
+        GLStateStats stateChanges;
+        float renderScale = 1.0f;
+    };
+
+    struct ModeInfo {
+        RenderMode mode;
+        const char* name;
+        GBufferLayout gBufferLayout = GBufferLayout::Standard;
+        bool tiledLighting = false;
+        bool clusterCompute = true;
+        bool adaptiveTessellation = true;
+        bool tessellationCache = false;
+        bool depthPrepass = false;
+        bool occlusionCulling = false;
+    };
+
+    const ModeInfo BENCH_MODES[] = {
+        { RenderMode::Solid, "Solid" },
+        { RenderMode::Solid, "SolidDepthPrepass", GBufferLayout::Standard, false, true, true, false, true },
+        { RenderMode::Solid, "SolidOcclusionCulling", GBufferLayout::Standard, false, true, true, false, false, true },
+        { RenderMode::Wireframe, "Wireframe" },
+        { RenderMode::Deferred, "Deferred" },
+        { RenderMode::Deferred, "DeferredCompact", GBufferLayout::Compact },
+        { RenderMode::Deferred, "DeferredTiled", GBufferLayout::Standard, true },
+        { RenderMode::ClusteredForward, "ClusteredForward" },
+        { RenderMode::ClusteredForward, "ClusteredForwardCpu", GBufferLayout::Standard, false, false },
+        { RenderMode::ClusteredForward, "ClusteredForwardDepthPrepass", GBufferLayout::Standard, false, true, true, false, true },
+        { RenderMode::Tessellation, "Tessellation" },
+        { RenderMode::Tessellation, "TessellationFixed", GBufferLayout::Standard, false, true, false },
+        { RenderMode::Tessellation, "TessellationCached", GBufferLayout::Standard, false, true, false, true },
+        { RenderMode::TessellationWithWireframe, "TessellationWithWireframe" },
+    };
+
+    bool ParseArguments(int argc, char** argv, BenchConfig& config)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << arg << std::endl;
+                return false;
+            }
+
+            std::string value = argv[++i];
+            if (arg == "--scene") config.scenes.push_back(value);
+            else if (arg == "--warmup") config.warmupFrames = std::atoi(value.c_str());
+            else if (arg == "--frames") config.measuredFrames = std::atoi(value.c_str());
+            else if (arg == "--width") config.width = std::atoi(value.c_str());
+            else if (arg == "--height") config.height = std::atoi(value.c_str());
+            else if (arg == "--output") config.outputPath = value;
+            else if (arg == "--target-ms") config.targetFrameMs = static_cast<float>(std::atof(value.c_str()));
+            else if (arg == "--vertex-format" && (value == "compact" || value == "float")) config.compactVertices = value == "compact";
+            else if (arg == "--elevation") config.elevationDegrees = static_cast<float>(std::atof(value.c_str()));
+            else if (arg == "--front-to-back" && (value == "on" || value == "off")) config.frontToBack = value == "on";
+            else
+            {
+                std::cerr << "Unknown argument: " << arg << std::endl;
+                return false;
+            }
+        }
+
+        if (config.scenes.empty())
+        {
+            config.scenes.push_back("resources/scenes/benchmark/5x5_basic.json");
+            config.scenes.push_back("resources/scenes/benchmark/30x30_basic.json");
+            config.scenes.push_back("resources/scenes/benchmark/many_lights.json");
+        }
+
+        return config.warmupFrames >= 0 && config.measuredFrames > 0 && config.width > 0 && config.height > 0;
+    }
+
+    BoundingBox ComputeSceneBounds(Scene& scene)
+    {
+        BoundingBox bounds;
+        for (auto& object : scene.GetObjects())
+        {
+            const BoundingBox& objectBounds = object->GetWorldBounds();
+            if (objectBounds.IsValid())
+                bounds.Expand(objectBounds);
+        }
+        if (!bounds.IsValid())
+            bounds = BoundingBox(glm::vec3(-1.0f), glm::vec3(1.0f));
+        return bounds;
+    }
+
+    // One full orbit around the scene over frameCount frames, looking down at elevationDegrees
+    void PlaceCamera(Camera& camera, const BoundingBox& sceneBounds, int frame, int frameCount, float elevationDegrees)
+    {
+        glm::vec3 center = sceneBounds.GetCenter();
+        float radius = std::max(glm::length(sceneBounds.GetExtents()) * 1.5f, 5.0f);
+        float angle = 2.0f * glm::pi<float>() * static_cast<float>(frame) / static_cast<float>(frameCount);
+        float elevation = glm::radians(elevationDegrees);
+
+        glm::vec3 offset(std::cos(angle) * std::cos(elevation), std::sin(elevation), std::sin(angle) * std::cos(elevation));
+        camera.SetPosition(center + offset * radius);
+        camera.LookAt(center);
+    }
+
+    json Summarize(std::vector<double> values)
+    {
+        json summary;
+        if (values.empty())
+            return summary;
+
+        std::sort(values.begin(), values.end());
+        auto percentile = [&values](double p) {
+            return values[static_cast<std::size_t>(p * static_cast<double>(values.size() - 1) + 0.5)];
+        };
+
+        double sum = 0.0;
+        for (double value : values)
+            sum += value;
+
+        summary["min"] = values.front();
+        summary["mean"] = sum / static_cast<double>(values.size());
+        summary["p50"] = percentile(0.50);
+        summary["p90"] = percentile(0.90);
+        summary["p95"] = percentile(0.95);
+        summary["p99"] = percentile(0.99);
+        summary["max"] = values.back();
+        return summary;
+    }
+
+    json RunMode(Renderer& renderer, Scene& scene, Camera& camera, GLFWwindow* window,
+                 const ModeInfo& modeInfo, const BenchConfig& config)
+    {
+        const BoundingBox sceneBounds = ComputeSceneBounds(scene);
+        renderer.SetRenderMode(modeInfo.mode);
+        renderer.SetGBufferLayout(modeInfo.gBufferLayout);
+        renderer.SetTiledLightingEnabled(modeInfo.tiledLighting);
+        renderer.SetClusterComputeEnabled(modeInfo.clusterCompute);
+        renderer.SetAdaptiveTessellationEnabled(modeInfo.adaptiveTessellation);
+        renderer.SetTessellationCacheEnabled(modeInfo.tessellationCache);
+        renderer.SetDepthPrepassEnabled(modeInfo.depthPrepass);
+        renderer.SetOcclusionCullingEnabled(modeInfo.occlusionCulling);
+
+        for (int frame = 0; frame < config.warmupFrames; frame++)
+        {
+            PlaceCamera(camera, sceneBounds, frame, config.warmupFrames, config.elevationDegrees);
+            renderer.BeginFrame();
+            renderer.Render(&scene, &camera);
+            renderer.EndFrame();
+            glfwSwapBuffers(window);
+        }
+        glFinish();
+
+        // Renderer falls back to Solid when a mode isn't available
+        if (renderer.GetRenderMode() != modeInfo.mode)
+        {
+            json skipped;
+            skipped["mode"] = modeInfo.name;
+            skipped["skipped"] = true;
+            return skipped;
+        }
+
+        // GPU frame time from timestamps around each frame, read back once after the run
+        std::vector<GLuint> timestampQueries(config.measuredFrames * 2);
+        glGenQueries(static_cast<GLsizei>(timestampQueries.size()), timestampQueries.data());
+        renderer.GetGpuProfiler().Reset();
+
+        std::vector<FrameSample> samples(config.measuredFrames);
+        for (int frame = 0; frame < config.measuredFrames; frame++)
+        {
+            PlaceCamera(camera, sceneBounds, frame, config.measuredFrames, config.elevationDegrees);
+
+            glQueryCounter(timestampQueries[frame * 2], GL_TIMESTAMP);
+            auto cpuStart = Clock::now();
+
+            renderer.BeginFrame();
+            renderer.Render(&scene, &camera);
+            renderer.EndFrame();
+
+            samples[frame].cpuMs = std::chrono::duration<double, std::milli>(Clock::now() - cpuStart).count();
+            samples[frame].stats = renderer.GetStats();
+            samples[frame].stateChanges = GLState::GetInstance()->GetStats();
+            samples[frame].renderScale = renderer.GetDynamicResolution().GetScale();
+            glQueryCounter(timestampQueries[frame * 2 + 1], GL_TIMESTAMP);
+
+            glfwSwapBuffers(window);
+        }
+        glFinish();
+
+        json frames = json::array();
+        std::vector<double> cpuTimes, gpuTimes, drawCalls, triangles, tessellatedPrimitives;
+        for (int frame = 0; frame < config.measuredFrames; frame++)
+        {
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(timestampQueries[frame * 2], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(timestampQueries[frame * 2 + 1], GL_QUERY_RESULT, &end);
+
+            FrameSample& sample = samples[frame];
+            sample.gpuMs = static_cast<double>(end - begin) / 1.0e6;
+
+            cpuTimes.push_back(sample.cpuMs);
+            gpuTimes.push_back(sample.gpuMs);
+            drawCalls.push_back(sample.stats.drawCalls);
+            triangles.push_back(static_cast<double>(sample.stats.triangles));
+            if (sample.stats.tessellatedPrimitives >= 0)
+                tessellatedPrimitives.push_back(static_cast<double>(sample.stats.tessellatedPrimitives));
+
+            json frameJson;
+            frameJson["cpuMs"] = sample.cpuMs;
+            frameJson["gpuMs"] = sample.gpuMs;
+            frameJson["drawCalls"] = sample.stats.drawCalls;
+            frameJson["triangles"] = sample.stats.triangles;
+            frameJson["tessellatedPrimitives"] = sample.stats.tessellatedPrimitives;
+            frameJson["visibleObjects"] = sample.stats.visibleObjects;
+            frameJson["culledObjects"] = sample.stats.culledObjects;
+            frameJson["occludedObjects"] = sample.stats.occludedObjects;
+            frameJson["stateChangesIssued"] = sample.stateChanges.issued;
+            frameJson["stateChangesSkipped"] = sample.stateChanges.skipped;
+            frameJson["renderScale"] = sample.renderScale;
+            frames.push_back(frameJson);
+        }
+        glDeleteQueries(static_cast<GLsizei>(timestampQueries.size()), timestampQueries.data());
+
+        json passes = json::array();
+        for (const auto& pass : renderer.GetGpuProfiler().GetPassStats())
+        {
+            if (pass.samples == 0)
+                continue;
+
+            json passJson;
+            passJson["name"] = pass.name;
+            passJson["minMs"] = pass.minMs;
+            passJson["avgMs"] = pass.avgMs;
+            passJson["p99Ms"] = pass.p99Ms;
+            passJson["samples"] = pass.samples;
+            passes.push_back(passJson);
+        }
+
+        json result;
+        result["mode"] = modeInfo.name;
+        result["cpuMs"] = Summarize(cpuTimes);
+        result["gpuMs"] = Summarize(gpuTimes);
+        result["drawCalls"] = Summarize(drawCalls);
+        result["triangles"] = Summarize(triangles);
+        if (!tessellatedPrimitives.empty())
+            result["tessellatedPrimitives"] = Summarize(tessellatedPrimitives);
+        result["gpuPasses"] = passes;
+        result["frames"] = frames;
+        return result;
+    }
+
+    std::string GetGLString(GLenum name)
+    {
+        const GLubyte* value = glGetString(name);
+        return value ? reinterpret_cast<const char*>(value) : "";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    BenchConfig config;
+    if (!ParseArguments(argc, argv, config))
+    {
+        std::cerr << "Usage: OpenGLLearningBench [--scene file.json]... [--warmup N] [--frames N] "
+                     "[--width W] [--height H] [--output results.json] [--target-ms T] "
+                     "[--vertex-format compact|float] [--elevation degrees] [--front-to-back on|off]" << std::endl;
+        return 1;
+    }
+
+    GLFWwindow* window = CreateOffscreenContext(config.width, config.height, "OpenGLLearningBench");
+    if (!window)
+    {
+        std::cerr << "Failed to create an offscreen OpenGL 4.1 context" << std::endl;
+        return 1;
+    }
+
+    int runResult = 0;
+    {
+        Renderer renderer;
+        if (!renderer.Initialize())
+        {
+            std::cerr << "Failed to initialize renderer" << std::endl;
+            glfwDestroyWindow(window);
+            glfwTerminate();
+            return 1;
+        }
+
+        int framebufferWidth = config.width, framebufferHeight = config.height;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        renderer.SetDisplaySize(framebufferWidth, framebufferHeight);
+
+        // Meshes pick their vertex layout when the scenes upload them
+        Mesh::SetCompactVerticesEnabled(config.compactVertices);
+        renderer.SetFrontToBackEnabled(config.frontToBack);
+
+        if (config.targetFrameMs > 0.0f)
+        {
+            renderer.GetDynamicResolution().SetTargetFrameMs(config.targetFrameMs);
+            renderer.GetDynamicResolution().SetEnabled(true);
+        }
+
+        ResourceManager::GetInstance()->LoadAllShadersFromDirectory("resources/shaders");
+
+        json output;
+        output["device"]["vendor"] = GetGLString(GL_VENDOR);
+        output["device"]["renderer"] = GetGLString(GL_RENDERER);
+        output["device"]["version"] = GetGLString(GL_VERSION);
+        output["config"]["warmupFrames"] = config.warmupFrames;
+        output["config"]["measuredFrames"] = config.measuredFrames;
+        output["config"]["width"] = framebufferWidth;
+        output["config"]["height"] = framebufferHeight;
+        output["config"]["targetFrameMs"] = config.targetFrameMs;
+        output["config"]["vertexFormat"] = config.compactVertices ? "compact" : "float";
+        output["config"]["elevationDegrees"] = config.elevationDegrees;
+        output["config"]["frontToBack"] = config.frontToBack;
+        output["results"] = json::array();
+
+        std::cout << "Benchmarking on " << GetGLString(GL_RENDERER) << " (" << GetGLString(GL_VERSION) << ")" << std::endl;
+
+        for (const std::string& scenePath : config.scenes)
+        {
+            Scene scene;
+            if (!scene.LoadFromFile(scenePath))
+            {
+                std::cerr << "Failed to load benchmark scene: " << scenePath << std::endl;
+                runResult = 1;
+                continue;
+            }
+
+            Camera camera(45.0f, static_cast<float>(framebufferWidth) / static_cast<float>(framebufferHeight), 0.1f, 1000.0f);
+
+            json sceneResult;
+            sceneResult["scene"] = scenePath;
+            sceneResult["objects"] = scene.GetObjects().size();
+            sceneResult["modes"] = json::array();
+
+            for (const ModeInfo& modeInfo : BENCH_MODES)
+            {
+                json modeResult = RunMode(renderer, scene, camera, window, modeInfo, config);
+                if (!modeResult.contains("skipped"))
+                {
+                    std::cout << "  " << scenePath << " [" << modeInfo.name << "] cpu p50 "
+                              << modeResult["cpuMs"]["p50"].get<double>() << " ms, gpu p50 "
+                              << modeResult["gpuMs"]["p50"].get<double>() << " ms, "
+                              << modeResult["drawCalls"]["mean"].get<double>() << " draw calls" << std::endl;
+                }
+                sceneResult["modes"].push_back(modeResult);
+            }
+
+            output["results"].push_back(sceneResult);
+        }
+
+        std::ofstream file(config.outputPath);
+        if (file.is_open())
+        {
+            file << output.dump(4);
+            std::cout << "Results written to " << config.outputPath << std::endl;
+        }
+        else
+        {
+            std::cerr << "Failed to open file for writing results: " << config.outputPath << std::endl;
+            runResult = 1;
+        }
+
+        ResourceManager::GetInstance()->ReleaseAllShaders();
+        ResourceManager::GetInstance()->ReleaseAllModels();
+        renderer.Shutdown();
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return runResult;
+}
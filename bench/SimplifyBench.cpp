@@ -0,0 +1,110 @@
+// CPU-only benchmark for MeshSimplifier. Builds the LOD chain of every mesh of an OBJ file, once
+// on the calling thread and once spread over the ThreadPool like Model does at load time, and
+// reports simplification throughput. Without a file it generates a set of dense wavy grids.
+//
+// Usage: SimplifyBench [file.obj] [lodCount]
+
+#include "MeshSimplifier.h"
+#include "ThreadPool.h"
+#include "BenchMeshes.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::high_resolution_clock;
+
+    double ElapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int lodCount = argc > 2 ? std::atoi(argv[2]) : 4;
+    if (lodCount <= 0)
+    {
+        std::cerr << "Usage: SimplifyBench [file.obj] [lodCount]" << std::endl;
+        return 1;
+    }
+
+    std::vector<BenchMesh> meshes;
+    if (argc > 1)
+    {
+        if (!LoadObj(argv[1], meshes))
+            return 1;
+    }
+    else
+    {
+        for (int i = 0; i < 8; i++)
+            meshes.push_back(CreateWavyGrid(384, static_cast<float>(i)));
+    }
+
+    std::size_t totalTriangles = 0;
+    for (const BenchMesh& mesh : meshes)
+        totalTriangles += mesh.indices.size() / 3;
+
+    std::cout << "MeshSimplifier benchmark: " << meshes.size() << " meshes, " << totalTriangles << " triangles, "
+              << lodCount << " LODs" << std::endl;
+
+    // Single mesh, single level: the raw cost of one Simplify call
+    const BenchMesh& largest = *std::max_element(meshes.begin(), meshes.end(), [](const BenchMesh& a, const BenchMesh& b) {
+        return a.indices.size() < b.indices.size();
+    });
+    float error = 0.0f;
+    auto start = Clock::now();
+    std::vector<unsigned int> half = MeshSimplifier::Simplify(largest.vertices, largest.indices, largest.indices.size() / 6 * 3,
+                                                              std::numeric_limits<float>::max(), &error);
+    double simplifyMs = ElapsedMs(start);
+    std::cout << "  simplify:     " << simplifyMs << " ms, " << largest.indices.size() / 3 << " -> " << half.size() / 3
+              << " triangles (" << (largest.indices.size() / 3) / (simplifyMs * 1000.0) << " M input tris/s), error " << error << std::endl;
+
+    // Whole chains on this thread
+    std::vector<std::vector<MeshSimplifier::Lod>> chains(meshes.size());
+    start = Clock::now();
+    for (std::size_t i = 0; i < meshes.size(); i++)
+        chains[i] = MeshSimplifier::BuildLodChain(meshes[i].vertices, meshes[i].indices, lodCount);
+    double serialMs = ElapsedMs(start);
+    std::cout << "  serial:       " << serialMs << " ms (" << totalTriangles / (serialMs * 1000.0) << " M input tris/s)" << std::endl;
+
+    // Same chains on the workers, one mesh per task like Model::GenerateLods
+    std::vector<std::vector<MeshSimplifier::Lod>> parallelChains(meshes.size());
+    start = Clock::now();
+    ThreadPool::GetInstance()->ParallelFor(meshes.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++)
+            parallelChains[i] = MeshSimplifier::BuildLodChain(meshes[i].vertices, meshes[i].indices, lodCount);
+    });
+    double parallelMs = ElapsedMs(start);
+    std::cout << "  parallel:     " << parallelMs << " ms (" << totalTriangles / (parallelMs * 1000.0) << " M input tris/s, "
+              << serialMs / parallelMs << "x)" << std::endl;
+
+    // The simplifier is deterministic, both runs must agree
+    for (std::size_t i = 0; i < meshes.size(); i++)
+    {
+        bool match = chains[i].size() == parallelChains[i].size();
+        for (std::size_t level = 0; match && level < chains[i].size(); level++)
+            match = chains[i][level].indices == parallelChains[i][level].indices;
+        if (!match)
+        {
+            std::cerr << "Serial and parallel chains differ for mesh " << i << std::endl;
+            return 1;
+        }
+    }
+
+    std::size_t largestIndex = static_cast<std::size_t>(&largest - meshes.data());
+    std::cout << "  chain of " << largest.name << ":" << std::endl;
+    std::cout << "    LOD 0: " << largest.indices.size() / 3 << " triangles" << std::endl;
+    for (std::size_t level = 0; level < chains[largestIndex].size(); level++)
+    {
+        const MeshSimplifier::Lod& lod = chains[largestIndex][level];
+        std::cout << "    LOD " << level + 1 << ": " << lod.indices.size() / 3 << " triangles, error " << lod.error << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,166 @@
+// Microbenchmark for Shader uniform setters: string names against pre-hashed UniformIds.
+// Counts heap allocations made inside the timed loops by replacing the global operator new.
+// Needs an OpenGL context, see BenchContext.h.
+//
+// Usage: UniformBench [iterations]
+
+#include "BenchContext.h"
+#include "Shader.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+namespace {
+    std::atomic<std::size_t> allocationCount{0};
+}
+
+void* operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace {
+    using Clock = std::chrono::high_resolution_clock;
+
+    const char* VERTEX_SOURCE = R"(#version 410 core
+layout (location = 0) in vec3 aPos;
+uniform mat4 model;
+uniform float time;
+out vec3 Color;
+
+struct Material {
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    float shininess;
+};
+uniform Material material;
+
+void main()
+{
+    Color = material.ambient + material.diffuse + material.specular * material.shininess * time;
+    gl_Position = model * vec4(aPos, 1.0);
+}
+)";
+
+    const char* FRAGMENT_SOURCE = R"(#version 410 core
+in vec3 Color;
+out vec4 FragColor;
+void main()
+{
+    FragColor = vec4(Color, 1.0);
+}
+)";
+
+    constexpr UniformId UNIFORM_MODEL("model");
+    constexpr UniformId UNIFORM_TIME("time");
+    constexpr UniformId UNIFORM_MATERIAL_AMBIENT("material.ambient");
+    constexpr UniformId UNIFORM_MATERIAL_DIFFUSE("material.diffuse");
+    constexpr UniformId UNIFORM_MATERIAL_SPECULAR("material.specular");
+    constexpr UniformId UNIFORM_MATERIAL_SHININESS("material.shininess");
+
+    constexpr int UNIFORMS_PER_ITERATION = 6;
+
+    struct RunResult {
+        double nsPerSet = 0.0;
+        double allocationsPerSet = 0.0;
+    };
+
+    template <typename Body>
+    RunResult Measure(int iterations, Body body)
+    {
+        std::size_t allocationsBefore = allocationCount.load();
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; i++)
+            body(static_cast<float>(i));
+        double elapsedNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        std::size_t allocations = allocationCount.load() - allocationsBefore;
+
+        double sets = static_cast<double>(iterations) * UNIFORMS_PER_ITERATION;
+        return { elapsedNs / sets, static_cast<double>(allocations) / sets };
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    if (iterations <= 0)
+    {
+        std::cerr << "Usage: UniformBench [iterations]" << std::endl;
+        return 1;
+    }
+
+    GLFWwindow* window = CreateOffscreenContext(64, 64, "UniformBench");
+    if (!window)
+    {
+        std::cerr << "Failed to create an offscreen OpenGL 4.1 context" << std::endl;
+        return 1;
+    }
+
+    int result = 0;
+    {
+        Shader shader;
+        shader.SetName("uniform_bench");
+        if (!shader.LoadFromSource(VERTEX_SOURCE, FRAGMENT_SOURCE))
+        {
+            std::cerr << "Failed to compile benchmark shader" << std::endl;
+            glfwDestroyWindow(window);
+            glfwTerminate();
+            return 1;
+        }
+        shader.Use();
+
+        glm::mat4 model(1.0f);
+        glm::vec3 color(0.5f);
+
+        RunResult byName = Measure(iterations, [&](float value) {
+            model[3][0] = value;
+            shader.SetMat4("model", model);
+            shader.SetFloat("time", value);
+            shader.SetVec3("material.ambient", color);
+            shader.SetVec3("material.diffuse", color);
+            shader.SetVec3("material.specular", color);
+            shader.SetFloat("material.shininess", value);
+        });
+
+        RunResult byId = Measure(iterations, [&](float value) {
+            model[3][0] = value;
+            shader.SetMat4(UNIFORM_MODEL, model);
+            shader.SetFloat(UNIFORM_TIME, value);
+            shader.SetVec3(UNIFORM_MATERIAL_AMBIENT, color);
+            shader.SetVec3(UNIFORM_MATERIAL_DIFFUSE, color);
+            shader.SetVec3(UNIFORM_MATERIAL_SPECULAR, color);
+            shader.SetFloat(UNIFORM_MATERIAL_SHININESS, value);
+        });
+        glFinish();
+
+        std::cout << "Uniform setters, " << iterations << " iterations x " << UNIFORMS_PER_ITERATION << " uniforms" << std::endl;
+        std::cout << "  std::string name: " << byName.nsPerSet << " ns/set, " << byName.allocationsPerSet << " allocations/set" << std::endl;
+        std::cout << "  UniformId:        " << byId.nsPerSet << " ns/set, " << byId.allocationsPerSet << " allocations/set" << std::endl;
+
+        if (byId.allocationsPerSet != 0.0)
+        {
+            std::cerr << "UniformId setters allocated memory in the hot loop" << std::endl;
+            result = 1;
+        }
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return result;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+#include "Bounds.h"
+
+// Dynamic AABB tree (in the style of Box2D's b2DynamicTree).
+// Leaves store "fat" boxes enlarged by a margin so that small movements don't touch the tree;
+// the tree is kept balanced with AVL-style rotations on insert/remove.
+// Queries return the user data of every leaf whose fat box passes the test, callers
+// refine the result against tight bounds if they need to. Not thread-safe.
+class DynamicBVH {
+public:
+    static constexpr int NullNode = -1;
+
+    struct RayHit {
+        void* userData = nullptr;
+        float distance = 0.0f;
+    };
+
+    explicit DynamicBVH(float margin = 0.1f);
+
+    // Returns a proxy id that stays valid until DestroyProxy
+    int CreateProxy(const BoundingBox& box, void* userData);
+    void DestroyProxy(int proxyId);
+
+    // Refits a proxy after its object moved. Returns true if the leaf was reinserted,
+    // false if the new box still fits inside the fat box.
+    bool MoveProxy(int proxyId, const BoundingBox& box);
+
+    void Clear();
+
+    void* GetUserData(int proxyId) const { return links[proxyId].userData; }
+    const BoundingBox& GetFatBounds(int proxyId) const { return nodes[proxyId].box; }
+
+    void QueryFrustum(const Frustum& frustum, std::vector<void*>& results) const;
+    void QueryBox(const BoundingBox& box, std::vector<void*>& results) const;
+    void QuerySphere(const BoundingSphere& sphere, std::vector<void*>& results) const;
+
+    // Leaves hit by the ray within maxDistance, sorted by entry distance
+    void QueryRay(const Ray& ray, float maxDistance, std::vector<RayHit>& results) const;
+
+    int GetProxyCount() const { return proxyCount; }
+    int GetHeight() const { return root == NullNode ? 0 : links[root].height; }
+
+    // Sum of internal node areas over the root area, a measure of tree quality (lower is better)
+    float GetAreaRatio() const;
+
+private:
+    // What traversals read, 32 bytes so a node never straddles two cache lines
+    struct alignas(32) Node {
+        BoundingBox box;
+        int child1 = NullNode;
+        int child2 = NullNode;
+
+        bool IsLeaf() const { return child1 == NullNode; }
+    };
+
+    // The rest of a node, only touched by tree updates and for the results of a query
+    struct NodeLinks {
+        void* userData = nullptr;
+        int parent = NullNode;      // next free node while on the free list
+        int height = -1;            // leaf = 0, free node = -1
+    };
+
+    std::vector<Node> nodes;
+    std::vector<NodeLinks> links;
+    int root = NullNode;
+    int freeList = NullNode;
+    int proxyCount = 0;
+    float margin;
+
+    // Traversal stack and breadth-first frustum queue (node, planes still straddled), reused across queries
+    mutable std::vector<int> stack;
+    mutable std::vector<std::pair<int, unsigned int>> frustumQueue;
+
+    int AllocateNode();
+    void FreeNode(int nodeId);
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    int Balance(int nodeId);
+};
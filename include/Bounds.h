@@ -0,0 +1,71 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <limits>
+#include <vector>
+
+struct Vertex;
+
+struct Ray {
+    glm::vec3 origin = glm::vec3(0.0f);
+    glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+};
+
+// Axis-aligned bounding box. A default constructed box is empty (min > max).
+struct BoundingBox {
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+    BoundingBox() = default;
+    BoundingBox(const glm::vec3& min, const glm::vec3& max) : min(min), max(max) {}
+
+    bool IsValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+    glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+    glm::vec3 GetExtents() const { return (max - min) * 0.5f; }
+    float GetSurfaceArea() const;
+
+    void Expand(const glm::vec3& point);
+    void Expand(const BoundingBox& other);
+
+    bool Contains(const BoundingBox& other) const;
+    bool Intersects(const BoundingBox& other) const;
+
+    // Slab test. On a hit, distance is where the ray enters the box (0 when starting inside).
+    bool IntersectsRay(const Ray& ray, float maxDistance, float& distance) const;
+
+    // Conservative box around this box after an affine transform
+    BoundingBox Transformed(const glm::mat4& transform) const;
+
+    static BoundingBox FromVertices(const std::vector<Vertex>& vertices);
+};
+
+struct BoundingSphere {
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = -1.0f;
+
+    bool IsValid() const { return radius >= 0.0f; }
+    bool Intersects(const BoundingBox& box) const;
+
+    // Sphere centred on the box, tight around the given vertices
+    static BoundingSphere FromVertices(const std::vector<Vertex>& vertices, const BoundingBox& box);
+};
+
+// Six inward-facing planes (xyz = normal, w = distance) extracted from a view-projection matrix
+class Frustum {
+public:
+    enum Plane { Left = 0, Right, Bottom, Top, Near, Far, PlaneCount };
+
+    Frustum() = default;
+    explicit Frustum(const glm::mat4& viewProjection);
+
+    void Update(const glm::mat4& viewProjection);
+
+    bool Intersects(const BoundingSphere& sphere) const;
+    bool Intersects(const BoundingBox& box) const;
+
+    const glm::vec4& GetPlane(int index) const { return planes[index]; }
+
+private:
+    // All-zero planes accept everything until Update is called
+    glm::vec4 planes[PlaneCount] = {};
+};
@@ -19,6 +19,9 @@ public:
     void SetPosition(const glm::vec3& newPosition) { position = newPosition; UpdateViewMatrix(); }
     glm::vec3 GetPosition() const { return position; }
 
+    // Turns the camera towards target, keeping the world up axis
+    void LookAt(const glm::vec3& target);
+
     void SetFOV(float newFov) { fov = newFov; UpdateProjectionMatrix(); }
     float GetFOV() const { return fov; }
 
@@ -43,6 +46,7 @@ public:
 private:
     void UpdateViewMatrix();
     void UpdateProjectionMatrix();
+    void UpdateCameraVectors();
 
     // Camera position and orientation
     glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f);
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "TextureBuffer.h"
+
+struct Light;
+class Shader;
+
+// Light clusters for the clustered forward path. The view frustum is split into a
+// CLUSTERS_X x CLUSTERS_Y grid of screen tiles and CLUSTERS_Z depth slices spaced exponentially
+// between the near and far planes; each light is assigned to the clusters its range touches.
+// Forward shaders compiled with CLUSTERED_LIGHTING (resources/shaders/include/lights.glsl) then
+// only loop over the lights of their fragment's cluster.
+//
+// Assignment runs in a compute shader on GL 4.3+ contexts and on the ThreadPool otherwise.
+class ClusterGrid {
+public:
+    static constexpr int CLUSTERS_X = 16;
+    static constexpr int CLUSTERS_Y = 9;
+    static constexpr int CLUSTERS_Z = 24;
+    static constexpr int CLUSTER_COUNT = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+
+    // Lights kept per cluster by the compute path, which writes into fixed-size slots
+    static constexpr int MAX_GPU_LIGHTS_PER_CLUSTER = 128;
+
+    struct Stats {
+        int lights = 0;
+        int clusters = CLUSTER_COUNT;
+        // Only known for CPU assignment, the compute path never reads its lists back
+        int activeClusters = 0;
+        int maxLightsPerCluster = 0;
+        float avgLightsPerActiveCluster = 0.0f;
+        bool computeAssignment = false;
+    };
+
+    ClusterGrid();
+    ~ClusterGrid();
+
+    bool Initialize();
+    void Shutdown();
+
+    // The compute path is used whenever it's supported and enabled
+    bool IsComputeSupported() const { return computeShader != nullptr; }
+    void SetComputeEnabled(bool enable) { computeEnabled = enable; }
+    bool IsComputeEnabled() const { return computeEnabled; }
+
+    // Assigns the lights to the clusters of a width x height target seen through view/projection
+    void Build(const std::vector<Light>& lights, const glm::mat4& view, const glm::mat4& projection,
+               float nearPlane, float farPlane, int width, int height);
+
+    // Binds the three buffer textures from firstUnit on and sets the cluster uniforms
+    void Bind(Shader* shader, GLuint firstUnit);
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    // View-space sphere of a light and the cluster box its screen and depth bounds cover
+    struct LightBounds {
+        glm::vec4 sphere;
+        glm::ivec2 minTile;
+        glm::ivec2 maxTile;
+        int minSlice;
+        int maxSlice;
+    };
+
+    TextureBuffer lightBuffer;      // RGBA32F, two texels per light: position + range, color + intensity
+    TextureBuffer rangeBuffer;      // RG32UI, offset and count into the index list per cluster
+    TextureBuffer indexBuffer;      // R32UI, light indices grouped by cluster
+    TextureBuffer boundsBuffer;     // RGBA32F, view-space AABB min and max per cluster (compute path)
+
+    std::unique_ptr<Shader> computeShader;
+    bool computeEnabled = true;
+
+    // Cluster geometry, recomputed when the projection or target size changes
+    glm::mat4 clusterProjection = glm::mat4(0.0f);
+    float clusterNear = 0.0f;
+    float clusterFar = 0.0f;
+    int targetWidth = 0;
+    int targetHeight = 0;
+    glm::vec2 tileSize = glm::vec2(1.0f);
+    glm::vec2 depthParams = glm::vec2(0.0f);
+    std::vector<glm::vec4> clusterBounds;
+    bool boundsUploaded = false;
+
+    // Rebuilt every frame, kept between frames so assignment doesn't allocate
+    std::vector<glm::vec4> lightTexels;
+    std::vector<LightBounds> lightBounds;
+    std::vector<std::vector<std::uint32_t>> sliceLights;
+    std::vector<std::vector<glm::uvec2>> sliceRanges;
+    std::vector<std::vector<std::uint32_t>> sliceIndices;
+    std::vector<glm::uvec2> clusterRanges;
+    std::vector<std::uint32_t> clusterIndices;
+
+    Stats stats;
+    bool initialized = false;
+
+    void UpdateClusterBounds(const glm::mat4& projection, float nearPlane, float farPlane, int width, int height);
+    void ComputeLightBounds(const std::vector<Light>& lights, const glm::mat4& view);
+    void AssignOnCpu();
+    void AssignOnGpu(const glm::mat4& view);
+    void AssignSlice(int slice);
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+// Picks the internal render resolution scale that keeps the measured GPU frame time under a
+// target. Shading cost grows with the pixel count, so the scale follows the square root of the
+// time ratio. It moves in SCALE_STEP increments, drops only after several frames over budget and
+// climbs back one step at a time after a longer stretch under it, so targets aren't rebuilt
+// every frame and the scale doesn't oscillate around the budget.
+class DynamicResolution {
+public:
+    static constexpr float SCALE_STEP = 0.05f;
+
+    void SetEnabled(bool enable);
+    bool IsEnabled() const { return enabled; }
+
+    void SetTargetFrameMs(float milliseconds) { targetFrameMs = milliseconds; }
+    float GetTargetFrameMs() const { return targetFrameMs; }
+
+    void SetScaleRange(float minimum, float maximum);
+    float GetMinScale() const { return minScale; }
+    float GetMaxScale() const { return maxScale; }
+
+    // Feeds the GPU time of a finished frame, returns true when the scale changed
+    bool Update(float gpuFrameMs);
+
+    // Scale of the render resolution relative to the display, 1 while disabled
+    float GetScale() const { return enabled ? scale : 1.0f; }
+    float GetSmoothedFrameMs() const { return smoothedFrameMs; }
+
+private:
+    static constexpr int FRAMES_BEFORE_DOWNSCALE = 4;
+    static constexpr int FRAMES_BEFORE_UPSCALE = 45;
+    // Fraction of the budget the frame has to fit in before the scale goes back up
+    static constexpr float UPSCALE_HEADROOM = 0.8f;
+
+    bool enabled = false;
+    float targetFrameMs = 1000.0f / 60.0f;
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    float scale = 1.0f;
+    float smoothedFrameMs = 0.0f;
+    int framesOverBudget = 0;
+    int framesUnderBudget = 0;
+
+    void SetScale(float newScale);
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// State changes since the last ResetStats
+struct GLStateStats {
+    int issued = 0;
+    int skipped = 0;
+};
+
+// Shadow copy of the OpenGL state the engine touches. Everything binds and enables through it,
+// so changes to the current value never reach the driver. Code that changes state behind its
+// back (ImGui) must be followed by Invalidate.
+class GLState {
+public:
+    static GLState* GetInstance();
+
+    // Detects direct state access (core in GL 4.5), needs a current context
+    void Initialize();
+
+    // Forgets every cached value, the next change of each kind is always issued
+    void Invalidate();
+
+    void UseProgram(GLuint program);
+    void BindVertexArray(GLuint vertexArray);
+
+    // Cached for GL_ARRAY_BUFFER and GL_UNIFORM_BUFFER; other targets are passed through.
+    // GL_ELEMENT_ARRAY_BUFFER is part of the vertex array state and never cached.
+    void BindBuffer(GLenum target, GLuint buffer);
+    void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+    // With DSA this may leave another unit active, so texture edits must bind with BindTextureForEditing
+    void BindTexture(GLuint unit, GLenum target, GLuint texture);
+    // Binds on unit 0 and makes it the active unit, for glTexImage2D, glTexParameteri and glTexBuffer
+    void BindTextureForEditing(GLenum target, GLuint texture);
+    void BindFramebuffer(GLuint framebuffer);
+
+    void SetEnabled(GLenum capability, bool enabled);
+    void BlendFunc(GLenum source, GLenum destination);
+    void BlendColor(float red, float green, float blue, float alpha);
+    void DepthMask(bool write);
+    // All four channels together
+    void ColorMask(bool write);
+    void DepthFunc(GLenum function);
+    void PolygonMode(GLenum mode);
+    void Viewport(int x, int y, int width, int height);
+
+    // Creates a buffer object that the DSA upload paths can use before it was ever bound
+    GLuint CreateBuffer();
+
+    // Buffer uploads. With DSA they leave the bindings alone, otherwise the buffer is bound to target.
+    void BufferData(GLenum target, GLuint buffer, GLsizeiptr size, const void* data, GLenum usage);
+    void BufferSubData(GLenum target, GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data);
+
+    // Deleted names can be recycled by the driver, so they must not stay cached as bound
+    void OnProgramDeleted(GLuint program);
+    void OnVertexArrayDeleted(GLuint vertexArray);
+    void OnBufferDeleted(GLuint buffer);
+    void OnTextureDeleted(GLuint texture);
+    void OnFramebufferDeleted(GLuint framebuffer);
+
+    bool HasDirectStateAccess() const { return directStateAccess; }
+
+    const GLStateStats& GetStats() const { return stats; }
+    void ResetStats() { stats = GLStateStats(); }
+
+private:
+    GLState();
+
+    static constexpr GLuint UNKNOWN = 0xFFFFFFFFu;
+    static constexpr int MAX_TEXTURE_UNITS = 16;
+
+    enum BufferSlot { ArrayBufferSlot, UniformBufferSlot, BufferSlotCount };
+    enum CapabilitySlot { BlendSlot, DepthTestSlot, CullFaceSlot, MultisampleSlot, ScissorTestSlot, StencilTestSlot, CapabilitySlotCount };
+
+    struct TextureBinding {
+        GLenum target = 0;
+        GLuint texture = UNKNOWN;
+    };
+
+    GLuint program = UNKNOWN;
+    GLuint vertexArray = UNKNOWN;
+    GLuint framebuffer = UNKNOWN;
+    GLuint buffers[BufferSlotCount] = {};
+    GLuint activeTextureUnit = UNKNOWN;
+    TextureBinding textures[MAX_TEXTURE_UNITS];
+
+    // -1 unknown, 0 disabled, 1 enabled
+    signed char capabilities[CapabilitySlotCount] = {};
+    GLenum blendSource = 0;
+    GLenum blendDestination = 0;
+    float blendColor[4] = {};
+    bool blendColorKnown = false;
+    signed char depthMask = -1;
+    signed char colorMask = -1;
+    GLenum depthFunction = 0;
+    GLenum polygonMode = 0;
+    int viewport[4] = {};
+    bool viewportKnown = false;
+
+    bool directStateAccess = false;
+    GLStateStats stats;
+
+    static int GetBufferSlot(GLenum target);
+    static int GetCapabilitySlot(GLenum capability);
+    void SetActiveTextureUnit(GLuint unit);
+    bool Changed(bool changed);
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Per-pass GPU timings from GL_TIME_ELAPSED queries.
+// Every pass owns FRAME_LATENCY query objects used round-robin; results are collected
+// FRAME_LATENCY - 1 frames later, and only once GL reports them available, so reading
+// them never stalls the CPU. Time elapsed queries can't nest, so passes must not overlap.
+class GpuProfiler {
+public:
+    static constexpr int FRAME_LATENCY = 3;
+    static constexpr int HISTORY_SIZE = 240;
+
+    struct PassStats {
+        std::string name;
+        float lastMs = 0.0f;
+        float minMs = 0.0f;
+        float avgMs = 0.0f;
+        float p99Ms = 0.0f;
+        int samples = 0;
+    };
+
+    GpuProfiler() = default;
+    ~GpuProfiler();
+
+    bool Initialize();
+    void Shutdown();
+
+    // Drops all collected timings and in-flight results, keeping the query objects
+    void Reset();
+
+    // Collects finished queries and starts a new frame
+    void BeginFrame();
+
+    void BeginPass(const char* name);
+    void EndPass();
+
+    // Rolling statistics over the last HISTORY_SIZE results of each pass
+    const std::vector<PassStats>& GetPassStats();
+
+    // Writes the statistics and raw samples of every pass as JSON
+    bool DumpToFile(const std::string& filepath);
+
+    bool IsSupported() const { return supported; }
+
+    // Sum of the newest result of every pass collected by the last BeginFrame, roughly the GPU time
+    // of a frame FRAME_LATENCY - 1 frames ago; 0 when that BeginFrame collected nothing
+    float GetLastFrameMs() const { return lastFrameMs; }
+
+    void SetEnabled(bool enable) { enabled = enable; }
+    bool IsEnabled() const { return enabled; }
+
+private:
+    struct PassTimer {
+        std::string name;
+        unsigned int queries[FRAME_LATENCY] = {};
+        bool pending[FRAME_LATENCY] = {};
+        unsigned long long lastFrame = ~0ull;
+
+        float history[HISTORY_SIZE] = {};
+        int historyCount = 0;
+        int historyIndex = 0;
+    };
+
+    std::vector<PassTimer> passes;
+    std::vector<PassStats> passStats;
+    std::vector<float> sortScratch;
+
+    unsigned long long frameNumber = 0;
+    float lastFrameMs = 0.0f;
+    int activePass = -1;
+    bool supported = false;
+    bool enabled = true;
+
+    int FindOrCreatePass(const char* name);
+    // Returns the newest collected time in ms, or a negative value if nothing was ready
+    float CollectResults(PassTimer& pass);
+};
+
+// Times the enclosing scope as one GPU pass
+class GpuPassScope {
+public:
+    GpuPassScope(GpuProfiler& profiler, const char* name) : profiler(profiler) { profiler.BeginPass(name); }
+    ~GpuPassScope() { profiler.EndPass(); }
+
+    GpuPassScope(const GpuPassScope&) = delete;
+    GpuPassScope& operator=(const GpuPassScope&) = delete;
+
+private:
+    GpuProfiler& profiler;
+};
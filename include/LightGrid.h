@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "TextureBuffer.h"
+#include <cstdint>
+#include <vector>
+
+struct Light;
+class Shader;
+
+// Screen-space light culling for the tiled deferred path. Every frame the lights' bounding
+// spheres are projected on the CPU and binned into TILE_SIZE x TILE_SIZE pixel tiles; the
+// lighting shader then only loops over the lights touching its tile. Lights and the per-tile
+// index lists are read from buffer textures, so the light count isn't limited by a uniform block.
+class LightGrid {
+public:
+    static constexpr int TILE_SIZE = 16;
+
+    struct Stats {
+        int lights = 0;
+        int tiles = 0;
+        int maxLightsPerTile = 0;
+        float avgLightsPerTile = 0.0f;
+    };
+
+    LightGrid() = default;
+    ~LightGrid();
+
+    bool Initialize();
+    void Shutdown();
+
+    // Bins the lights into the tiles of a width x height target as seen through view/projection
+    void Build(const std::vector<Light>& lights, const glm::mat4& view, const glm::mat4& projection, int width, int height);
+
+    // Uploads the last Build and binds the three buffer textures from firstUnit on
+    void Upload();
+    void Bind(Shader* shader, GLuint firstUnit);
+
+    const Stats& GetStats() const { return stats; }
+
+    // Conservative NDC rectangle of a view-space sphere, clamped to the screen. False when it's
+    // off screen or behind the near plane; spheres crossing the near plane cover the whole screen.
+    static bool GetScreenBounds(const glm::vec3& viewCenter, float radius, const glm::mat4& projection,
+                                float nearPlane, glm::vec2& ndcMin, glm::vec2& ndcMax);
+
+private:
+    TextureBuffer lightBuffer;     // RGBA32F, two texels per light: position + range, color + intensity
+    TextureBuffer tileBuffer;      // RG32UI, offset and count into the index list per tile
+    TextureBuffer indexBuffer;     // R32UI, light indices grouped by tile
+
+    int tilesX = 0;
+    int tilesY = 0;
+
+    // Rebuilt every frame, kept between frames so binning doesn't allocate
+    std::vector<glm::vec4> lightTexels;
+    std::vector<glm::ivec4> lightRects;
+    std::vector<glm::uvec2> tileRanges;
+    std::vector<std::uint32_t> tileIndices;
+
+    Stats stats;
+    bool initialized = false;
+};
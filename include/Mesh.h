@@ -1,13 +1,30 @@
 #pragma once
 
 #include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <glm/glm.hpp>
+#include "Vertex.h"
+#include "Bounds.h"
+#include "MeshSimplifier.h"
 
-struct Vertex {
-    glm::vec3 position;
-    glm::vec3 normal;
-    glm::vec2 texCoords;
+// Per-instance attributes consumed by the INSTANCED shader variants:
+// model matrix at locations 3-6, material at 7-9 (specular.w = shininess)
+struct InstanceData {
+    glm::mat4 model;
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+};
+
+constexpr unsigned int INSTANCE_ATTRIB_LOCATION = 3;
+
+// Geometry of a mesh prepared off the GL thread: vertices, indices and the LOD chain
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<MeshSimplifier::Lod> lods;
 };
 
 class Mesh {
@@ -17,25 +34,120 @@ public:
         PATCHES
     };
     
+    // Vertex buffer layout: Vertex as is, or CompactVertex at half the size. Both feed the same
+    // vec3 position, vec3 normal and vec2 texture coordinate inputs.
+    enum class VertexFormat {
+        Float,
+        Compact
+    };
+    
+    // Meshes up to this many vertices are drawn with 16-bit indices
+    static constexpr std::size_t MAX_16BIT_VERTICES = 65536;
+    
+    // Level 0 is the full mesh, levels 1..MAX_LODS-1 are simplified index lists over the same vertices
+    static constexpr int MAX_LODS = 5;
+    
     Mesh();
     ~Mesh();
     
     void SetVertices(const std::vector<Vertex>& vertices);
     void SetIndices(const std::vector<unsigned int>& indices);
     
-    void Draw(RenderMode mode = RenderMode::TRIANGLES) const;
+    // Vertices, indices and LOD levels in a single upload
+    void SetGeometry(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                     const std::vector<MeshSimplifier::Lod>& lods);
+    
+    // Stores simplified levels after the base indices in the same index buffer. Setting new indices
+    // drops them again.
+    void SetLods(const std::vector<MeshSimplifier::Lod>& lods);
+    // Builds and uploads the LOD chain on the calling thread
+    void GenerateLods();
+    
+    // Simplified levels of a mesh with their indices in vertex cache order; CPU only, safe on workers
+    static std::vector<MeshSimplifier::Lod> BuildLodChain(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                                          const std::vector<unsigned char>* locked = nullptr);
+    
+    void Draw(RenderMode mode = RenderMode::TRIANGLES, int lod = 0) const;
+    
+    // Draws instanceCount copies reading InstanceData from instanceBuffer starting at byteOffset
+    void DrawInstanced(unsigned int instanceBuffer, std::size_t byteOffset, int instanceCount,
+                       RenderMode mode = RenderMode::TRIANGLES, int lod = 0) const;
+    
+    // Same triangles from the position-only stream, for depth-only passes. Positions hold exactly
+    // the values the main layout decodes to, so depth matches the colour pass bit for bit. The
+    // stream is built on the first depth draw and kept until ReleaseDepthStreams.
+    void DrawDepth(int lod = 0) const;
+    // Only the model matrix of InstanceData is read
+    void DrawDepthInstanced(unsigned int instanceBuffer, std::size_t byteOffset, int instanceCount, int lod = 0) const;
     
     const std::vector<Vertex>& GetVertices() const { return vertices; }
     const std::vector<unsigned int>& GetIndices() const { return indices; }
+    unsigned int GetVAO() const { return VAO; }
+    
+    // Uploads use the compact layout whenever its rounding stays within the error bounds,
+    // otherwise full floats. Affects meshes uploaded afterwards.
+    static void SetCompactVerticesEnabled(bool enable);
+    static bool IsCompactVerticesEnabled();
+    // Frees the position-only streams of every mesh once no depth-only pass draws them
+    static void ReleaseDepthStreams();
+    VertexFormat GetVertexFormat() const { return vertexFormat; }
+    std::size_t GetVertexBufferSize() const;
+    // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, picked from the vertex count at upload
+    GLenum GetIndexType() const { return indexType; }
+    std::size_t GetIndexBufferSize() const { return (indices.size() + lodIndices.size()) * GetIndexSize(); }
+    // Changes whenever the GPU buffers are rebuilt; unique across meshes, so caches keyed by
+    // mesh pointer can tell a recycled address from the mesh they captured
+    std::uint64_t GetRevision() const { return revision; }
+    std::size_t GetTriangleCount() const { return (indices.empty() ? vertices.size() : indices.size()) / 3; }
+    
+    int GetLodCount() const { return 1 + static_cast<int>(lods.size()); }
+    // Out of range levels fall back to the coarsest one
+    std::size_t GetLodTriangleCount(int lod) const;
+    // Deviation of a level from the full mesh in model units, 0 for level 0
+    float GetLodError(int lod) const;
+    // CPU copy of a level's triangle list, GetLodTriangleCount(lod) * 3 indices into GetVertices();
+    // null for non-indexed meshes
+    const unsigned int* GetLodIndices(int lod) const;
+    
+    // Local-space bounds, computed when the vertices are set
+    const BoundingBox& GetBounds() const { return bounds; }
+    const BoundingSphere& GetBoundingSphere() const { return boundingSphere; }
     
 private:
+    struct LodRange {
+        std::size_t indexOffset;
+        std::size_t indexCount;
+        float error;
+    };
+    
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
+    std::vector<unsigned int> lodIndices;
+    std::vector<LodRange> lods;
+    BoundingBox bounds;
+    BoundingSphere boundingSphere;
     
     unsigned int VAO = 0;
     unsigned int VBO = 0;
     unsigned int EBO = 0;
+    // Tightly packed vec3 positions sharing the index buffer, 12 bytes per vertex; only exists
+    // between the first depth draw and ReleaseDepthStreams
+    mutable unsigned int depthVAO = 0;
+    mutable unsigned int positionVBO = 0;
+    std::uint64_t revision = 0;
+    VertexFormat vertexFormat = VertexFormat::Float;
+    GLenum indexType = GL_UNSIGNED_INT;
     
     void SetupMesh();
+    void SetupDepthStream() const;
+    void DeleteDepthStream() const;
     void DeleteBuffers();
+    // Points the instance attributes of the bound vertex array at instanceBuffer; the material
+    // columns are skipped for depth-only draws
+    void BindInstanceData(unsigned int instanceBuffer, std::size_t byteOffset, bool withMaterial) const;
+    void DrawPrimitives(GLenum primitiveType, int lod, int instanceCount) const;
+    void StoreLods(const std::vector<MeshSimplifier::Lod>& lods);
+    std::size_t GetIndexSize() const { return indexType == GL_UNSIGNED_SHORT ? sizeof(std::uint16_t) : sizeof(std::uint32_t); }
+    // Index range drawn for a level; the full index list for level 0
+    const LodRange* GetLodRange(int lod) const;
 };
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Mesh.h"
+
+// On-disk cache of prepared model geometry, stored next to the source file as
+// "<source>.meshcache". A hit skips the importer, the optimiser and the simplifier.
+// The cache is rebuilt when it's older than the source or written by another version.
+//
+// Index lists can be stored compressed: each index is coded as its distance below the
+// highest index seen so far plus one, zigzagged and written as a LEB128 varint. Indices in
+// vertex fetch order are mostly just behind that high-water mark, so most take one byte.
+class MeshCache {
+public:
+    static constexpr std::uint32_t VERSION = 1;
+
+    static void SetEnabled(bool enable);
+    static bool IsEnabled();
+    static void SetIndexCompressionEnabled(bool enable);
+    static bool IsIndexCompressionEnabled();
+
+    static std::string GetCachePath(const std::string& sourcePath);
+
+    // False when there's no up to date, valid cache for sourcePath
+    static bool Load(const std::string& sourcePath, std::vector<MeshData>& meshes);
+    // Refuses meshes with point or line faces, which Load would reject
+    static bool Save(const std::string& sourcePath, const std::vector<MeshData>& meshes);
+
+    static void EncodeIndices(const std::vector<unsigned int>& indices, std::vector<std::uint8_t>& encoded);
+    // Reads indexCount indices from data; false on truncated or malformed input, including counts
+    // the data is too short to hold
+    static bool DecodeIndices(const std::uint8_t* data, std::size_t size, std::size_t indexCount,
+                              std::vector<unsigned int>& indices, std::size_t* bytesRead = nullptr);
+};
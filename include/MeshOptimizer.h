@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "Vertex.h"
+
+// Reorders index and vertex buffers for the GPU without changing what is drawn:
+//
+//   OptimizeVertexCache   Tipsify (Sander et al. 2007): triangles are emitted around recently used
+//                         vertices so the post-transform cache reuses more shaded vertices
+//   OptimizeOverdraw      splits that order into clusters where restarting costs little cache
+//                         efficiency, then draws outward-facing clusters first so they occlude more
+//   OptimizeVertexFetch   renumbers vertices in first-use order, dropping unreferenced ones, so
+//                         vertex fetches walk the buffer mostly sequentially
+//
+// Deterministic, pure CPU code without GL calls, safe to run on worker threads.
+class MeshOptimizer {
+public:
+    // FIFO post-transform cache size assumed by the statistics and the reordering
+    static constexpr int CACHE_SIZE = 16;
+
+    // Simulated vertex shader invocations of an index list
+    struct Stats {
+        std::size_t triangles = 0;
+        std::size_t vertices = 0;       // distinct vertices referenced
+        std::size_t transforms = 0;     // cache misses
+
+        void Add(const Stats& other);
+        // Average cache miss ratio: transforms per triangle, 0.5 at best for large meshes, 3 at worst
+        float GetAcmr() const { return triangles ? static_cast<float>(transforms) / triangles : 0.0f; }
+        // Average transform to vertex ratio: 1 means every vertex is shaded exactly once
+        float GetAtvr() const { return vertices ? static_cast<float>(transforms) / vertices : 0.0f; }
+    };
+
+    static Stats AnalyzeVertexCache(const std::vector<unsigned int>& indices, std::size_t vertexCount, int cacheSize = CACHE_SIZE);
+
+    static void OptimizeVertexCache(std::vector<unsigned int>& indices, std::size_t vertexCount, int cacheSize = CACHE_SIZE);
+
+    // Expects a cache-optimised order; threshold is the ACMR increase allowed for better overdraw
+    static void OptimizeOverdraw(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, float threshold = 1.05f);
+
+    static void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+    // A piece of a split mesh with its own, first-use ordered vertices
+    struct Chunk {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        // 1 for vertices whose position is also used by another chunk. Locking them when simplifying
+        // keeps the cut edges of neighbouring chunks matching.
+        std::vector<unsigned char> cut;
+    };
+
+    // Cuts the triangle list, in its current order, into chunks referencing at most maxVertices
+    // vertices each. Vertices shared across a cut are duplicated.
+    static std::vector<Chunk> SplitByVertexCount(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                                 std::size_t maxVertices);
+
+    // All three stages in order. before/after receive the cache statistics around them.
+    static void Optimize(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+                         Stats* before = nullptr, Stats* after = nullptr);
+};
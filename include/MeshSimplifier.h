@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "Vertex.h"
+
+// Quadric error metric simplification (Garland & Heckbert). Edges are collapsed onto one of their
+// existing endpoints, so a simplified level is just another index list over the original vertices
+// and every level shares one vertex buffer. Vertices split at UV or normal seams move together,
+// seams and open borders only collapse along themselves, and collapses that would flip a triangle
+// are rejected.
+//
+// Pure CPU code without GL calls, safe to run on worker threads.
+class MeshSimplifier {
+public:
+    struct Lod {
+        std::vector<unsigned int> indices;
+        // Estimated deviation from the full mesh, in model units
+        float error = 0.0f;
+    };
+
+    // Collapses the cheapest edges until at most targetIndexCount indices remain, or until the next
+    // collapse would move the surface further than maxError (model units). resultError receives the
+    // largest error of an applied collapse. Vertices flagged in locked (one entry per vertex) never
+    // move, though others may still collapse onto them.
+    static std::vector<unsigned int> Simplify(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                              std::size_t targetIndexCount, float maxError, float* resultError = nullptr,
+                                              const std::vector<unsigned char>* locked = nullptr);
+
+    // Up to maxLods levels, each simplified from the previous one to half its triangles. Stops early
+    // once a level no longer shrinks by a meaningful amount or gets too small to be worth drawing.
+    static std::vector<Lod> BuildLodChain(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, int maxLods,
+                                          const std::vector<unsigned char>* locked = nullptr);
+};
@@ -23,10 +23,25 @@ public:
     ~Model();
     
     bool LoadFromFile(const std::string& path);
-    void Draw(Mesh::RenderMode mode = Mesh::RenderMode::TRIANGLES) const;
+    void Draw(Mesh::RenderMode mode = Mesh::RenderMode::TRIANGLES, int lod = 0) const;
+    void DrawInstanced(unsigned int instanceBuffer, std::size_t byteOffset, int instanceCount,
+                       Mesh::RenderMode mode = Mesh::RenderMode::TRIANGLES, int lod = 0) const;
+    // Position-only draws for depth passes, see Mesh::DrawDepth
+    void DrawDepth(int lod = 0) const;
+    void DrawDepthInstanced(unsigned int instanceBuffer, std::size_t byteOffset, int instanceCount, int lod = 0) const;
     
     bool IsLoaded() const { return isLoaded; }
     const std::string& GetFilePath() const { return filepath; }
+    const std::vector<std::unique_ptr<Mesh>>& GetMeshes() const { return meshes; }
+    std::size_t GetTriangleCount(int lod = 0) const;
+    
+    // Meshes simplify independently, so a level's count and error are the maximum over the meshes
+    int GetLodCount() const;
+    float GetLodError(int lod) const;
+    
+    // Local-space bounds enclosing all meshes
+    const BoundingBox& GetBounds() const { return bounds; }
+    const BoundingSphere& GetBoundingSphere() const { return boundingSphere; }
     
 private:
     std::vector<std::unique_ptr<Mesh>> meshes;
@@ -34,7 +49,15 @@ private:
     std::string directory;
     std::string filepath;
     bool isLoaded = false;
+    BoundingBox bounds;
+    BoundingSphere boundingSphere;
     
-    void ProcessNode(aiNode* node, const aiScene* scene);
-    std::unique_ptr<Mesh> ProcessMesh(aiMesh* mesh);
+    void ComputeBounds();
+    void ProcessNode(aiNode* node, const aiScene* scene, std::vector<MeshData>& meshData);
+    MeshData ProcessMesh(aiMesh* mesh);
+    // Optimises vertex order, splits meshes too large for 16-bit indices when that saves memory
+    // and builds the LOD chains, on the workers
+    void PrepareMeshes(std::vector<MeshData>& meshData);
+    // Uploads every mesh once
+    void BuildMeshes(const std::vector<MeshData>& meshData);
 };
\ No newline at end of file
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Bounds.h"
+#include "Vertex.h"
+
+// CPU occlusion culling with a software depth rasteriser. A few large occluders (usually their
+// coarsest LOD) are rasterised into a low resolution, conservative per-pixel depth buffer, then
+// occludee bounding boxes are tested against it and its 8x8 block maximum (hierarchical) level.
+//
+// The screen is split into tiles that the ThreadPool rasterises independently. Pixels take the
+// minimum over all triangles, so the buffer doesn't depend on thread count or order, and the
+// scalar, SSE2 and AVX2 kernels run the same float operations lane by lane: every path produces
+// a bit-identical buffer. Coverage is sampled at pixel centres and the depth written is the
+// farthest the triangle gets within the pixel, so occludees are only ever culled conservatively
+// up to sub-pixel gaps between occluders.
+//
+// Pure CPU code without GL calls.
+class OcclusionCuller {
+public:
+    enum class SimdPath {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    static constexpr int DEFAULT_WIDTH = 320;
+    static constexpr int DEFAULT_HEIGHT = 192;
+    // Unit of work for the workers; multiples of the block size
+    static constexpr int TILE_WIDTH = 64;
+    static constexpr int TILE_HEIGHT = 32;
+    // Granularity of the hierarchical depth level
+    static constexpr int BLOCK_SIZE = 8;
+
+    struct Stats {
+        int occluders = 0;
+        std::size_t occluderTriangles = 0;
+        // Triangles left after near clipping and backface culling
+        std::size_t rasterizedTriangles = 0;
+        int tested = 0;
+        int culled = 0;
+    };
+
+    OcclusionCuller();
+
+    // Rounded up to whole tiles
+    void SetResolution(int width, int height);
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+
+    // Best path the CPU supports; SetSimdPath falls back to it for unsupported requests
+    static SimdPath GetBestSimdPath();
+    static const char* GetSimdPathName(SimdPath path);
+    void SetSimdPath(SimdPath path);
+    SimdPath GetSimdPath() const { return simdPath; }
+
+    // Rasterising on the ThreadPool, or on the calling thread only
+    void SetMultithreaded(bool enable) { multithreaded = enable; }
+
+    // Starts a frame and forgets the occluders; the buffer is cleared to the far plane when rasterising
+    void BeginFrame(const glm::mat4& viewProjection);
+
+    // Queues indexCount indices (a triangle list) over vertices, transformed by model. The arrays
+    // are read in RasterizeOccluders and must stay alive until then.
+    void AddOccluder(const Vertex* vertices, std::size_t vertexCount, const unsigned int* indices, std::size_t indexCount,
+                     const glm::mat4& model);
+
+    void RasterizeOccluders();
+
+    // False only when the whole box lies behind rasterised occluders. Boxes crossing the near
+    // plane are always visible.
+    bool IsVisible(const BoundingBox& worldBox);
+
+    // Row-major from the bottom-left, NDC depth with 1 at the far plane
+    const std::vector<float>& GetDepthBuffer() const { return depth; }
+    const Stats& GetStats() const { return stats; }
+
+    // Triangle after clipping and snapping, ready for the kernels
+    struct ScreenTriangle {
+        // Edge i is inside where edgeA * (x - edgeX) + edgeB * (y - edgeY) > 0, or >= 0 when
+        // inclusive (top-left rule)
+        float edgeA[3];
+        float edgeB[3];
+        float edgeX[3];
+        float edgeY[3];
+        bool inclusive[3];
+        // Depth plane through vertex 0, shifted to the far side of each pixel and clamped
+        float depthA;
+        float depthB;
+        float depthX;
+        float depthY;
+        float depthZ;
+        float depthMax;
+        // Inclusive pixel bounds, within the buffer
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+    };
+
+private:
+    struct Occluder {
+        const Vertex* vertices;
+        std::size_t vertexCount;
+        const unsigned int* indices;
+        std::size_t indexCount;
+        glm::mat4 modelViewProjection;
+    };
+
+    struct TriangleRef {
+        unsigned int occluder;
+        unsigned int triangle;
+    };
+
+    int width = 0;
+    int height = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+    SimdPath simdPath = SimdPath::Scalar;
+    bool multithreaded = true;
+
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    std::vector<Occluder> occluders;
+    // Set up triangles of each occluder, and the triangles overlapping each tile
+    std::vector<std::vector<ScreenTriangle>> occluderTriangles;
+    std::vector<std::vector<TriangleRef>> tileBins;
+
+    std::vector<float> depth;
+    std::vector<float> blockMaxDepth;
+    Stats stats;
+
+    void SetupTriangles(const Occluder& occluder, std::vector<ScreenTriangle>& triangles) const;
+    void RasterizeTile(int tile);
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "GpuProfiler.h"
+
+// Counts the primitives a range of draws generates, after tessellation, with GL_PRIMITIVES_GENERATED
+// queries. Like the GpuProfiler it keeps FRAME_LATENCY queries in flight and only reads results GL
+// reports as available, so the count lags a couple of frames but never stalls the CPU.
+class PrimitiveCounter {
+public:
+    static constexpr int FRAME_LATENCY = GpuProfiler::FRAME_LATENCY;
+
+    PrimitiveCounter() = default;
+    ~PrimitiveCounter();
+
+    PrimitiveCounter(const PrimitiveCounter&) = delete;
+    PrimitiveCounter& operator=(const PrimitiveCounter&) = delete;
+
+    bool Initialize();
+    void Shutdown();
+
+    // Collects finished queries and starts a new frame
+    void BeginFrame();
+
+    // Counts the draws in between, at most once per frame
+    void Begin();
+    void End();
+
+    // Newest collected count, -1 until the first result arrives
+    long long GetLastCount() const { return lastCount; }
+
+private:
+    unsigned int queries[FRAME_LATENCY] = {};
+    bool pending[FRAME_LATENCY] = {};
+    unsigned long long frameNumber = 0;
+    unsigned long long lastFrame = ~0ull;
+    long long lastCount = -1;
+    bool active = false;
+    bool initialized = false;
+};
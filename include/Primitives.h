@@ -16,6 +16,17 @@ public:
     static std::unique_ptr<Mesh> CreateCylinder(float radius = 0.5f, float height = 2.0f, unsigned int segments = 32);
     static std::unique_ptr<Mesh> CreateCone(float radius = 0.5f, float height = 1.0f, unsigned int segments = 32);
     
+    // Shared meshes, cached by primitive type and parameters. Objects created with the same
+    // parameters reference one GPU mesh, which is released when the last reference goes away.
+    static std::shared_ptr<Mesh> GetCube(float size = 1.0f);
+    static std::shared_ptr<Mesh> GetSphere(float radius = 1.0f, unsigned int segments = 32);
+    static std::shared_ptr<Mesh> GetPlane(float width = 1.0f, float height = 1.0f);
+    static std::shared_ptr<Mesh> GetCylinder(float radius = 0.5f, float height = 2.0f, unsigned int segments = 32);
+    static std::shared_ptr<Mesh> GetCone(float radius = 0.5f, float height = 1.0f, unsigned int segments = 32);
+    
+    // Number of cached meshes still referenced by at least one object
+    static std::size_t GetCachedMeshCount();
+    
     // Create complete primitive objects (including mesh, shader, and material)
     static std::unique_ptr<SceneObject> CreatePrimitiveObject(const std::string& type, const std::string& name);
     
@@ -0,0 +1,106 @@
+#pragma once
+
+// Scoped CPU profiler that exports Chrome trace_event JSON (chrome://tracing, Perfetto).
+//
+//   PROFILE_SCOPE("Name");   times the enclosing scope, the name must be a string literal
+//   PROFILE_FUNCTION();      same, named after the enclosing function
+//   PROFILE_FRAME();         marks the end of a frame, finishes the capture after N frames
+//
+// Every thread records into its own preallocated buffer, so recording takes no locks.
+// Zones are only timed while a capture is running. Without ENABLE_PROFILER the macros
+// expand to nothing and the profiler isn't compiled at all.
+
+#ifdef ENABLE_PROFILER
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Profiler {
+public:
+    static Profiler* GetInstance();
+
+    // Records the next frameCount frames (and everything before the first PROFILE_FRAME),
+    // then writes them to filepath
+    bool BeginCapture(int frameCount, const std::string& filepath);
+    void EndFrame();
+
+    bool IsCapturing() const { return capturing.load(std::memory_order_relaxed); }
+
+    // Label shown for the calling thread in the trace
+    void SetThreadName(const char* name);
+
+    // Monotonic timestamp in nanoseconds
+    static uint64_t Now();
+
+    void Record(const char* name, uint64_t startNs, uint64_t endNs);
+
+private:
+    Profiler() = default;
+
+    struct Event {
+        const char* name;
+        uint64_t startNs;
+        uint64_t durationNs;
+    };
+
+    // Written only by its owning thread; count is published with release so the
+    // exporting thread sees complete events
+    struct ThreadBuffer {
+        static constexpr std::size_t CAPACITY = 1 << 16;
+
+        std::vector<Event> events;
+        std::atomic<std::size_t> count{0};
+        std::atomic<std::size_t> dropped{0};
+        uint32_t threadId = 0;
+        std::string threadName;
+    };
+
+    std::atomic<bool> capturing{false};
+    int framesRemaining = 0;
+    uint64_t captureStartNs = 0;
+    std::string capturePath;
+
+    // Guards the buffer list only, taken once per thread on its first event
+    std::mutex buffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+    ThreadBuffer* GetThreadBuffer();
+    bool WriteCapture();
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name)
+        : name(name), startNs(Profiler::GetInstance()->IsCapturing() ? Profiler::Now() : 0) {}
+
+    ~ProfileScope()
+    {
+        if (startNs != 0)
+            Profiler::GetInstance()->Record(name, startNs, Profiler::Now());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    uint64_t startNs;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_FRAME() Profiler::GetInstance()->EndFrame()
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_FRAME() ((void)0)
+
+#endif
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class SceneObject;
+class Shader;
+class Mesh;
+class Model;
+
+// Render passes, in submission order (highest bits of the sort key)
+enum class RenderPass : uint8_t {
+    Opaque = 0,
+    // Blended over the opaque scene without depth writes
+    Transparent = 1
+};
+
+struct RenderItem {
+    uint64_t sortKey = 0;
+    SceneObject* object = nullptr;
+    Shader* shader = nullptr;
+    const Mesh* mesh = nullptr;
+    const Model* model = nullptr;
+    // Level of detail to draw, also folded into the mesh bits of the sort key
+    int lod = 0;
+    
+    const void* GetGeometry() const { return mesh ? static_cast<const void*>(mesh) : static_cast<const void*>(model); }
+};
+
+// Flat list of draw requests extracted from the scene each frame.
+// Opaque items are ordered by a packed 64-bit key: coarse depth slices front to back, and within
+// a slice objects sharing a shader, then a VAO, then a material end up next to each other, so
+// early depth testing works without giving up state grouping:
+//
+//   63..60  pass
+//   59..56  depth slice (front to back)
+//   55..44  shader program
+//   43..28  mesh (per-frame index) and level of detail
+//   27..12  material hash
+//   11..0   view depth (front to back)
+//
+// Transparent items must blend back to front, so their depth comes first:
+//
+//   63..60  pass
+//   59..44  view depth (back to front)
+//   43..32  shader program
+//   31..16  mesh (per-frame index) and level of detail
+//   15..0   material hash
+class RenderQueue {
+public:
+    static constexpr uint32_t DEPTH_SLICES = 16;
+
+    // depth is the 16-bit quantized view depth; depthSlice (below DEPTH_SLICES) only applies to
+    // opaque items
+    static uint64_t MakeSortKey(RenderPass pass, uint32_t depthSlice, uint32_t shader, uint32_t mesh, uint32_t material, uint32_t depth);
+    static RenderPass GetPass(uint64_t sortKey) { return static_cast<RenderPass>(sortKey >> 60); }
+
+    void Clear() { items.clear(); }
+    void Add(const RenderItem& item) { items.push_back(item); }
+
+    // Stable sort on the key. When the same objects were added in the same order as last frame,
+    // last frame's order is reapplied and patched up with an insertion sort, which is linear while
+    // only a few items change places; otherwise, or when too much changed, an LSD radix sort
+    // (8 bits per pass). Both give the same result, and no memory is allocated once the arrays
+    // have grown to the scene.
+    void Sort();
+    // Whether the last Sort got away with patching last frame's order
+    bool WasSortIncremental() const { return sortIncremental; }
+
+    const std::vector<RenderItem>& GetItems() const { return items; }
+    std::size_t Size() const { return items.size(); }
+    bool Empty() const { return items.empty(); }
+
+private:
+    struct SortEntry {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    std::vector<RenderItem> items;
+    std::vector<RenderItem> scratch;
+    std::vector<SortEntry> entries;
+    std::vector<SortEntry> scratchEntries;
+    // Objects in the order they were added last frame, and the order they were sorted into
+    std::vector<const SceneObject*> previousObjects;
+    std::vector<uint32_t> previousOrder;
+    bool sortIncremental = false;
+
+    bool PatchPreviousOrder();
+    void RadixSortEntries();
+};
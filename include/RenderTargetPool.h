@@ -0,0 +1,66 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <vector>
+
+// Size and format of a render target texture
+struct RenderTargetDesc {
+    int width = 0;
+    int height = 0;
+    GLenum internalFormat = GL_RGBA8;
+    GLenum format = GL_RGBA;
+    GLenum type = GL_UNSIGNED_BYTE;
+    GLenum filter = GL_NEAREST;
+
+    bool operator==(const RenderTargetDesc& other) const
+    {
+        return width == other.width && height == other.height && internalFormat == other.internalFormat &&
+               format == other.format && type == other.type && filter == other.filter;
+    }
+};
+
+// Owns the textures behind the renderer's framebuffers. Targets are acquired by description and
+// released when a framebuffer is rebuilt (resize, resolution scale or layout change); released
+// textures are kept for MAX_UNUSED_FRAMES frames so switching back to a recent size reuses them.
+class RenderTargetPool {
+public:
+    static constexpr int MAX_UNUSED_FRAMES = 120;
+
+    struct Stats {
+        int textures = 0;
+        int texturesInUse = 0;
+        std::size_t bytes = 0;
+    };
+
+    RenderTargetPool() = default;
+    ~RenderTargetPool();
+
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+    // Returns an edge-clamped texture matching desc
+    GLuint Acquire(const RenderTargetDesc& desc);
+    void Release(GLuint texture);
+
+    // Ages released textures and deletes the ones unused for too long
+    void BeginFrame();
+
+    // Deletes every texture, in use or not
+    void Clear();
+
+    Stats GetStats() const;
+
+private:
+    struct Entry {
+        GLuint texture = 0;
+        RenderTargetDesc desc;
+        bool inUse = false;
+        int unusedFrames = 0;
+    };
+
+    std::vector<Entry> entries;
+
+    static std::size_t GetBytesPerPixel(GLenum internalFormat);
+    static void DeleteTexture(GLuint texture);
+};
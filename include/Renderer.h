@@ -2,25 +2,81 @@
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <algorithm>
 #include <memory>
+#include <unordered_map>
+#include <vector>
+#include "Mesh.h"
+#include "Bounds.h"
+#include "RenderQueue.h"
+#include "UniformBuffers.h"
+#include "GpuProfiler.h"
+#include "PrimitiveCounter.h"
+#include "TessellationCache.h"
+#include "LightGrid.h"
+#include "ClusterGrid.h"
+#include "RenderTargetPool.h"
+#include "DynamicResolution.h"
+#include "OcclusionCuller.h"
 
 class Scene;
 class Camera;
 class Shader;
+class SceneObject;
 
 enum class RenderMode {
     Solid,
     Wireframe,
     Deferred,
+    ClusteredForward,
     Tessellation,
     TessellationWithWireframe
 };
 
+// Deferred G-buffer layouts. Standard stores position, normal and albedo/specular in RGBA16F;
+// Compact reconstructs position from a depth texture, packs normals into RG16 and albedo into RGBA8.
+enum class GBufferLayout {
+    Standard,
+    Compact
+};
+
 enum class LightingModel {
     Flat,
     Phong
 };
 
+// Per-frame submission counters, reset in BeginFrame
+struct RenderStats {
+    int drawCalls = 0;
+    int programSwitches = 0;
+    int vaoSwitches = 0;
+    int renderItems = 0;
+    int uniformBufferUploads = 0;
+    int instancedBatches = 0;
+    int instancedObjects = 0;
+    int visibleObjects = 0;
+    int culledObjects = 0;
+    int selectedObjects = 0;
+    // Queue items drawn at each level of detail
+    int lodObjects[Mesh::MAX_LODS] = {};
+    // Primitives the tessellator generated, from a query a couple of frames old; -1 until known
+    long long tessellatedPrimitives = -1;
+    std::size_t triangles = 0;
+    // What triangles would have been with every object at full detail
+    std::size_t fullDetailTriangles = 0;
+    // Draws of the depth pre-pass and queue items its GL_EQUAL colour pass covered
+    int depthPrepassDraws = 0;
+    int depthPrepassObjects = 0;
+    // Frustum-visible objects the software occlusion buffer hid, and what was rasterised into it
+    int occludedObjects = 0;
+    int occluders = 0;
+    std::size_t occluderTriangles = 0;
+    // Queue items blended in the transparent pass, and whether the queue sort could reuse last
+    // frame's order
+    int transparentObjects = 0;
+    bool incrementalSort = false;
+};
+
 class Renderer {
 public:
     Renderer();
@@ -39,6 +95,18 @@ public:
     void PrepareForUIRendering();
     void RestoreAfterUIRendering();
     
+    // Size of the window's framebuffer; render targets follow it from the next frame on
+    void SetDisplaySize(int width, int height);
+    
+    // Resolution the scene is rendered at. Below the display size the scene is drawn into an
+    // offscreen target and upscaled into the window at the end of Render.
+    int GetRenderWidth() const { return renderWidth; }
+    int GetRenderHeight() const { return renderHeight; }
+    
+    // Lowers the render resolution while the GPU frame time is over its target
+    DynamicResolution& GetDynamicResolution() { return dynamicResolution; }
+    RenderTargetPool::Stats GetRenderTargetStats() const { return renderTargets.GetStats(); }
+    
     void SetRenderMode(RenderMode mode) { renderMode = mode; }
     RenderMode GetRenderMode() const { return renderMode; }
     
@@ -56,6 +124,21 @@ public:
     void CleanupDeferredRendering();
     void RenderDeferred(Scene* scene, Camera* camera);
     
+    // Switching layouts recreates the G-buffer on the next deferred frame
+    void SetGBufferLayout(GBufferLayout layout);
+    GBufferLayout GetGBufferLayout() const { return gBufferLayout; }
+    
+    // Deferred lighting with lights binned per screen tile, no limit on the light count
+    void SetTiledLightingEnabled(bool enable) { tiledLightingEnabled = enable; }
+    bool IsTiledLightingEnabled() const { return tiledLightingEnabled; }
+    const LightGrid::Stats& GetLightGridStats() const { return lightGrid.GetStats(); }
+    
+    // Clustered forward: object shaders with a CLUSTERED_LIGHTING variant only see their cluster's lights
+    const ClusterGrid::Stats& GetClusterGridStats() const { return clusterGrid.GetStats(); }
+    void SetClusterComputeEnabled(bool enable) { clusterGrid.SetComputeEnabled(enable); }
+    bool IsClusterComputeEnabled() const { return clusterGrid.IsComputeEnabled(); }
+    bool IsClusterComputeSupported() const { return clusterGrid.IsComputeSupported(); }
+    
     // Methods for tessellation control
     void SetTessellationLevelOuter(float level) { tessellationLevelOuter = level; }
     float GetTessellationLevelOuter() const { return tessellationLevelOuter; }
@@ -66,7 +149,65 @@ public:
     void SetDisplacementAmount(float amount) { displacementAmount = amount; }
     float GetDisplacementAmount() const { return displacementAmount; }
     
+    // Adaptive tessellation picks per-edge levels from the edge's projected length and culls patches
+    // outside the frustum; the fixed outer/inner levels apply when it's off
+    void SetAdaptiveTessellationEnabled(bool enable) { adaptiveTessellationEnabled = enable; }
+    bool IsAdaptiveTessellationEnabled() const { return adaptiveTessellationEnabled; }
+    
+    // Target edge length of the tessellated triangles, in render target pixels
+    void SetTessellationTriangleSize(float pixels) { tessellationTriangleSize = std::max(pixels, 1.0f); }
+    float GetTessellationTriangleSize() const { return tessellationTriangleSize; }
+    
+    // Drops patches whose normals all face away from the camera, hiding the back of open meshes
+    void SetPatchBackfaceCullingEnabled(bool enable) { patchBackfaceCullingEnabled = enable; }
+    bool IsPatchBackfaceCullingEnabled() const { return patchBackfaceCullingEnabled; }
+    
+    // With fixed levels, tessellated meshes are captured once and replayed as plain triangles
+    void SetTessellationCacheEnabled(bool enable) { tessellationCacheEnabled = enable; }
+    bool IsTessellationCacheEnabled() const { return tessellationCacheEnabled; }
+    bool IsTessellationCacheActive() const;
+    const TessellationCache::Stats& GetTessellationCacheStats() const { return tessellationCache.GetStats(); }
+    
     bool IsTessellationSupported();
+    
+    // Automatic instancing of queue runs sharing a shader and mesh
+    void SetInstancingEnabled(bool enable) { instancingEnabled = enable; }
+    bool IsInstancingEnabled() const { return instancingEnabled; }
+    
+    void SetFrustumCullingEnabled(bool enable) { frustumCullingEnabled = enable; }
+    bool IsFrustumCullingEnabled() const { return frustumCullingEnabled; }
+    
+    // Opaque items are ordered front to back in coarse depth slices ahead of shader and mesh, so
+    // early depth testing rejects hidden fragments; off, state grouping alone decides the order.
+    // Transparent items are always drawn back to front.
+    void SetFrontToBackEnabled(bool enable) { frontToBackEnabled = enable; }
+    bool IsFrontToBackEnabled() const { return frontToBackEnabled; }
+    
+    // Objects switch to the coarsest mesh LOD whose simplification error projects to at most
+    // lodPixelError render target pixels
+    void SetLodEnabled(bool enable) { lodEnabled = enable; }
+    bool IsLodEnabled() const { return lodEnabled; }
+    void SetLodPixelError(float pixels) { lodPixelError = std::max(pixels, 0.1f); }
+    float GetLodPixelError() const { return lodPixelError; }
+    
+    // Forward passes first lay down depth from the position-only streams with a trivial shader,
+    // then shade with GL_EQUAL and depth writes off, so each pixel runs the fragment shader once.
+    // Only objects whose shader declares an invariant gl_Position take part; others (vertex
+    // displacement) draw with the normal depth test afterwards. Pays off on high-overdraw scenes.
+    // Meshes build their position streams on their first pre-pass draw; disabling frees them.
+    void SetDepthPrepassEnabled(bool enable);
+    bool IsDepthPrepassEnabled() const { return depthPrepassEnabled; }
+    
+    // The largest frustum-visible objects are rasterised on the CPU each frame, at a coarse LOD,
+    // and objects whose bounds lie entirely behind them never reach the queue
+    void SetOcclusionCullingEnabled(bool enable) { occlusionCullingEnabled = enable; }
+    bool IsOcclusionCullingEnabled() const { return occlusionCullingEnabled; }
+    OcclusionCuller& GetOcclusionCuller() { return occlusionCuller; }
+    
+    const RenderStats& GetStats() const { return stats; }
+    
+    // Per-pass GPU timings, also used by the application to time the UI
+    GpuProfiler& GetGpuProfiler() { return gpuProfiler; }
 
 private:
     // Rendering options
@@ -80,6 +221,13 @@ private:
     float tessellationLevelOuter = 4.0f;
     float tessellationLevelInner = 4.0f;
     float displacementAmount = 0.3f;
+    bool adaptiveTessellationEnabled = true;
+    float tessellationTriangleSize = 8.0f;
+    bool patchBackfaceCullingEnabled = true;
+    float maxTessellationLevel = 64.0f;
+    PrimitiveCounter tessellationPrimitives;
+    TessellationCache tessellationCache;
+    bool tessellationCacheEnabled = true;
     
     // Screen-space quad for deferred rendering
     bool deferredSetupComplete = false;
@@ -87,10 +235,121 @@ private:
     unsigned int gPosition = 0;
     unsigned int gNormal = 0;
     unsigned int gAlbedoSpec = 0;
-    unsigned int gDepth = 0;
+    unsigned int gDepthTexture = 0;
+    GBufferLayout gBufferLayout = GBufferLayout::Standard;
+    int gBufferWidth = 0;
+    int gBufferHeight = 0;
+    
+    LightGrid lightGrid;
+    bool tiledLightingEnabled = false;
+    ClusterGrid clusterGrid;
+    
+    // Framebuffer textures come from the pool and go back to it whenever a target is rebuilt
+    RenderTargetPool renderTargets;
+    DynamicResolution dynamicResolution;
+    int displayWidth = 0;
+    int displayHeight = 0;
+    int renderWidth = 0;
+    int renderHeight = 0;
+    
+    // Offscreen scene target, only allocated while rendering below display resolution
+    unsigned int sceneFramebuffer = 0;
+    unsigned int sceneColor = 0;
+    unsigned int sceneDepth = 0;
     unsigned int quadVAO = 0;
     unsigned int quadVBO = 0;
     
+    // Selection outline: highlighted objects are drawn into an R8 mask, grouped into one instanced
+    // draw per mesh, then a single full-screen pass outlines the mask, whatever the selection size
+    unsigned int selectionFramebuffer = 0;
+    unsigned int selectionMask = 0;
+    unsigned int selectionInstanceVBO = 0;
+    std::size_t selectionBufferCapacity = 0;
+    std::vector<SceneObject*> selectedObjects;
+    std::vector<InstanceData> selectionInstances;
+    
+    // Shared FrameData / LightData uniform blocks and the last uploaded contents
+    unsigned int frameUBO = 0;
+    unsigned int lightUBO = 0;
+    FrameData uploadedFrameData;
+    LightData uploadedLightData;
+    LightData pendingLightData;
+    bool uniformBuffersUploaded = false;
+    bool lightLimitWarned = false;
+    
+    // Forward render queue, rebuilt every frame
+    RenderQueue renderQueue;
+    // Dense index of each mesh or model in the queue being built, for the mesh bits of the sort key.
+    // Entries outlive a build and are renumbered the first time a build sees them, so steady frames
+    // don't allocate; entries of geometry that stopped showing up are pruned once they pile up.
+    struct GeometryKey {
+        uint64_t build = 0;
+        uint32_t index = 0;
+    };
+    std::unordered_map<const void*, GeometryKey> geometryKeys;
+    uint64_t queueBuildCount = 0;
+    uint32_t queueGeometryCount = 0;
+    RenderStats stats;
+    
+    // A run of consecutive queue items drawn either one by one or as a single instanced draw
+    struct DrawBatch {
+        std::size_t firstItem = 0;
+        std::size_t itemCount = 0;
+        std::size_t firstInstance = 0;
+        Shader* shader = nullptr;
+        bool instanced = false;
+        // Depth came from the pre-pass, the colour pass tests GL_EQUAL
+        bool depthPrepassed = false;
+        // Blended with the material opacity, without depth writes
+        bool transparent = false;
+    };
+    
+    bool instancingEnabled = true;
+    unsigned int instanceVBO = 0;
+    std::size_t instanceBufferCapacity = 0;
+    std::vector<InstanceData> instanceData;
+    std::vector<DrawBatch> drawBatches;
+    
+    // View frustum of the current frame, updated at the start of Render
+    Frustum frustum;
+    bool frustumCullingEnabled = true;
+    std::vector<SceneObject*> cullCandidates;
+    bool frontToBackEnabled = true;
+    
+    bool lodEnabled = true;
+    float lodPixelError = 1.0f;
+    
+    bool depthPrepassEnabled = false;
+    
+    OcclusionCuller occlusionCuller;
+    bool occlusionCullingEnabled = false;
+    std::vector<std::pair<float, SceneObject*>> occluderCandidates;
+    
+    GpuProfiler gpuProfiler;
+    
     void SetupScreenQuad();
+    void ReleaseGBuffer();
+    void UpdateRenderResolution();
+    void SetupSceneTarget();
+    void ReleaseSceneTarget();
+    void UpscaleToDisplay();
+    void SetupSelectionTarget();
+    void ReleaseSelectionTarget();
+    void RenderSelectionOutline(Scene* scene);
+    void RenderScene(Scene* scene, Camera* camera);
     void RenderWithTessellation(Scene* scene, Camera* camera);
+    void RenderClusteredForward(Scene* scene, Camera* camera);
+    void BuildRenderQueue(Scene* scene, Camera* camera, Shader* shaderOverride = nullptr);
+    void SubmitRenderQueue(const char* passName, bool allowDepthPrepass = false);
+    void RenderDepthPrepass();
+    void BuildDrawBatches();
+    void UploadInstanceData();
+    bool IsInFrustum(SceneObject* object, float margin = 0.0f);
+    // Fills the occlusion buffer from the largest cull candidates
+    void RasterizeOccluders(Camera* camera);
+    int SelectLod(SceneObject* object, const glm::vec3& cameraPosition, float pixelsPerUnit);
+    void ApplyFrameUniforms(Shader* shader);
+    void SetupUniformBuffers();
+    void CleanupUniformBuffers();
+    void UpdateUniformBuffers(Scene* scene, Camera* camera);
 };
\ No newline at end of file
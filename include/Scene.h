@@ -4,11 +4,14 @@
 #include <memory>
 #include <string>
 #include <glm/glm.hpp>
+#include "BVH.h"
 
 struct Light {
     glm::vec3 position = glm::vec3(0.0f, 10.0f, 10.0f);
     glm::vec3 color = glm::vec3(1.0f, 1.0f, 1.0f);
     float intensity = 1.0f;
+    // Radius of influence used by tiled light culling, 0 lights the whole scene
+    float range = 0.0f;
 };
 
 class SceneObject;
@@ -29,6 +32,22 @@ public:
     const std::vector<std::unique_ptr<SceneObject>>& GetObjects() const { return objects; }
     const std::vector<Light>& GetLights() const { return lights; }
     
+    // Spatial queries over object world bounds, backed by a dynamic AABB tree.
+    // Results are exact against each object's tight bounds; objects without geometry are not indexed.
+    void QueryFrustum(const Frustum& frustum, std::vector<SceneObject*>& results);
+    void QueryBox(const BoundingBox& box, std::vector<SceneObject*>& results);
+    void QuerySphere(const BoundingSphere& sphere, std::vector<SceneObject*>& results);
+    
+    // Nearest object whose bounds the ray hits within maxDistance, or nullptr
+    SceneObject* Raycast(const Ray& ray, float maxDistance, float* hitDistance = nullptr);
+    
+    // Applies pending object moves to the spatial index (queries do this automatically)
+    void UpdateSpatialIndex();
+    const DynamicBVH& GetSpatialIndex() const { return spatialIndex; }
+    
+    // Called by SceneObject when its world bounds change
+    void OnObjectBoundsChanged(SceneObject* object);
+    
     // Light management
     void ClearLights();
     int AddDefaultLight();
@@ -43,4 +62,11 @@ public:
 private:
     std::vector<std::unique_ptr<SceneObject>> objects;
     std::vector<Light> lights;
+    
+    DynamicBVH spatialIndex;
+    std::vector<SceneObject*> movedObjects;
+    std::vector<void*> queryResults;
+    std::vector<DynamicBVH::RayHit> rayHits;
+    
+    void RemoveFromSpatialIndex(SceneObject* object);
 };
\ No newline at end of file
@@ -6,15 +6,20 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include "Mesh.h"
 #include "Model.h"
+#include "Bounds.h"
 
 class Shader;
-class Camera;
+class Scene;
 
 struct Material {
     glm::vec3 ambient = glm::vec3(0.1f, 0.1f, 0.1f);
     glm::vec3 diffuse = glm::vec3(0.8f, 0.8f, 0.8f);
     glm::vec3 specular = glm::vec3(0.5f, 0.5f, 0.5f);
     float shininess = 32.0f;
+    // Below 1 the object is drawn in the transparent pass, blended back to front
+    float opacity = 1.0f;
+    
+    bool IsTranslucent() const { return opacity < 1.0f; }
 };
 
 class SceneObject {
@@ -23,9 +28,7 @@ public:
     virtual ~SceneObject();
     
     virtual void Update(float deltaTime);
-    virtual void Draw(Mesh::RenderMode mode = Mesh::RenderMode::TRIANGLES);
-    
-    virtual void DrawHighlight(Camera* camera, float currentTime);
+    virtual void Draw(Mesh::RenderMode mode = Mesh::RenderMode::TRIANGLES, int lod = 0);
     
     // Transform functions
     void SetPosition(const glm::vec3& position);
@@ -48,10 +51,11 @@ public:
     void SetMaterial(const Material& newMaterial) { material = newMaterial; }
     
     Mesh* GetMesh() const { return mesh.get(); }
-    void SetMesh(std::unique_ptr<Mesh> newMesh) { mesh = std::move(newMesh); model = nullptr; }
+    void SetMesh(std::shared_ptr<Mesh> newMesh) { mesh = std::move(newMesh); model = nullptr; MarkBoundsDirty(); }
+    const std::shared_ptr<Mesh>& GetSharedMesh() const { return mesh; }
     
     Model* GetModel() const { return model; }
-    void SetModel(Model* newModel) { model = newModel; mesh.reset(); }
+    void SetModel(Model* newModel) { model = newModel; mesh.reset(); MarkBoundsDirty(); }
     Shader* GetShader() const { return shader; }
     void SetShader(Shader* newShader) { shader = newShader; }
     
@@ -60,6 +64,15 @@ public:
     
     bool HasModel() const { return model != nullptr; }
     
+    // Level of detail picked by the renderer last frame, kept so switching can use hysteresis
+    int GetLodLevel() const { return lodLevel; }
+    void SetLodLevel(int level) { lodLevel = level; }
+    
+    // World-space bounds of the mesh or model, recomputed after the transform changes.
+    // Invalid when the object has no geometry.
+    const BoundingBox& GetWorldBounds();
+    const BoundingSphere& GetWorldBoundingSphere();
+    
 protected:
     std::string name;
     bool visible = true;
@@ -70,10 +83,28 @@ protected:
     glm::vec3 scale = glm::vec3(1.0f);
     glm::mat4 transform = glm::mat4(1.0f);
     bool transformDirty = false;
+    
+    // Cached world-space bounds
+    BoundingBox worldBounds;
+    BoundingSphere worldBoundingSphere;
+    bool boundsDirty = true;
+    
+    void UpdateWorldBounds();
+    void MarkBoundsDirty();
+    
       // Rendering properties
     Material material;
-    std::unique_ptr<Mesh> mesh;
+    std::shared_ptr<Mesh> mesh; // Primitive meshes are shared between objects
     Shader* shader = nullptr;
     Model* model = nullptr;
     bool highlighted = false;
+    int lodLevel = 0;
+    
+private:
+    friend class Scene;
+    
+    // Owning scene and this object's leaf in its spatial index
+    Scene* scene = nullptr;
+    int spatialProxy = -1;
+    bool spatialIndexDirty = false;
 };
\ No newline at end of file
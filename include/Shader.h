@@ -2,19 +2,52 @@
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <memory>
 #include <unordered_map>
+#include <vector>
+
+// FNV-1a hash of a uniform name. constexpr, so names written in code are hashed at compile time.
+constexpr uint32_t HashUniformName(std::string_view name)
+{
+    uint32_t hash = 2166136261u;
+    for (char c : name)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Pre-hashed uniform name for the allocation-free setters, e.g.
+//   static constexpr UniformId MODEL("model");
+//   shader->SetMat4(MODEL, transform);
+struct UniformId {
+    uint32_t hash = 0;
+    
+    constexpr UniformId() = default;
+    constexpr explicit UniformId(std::string_view name) : hash(HashUniformName(name)) {}
+};
 
 class Shader {
 public:
     Shader();
     ~Shader();    
+    // Files loaded from disk may use #include "relative/path.glsl", resolved against the including file
     bool LoadFromFile(const std::string& vertexPath, const std::string& fragmentPath);
     bool LoadFromSource(const std::string& vertexSource, const std::string& fragmentSource);
     bool LoadWithTessellationFromFile(const std::string& vertexPath, const std::string& fragmentPath,
                                       const std::string& tessControlPath, const std::string& tessEvalPath);
     bool LoadWithTessellationFromSource(const std::string& vertexSource, const std::string& fragmentSource,
                                         const std::string& tessControlSource, const std::string& tessEvalSource);
+    // Compute programs need GL 4.3
+    bool LoadComputeFromFile(const std::string& computePath);
+    
+    // Outputs of the last vertex processing stage captured by transform feedback, interleaved into
+    // one buffer. Applies to programs linked after the call.
+    void SetTransformFeedbackVaryings(const std::vector<std::string>& varyings) { feedbackVaryings = varyings; }
     
     std::string GetName() const { return name; }
     void SetName(const std::string& newName) { name = newName; }
@@ -24,6 +57,15 @@ public:
     
     unsigned int GetID() const { return id; }
     
+    // Returns this program compiled with "#define <define>" injected into every stage, or nullptr
+    // when the sources don't reference the define. Variants are compiled on first use and cached,
+    // and a variant's own GetVariant combines both defines.
+    Shader* GetVariant(const std::string& define);
+    
+    // Vertex stage declares "invariant gl_Position": its depth matches any other invariant program
+    // computing the same position from the same inputs, which a GL_EQUAL depth test relies on
+    bool HasInvariantPosition() const { return invariantPosition; }
+    
     // Uniform setters
     void SetBool(const std::string& name, bool value) const;
     void SetInt(const std::string& name, int value) const;
@@ -35,7 +77,20 @@ public:
     void SetMat3(const std::string& name, const glm::mat3& value) const;
     void SetMat4(const std::string& name, const glm::mat4& value) const;
     
-    // Get uniform location with caching
+    // Setters by pre-hashed name: a binary search in the reflected uniform table, no strings involved.
+    // Uniforms the program doesn't use are silently ignored.
+    void SetBool(UniformId uniform, bool value) const;
+    void SetInt(UniformId uniform, int value) const;
+    void SetFloat(UniformId uniform, float value) const;
+    void SetVec2(UniformId uniform, const glm::vec2& value) const;
+    void SetVec3(UniformId uniform, const glm::vec3& value) const;
+    void SetVec4(UniformId uniform, const glm::vec4& value) const;
+    void SetMat2(UniformId uniform, const glm::mat2& value) const;
+    void SetMat3(UniformId uniform, const glm::mat3& value) const;
+    void SetMat4(UniformId uniform, const glm::mat4& value) const;
+    
+    // Location of an active uniform, or -1
+    int GetUniformLocation(UniformId uniform) const;
     int GetUniformLocation(const std::string& name) const;
     
     // Get shader compilation log
@@ -44,11 +99,30 @@ public:
 private:
     unsigned int id = 0;
     std::string name;
-    mutable std::unordered_map<std::string, int> uniformLocationCache;    
     std::string compilationLog;
     
+    // Active uniforms of the linked program, reflected after linking and sorted by name hash
+    struct UniformSlot {
+        uint32_t hash;
+        int location;
+    };
+    std::vector<UniformSlot> uniforms;
+    mutable std::vector<uint32_t> reportedMissingUniforms;
+    
+    // Sources kept for compiling define variants
+    std::string vertexSourceCode;
+    std::string fragmentSourceCode;
+    bool invariantPosition = false;
+    std::unordered_map<std::string, std::unique_ptr<Shader>> variants;
+    std::vector<std::string> feedbackVaryings;
+    
     bool CompileShader(const std::string& vertexSource, const std::string& fragmentSource);
     bool CompileShaderWithTessellation(const std::string& vertexSource, const std::string& fragmentSource,
                                       const std::string& tessControlSource, const std::string& tessEvalSource);
+    bool CompileComputeShader(const std::string& computeSource);
     unsigned int CompileShaderModule(unsigned int type, const std::string& source);
+    static bool ResolveIncludes(std::string& source, const std::string& path, std::string& log, int depth = 0);
+    void ApplyTransformFeedbackVaryings();
+    void BindUniformBlocks();
+    void ReflectUniforms();
 };
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+class Mesh;
+class Shader;
+
+// Fixed tessellation parameters; the tessellated surface only depends on these and the mesh
+struct TessellationParams {
+    float outerLevel = 1.0f;
+    float innerLevel = 1.0f;
+    float displacement = 0.0f;
+
+    bool operator==(const TessellationParams& other) const
+    {
+        return outerLevel == other.outerLevel && innerLevel == other.innerLevel && displacement == other.displacement;
+    }
+    bool operator!=(const TessellationParams& other) const { return !(*this == other); }
+};
+
+// Caches the output of the tessellation shaders per mesh. On a miss the mesh is tessellated once
+// with transform feedback into a buffer of model-space triangles; later frames replay those as
+// plain triangles through tessellation_cached.vert, skipping the TCS/TES entirely. An entry is
+// recaptured when the parameters or the mesh's buffers change, and freed after MAX_UNUSED_FRAMES
+// frames without a draw.
+//
+// Only valid while the tessellation doesn't depend on the view, i.e. with fixed levels.
+class TessellationCache {
+public:
+    static constexpr int MAX_UNUSED_FRAMES = 120;
+    // Meshes that don't fit are tessellated live every frame
+    static constexpr std::size_t MAX_BYTES = 256u * 1024u * 1024u;
+
+    struct Stats {
+        int meshes = 0;
+        std::size_t bytes = 0;
+        int captures = 0;       // this frame
+        int replays = 0;        // this frame
+    };
+
+    TessellationCache() = default;
+    ~TessellationCache();
+
+    TessellationCache(const TessellationCache&) = delete;
+    TessellationCache& operator=(const TessellationCache&) = delete;
+
+    bool Initialize(float maxTessLevel);
+    void Shutdown();
+
+    bool IsSupported() const { return captureShader && replayShader; }
+
+    // Frees entries that weren't drawn for MAX_UNUSED_FRAMES frames
+    void BeginFrame();
+    void Clear();
+
+    // Draws the tessellated mesh as triangles, capturing it first on a miss. The replay program
+    // must be bound with its model and material uniforms set; capturing switches programs and
+    // rebinds it. Returns false, without drawing, when the mesh can't be cached.
+    bool Draw(const Mesh* mesh, const TessellationParams& params);
+
+    Shader* GetReplayShader() const { return replayShader.get(); }
+    const Stats& GetStats() const { return stats; }
+
+private:
+    struct Entry {
+        GLuint vao = 0;
+        GLuint buffer = 0;
+        GLuint feedback = 0;
+        std::size_t capacity = 0;
+        std::uint64_t meshRevision = 0;
+        TessellationParams params;
+        bool valid = false;
+        unsigned long long lastUsedFrame = 0;
+    };
+
+    std::unordered_map<const Mesh*, Entry> entries;
+    std::unique_ptr<Shader> captureShader;
+    std::unique_ptr<Shader> replayShader;
+    float maxLevel = 64.0f;
+    unsigned long long frameNumber = 0;
+    Stats stats;
+
+    bool Capture(const Mesh* mesh, const TessellationParams& params, Entry& entry);
+    void DeleteEntry(Entry& entry);
+    std::size_t GetCaptureSize(const Mesh* mesh, const TessellationParams& params) const;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+
+// A buffer object read by shaders through a buffer texture (samplerBuffer / imageBuffer).
+// Uploads grow the storage geometrically and otherwise orphan it, like the instance buffer.
+class TextureBuffer {
+public:
+    TextureBuffer() = default;
+    ~TextureBuffer();
+
+    TextureBuffer(const TextureBuffer&) = delete;
+    TextureBuffer& operator=(const TextureBuffer&) = delete;
+
+    void Create(GLenum format);
+    void Delete();
+
+    void Upload(const void* data, std::size_t size);
+
+    // Makes room for size bytes without uploading anything, for buffers written on the GPU
+    void Reserve(std::size_t size);
+
+    GLuint GetTexture() const { return texture; }
+    GLenum GetFormat() const { return format; }
+
+private:
+    GLuint buffer = 0;
+    GLuint texture = 0;
+    GLenum format = 0;
+    std::size_t capacity = 0;
+};
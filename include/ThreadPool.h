@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel loops. ParallelFor splits [0, count) into
+// chunks that the workers and the calling thread pick up, and returns once all of them ran.
+// The body is called through a plain function pointer, so a loop doesn't allocate.
+class ThreadPool {
+public:
+    static ThreadPool* GetInstance();
+
+    ~ThreadPool();
+
+    // Workers plus the calling thread
+    int GetThreadCount() const { return static_cast<int>(workers.size()) + 1; }
+
+    // Calls body(begin, end) for consecutive ranges of at most chunkSize items
+    template <typename Body>
+    void ParallelFor(std::size_t count, std::size_t chunkSize, Body&& body)
+    {
+        using BodyType = std::remove_reference_t<Body>;
+        Run(count, chunkSize, [](void* context, std::size_t begin, std::size_t end) {
+            (*static_cast<BodyType*>(context))(begin, end);
+        }, const_cast<void*>(static_cast<const void*>(&body)));
+    }
+
+private:
+    ThreadPool();
+
+    using ChunkFunction = void (*)(void* context, std::size_t begin, std::size_t end);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workFinished;
+    bool stopping = false;
+
+    // The current loop, only replaced once every worker that joined it has left
+    ChunkFunction function = nullptr;
+    void* context = nullptr;
+    std::size_t itemCount = 0;
+    std::size_t chunkSize = 1;
+    std::size_t chunkCount = 0;
+    unsigned long long generation = 0;
+    std::atomic<std::size_t> nextChunk{0};
+    std::size_t finishedChunks = 0;
+    int activeWorkers = 0;
+
+    // Serialises loops started from different threads
+    std::mutex runMutex;
+
+    void Run(std::size_t count, std::size_t chunk, ChunkFunction chunkFunction, void* chunkContext);
+    void WorkerLoop();
+
+    // Runs chunks of the current loop until none are left, returns how many it ran
+    std::size_t RunChunks();
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <glm/glm.hpp>
+
+// Must match MAX_LIGHTS in the shaders' LightData block
+constexpr int MAX_LIGHTS = 128;
+
+// Binding points of the shared uniform blocks, assigned to every program after linking
+constexpr unsigned int FRAME_DATA_BINDING = 0;
+constexpr unsigned int LIGHT_DATA_BINDING = 1;
+
+// std140 mirror of:
+//   layout (std140) uniform FrameData {
+//       mat4 view;
+//       mat4 projection;
+//       vec3 viewPos;
+//       int lightingModel;
+//   };
+struct FrameData {
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::vec3 viewPos = glm::vec3(0.0f);
+    int lightingModel = 0;
+};
+
+// std140 mirror of the Light struct in the shaders:
+//   struct Light {
+//       vec3 position;
+//       float intensity;
+//       vec3 color;
+//       float range;    // optional, fills the padding after color
+//   };
+struct LightBlockEntry {
+    glm::vec3 position = glm::vec3(0.0f);
+    float intensity = 0.0f;
+    glm::vec3 color = glm::vec3(0.0f);
+    float range = 0.0f;
+};
+
+// std140 mirror of:
+//   layout (std140) uniform LightData {
+//       Light lights[MAX_LIGHTS];
+//       int numLights;
+//   };
+struct LightData {
+    LightBlockEntry lights[MAX_LIGHTS];
+    int numLights = 0;
+    int padding[3] = { 0, 0, 0 };
+};
+
+static_assert(offsetof(FrameData, view) == 0, "FrameData.view must be at offset 0");
+static_assert(offsetof(FrameData, projection) == 64, "FrameData.projection must follow view");
+static_assert(offsetof(FrameData, viewPos) == 128, "FrameData.viewPos must be 16-byte aligned");
+static_assert(offsetof(FrameData, lightingModel) == 140, "FrameData.lightingModel must share viewPos' slot");
+static_assert(sizeof(FrameData) == 144, "FrameData does not match the std140 layout");
+
+static_assert(offsetof(LightBlockEntry, intensity) == 12, "Light.intensity must share position's slot");
+static_assert(offsetof(LightBlockEntry, color) == 16, "Light.color must be 16-byte aligned");
+static_assert(sizeof(LightBlockEntry) == 32, "Light array stride must be 32 bytes in std140");
+
+static_assert(offsetof(LightData, numLights) == MAX_LIGHTS * sizeof(LightBlockEntry), "LightData.numLights must follow the light array");
+static_assert(sizeof(LightData) % 16 == 0, "LightData size must be padded to 16 bytes");
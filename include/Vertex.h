@@ -0,0 +1,20 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+
+struct Vertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoords;
+};
+
+// 16 byte GPU layout of a Vertex: half float position (padded to 8 bytes), normal as signed
+// normalized GL_INT_2_10_10_10_REV and half float texture coordinates
+struct CompactVertex {
+    std::uint16_t position[4];
+    std::uint32_t normal;
+    std::uint16_t texCoords[2];
+};
+
+static_assert(sizeof(CompactVertex) == 16, "CompactVertex must match its attribute layout");
@@ -6,19 +6,14 @@ in vec2 TexCoord;
 
 out vec4 FragColor;
 
-#define MAX_LIGHTS 10
-struct Light {
-    vec3 position;
-    vec3 color;
-    float intensity;
+// Camera position and lighting model selection (0 = Flat, 1 = Phong)
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    int lightingModel;
 };
-
-// Light properties
-uniform Light lights[MAX_LIGHTS];
-uniform int numLights;
-
-// Camera position for specular calculation
-uniform vec3 viewPos;
+#include "include/lights.glsl"
 
 // Material properties
 struct Material {
@@ -27,10 +22,14 @@ struct Material {
     vec3 specular;
     float shininess;
 };
+#ifdef INSTANCED
+flat in vec4 InstanceAmbient;
+flat in vec4 InstanceDiffuse;
+flat in vec4 InstanceSpecular;
+#define material Material(InstanceAmbient.rgb, InstanceDiffuse.rgb, InstanceSpecular.rgb, InstanceSpecular.a)
+#else
 uniform Material material;
-
-// Lighting model selection (0 = Flat, 1 = Phong)
-uniform int lightingModel;
+#endif
 
 void main()
 {
@@ -42,22 +41,24 @@ void main()
         vec3 diffuse = vec3(0.0);
         
         // Process each light
-        for (int i = 0; i < numLights && i < MAX_LIGHTS; i++) {
+        int lightCount = GetLightCount(FragPos);
+        for (int i = 0; i < lightCount; i++) {
+            PointLight light = GetLight(i);
             // Calculate light direction
-            vec3 lightDir = normalize(lights[i].position - FragPos);
+            vec3 lightDir = normalize(light.position - FragPos);
             
             // Simple diffuse calculation without interpolated normals
             float diff = max(dot(norm, lightDir), 0.0);
             
             // Simple distance attenuation
-            float distance = length(lights[i].position - FragPos);
-            float attenuation = 1.0 / (1.0 + 0.09 * distance + 0.032 * distance * distance);
+            float distance = length(light.position - FragPos);
+            float attenuation = GetLightAttenuation(light, distance);
             
             // For flat shading, we use a simpler formula without specular
-            vec3 lightDiffuse = diff * material.diffuse * lights[i].color;
+            vec3 lightDiffuse = diff * material.diffuse * light.color;
             
             // Combine lighting with flat appearance (no specular)
-            diffuse += lightDiffuse * attenuation * lights[i].intensity;
+            diffuse += lightDiffuse * attenuation * light.intensity;
         }
         
         result = ambient * 0.2 + diffuse;
@@ -70,24 +71,26 @@ void main()
         vec3 viewDir = normalize(viewPos - FragPos);
         
         // Process each light
-        for (int i = 0; i < numLights && i < MAX_LIGHTS; i++) {
+        int lightCount = GetLightCount(FragPos);
+        for (int i = 0; i < lightCount; i++) {
+            PointLight light = GetLight(i);
             // Calculate light direction and distance
-            vec3 lightDir = normalize(lights[i].position - FragPos);
-            float distance = length(lights[i].position - FragPos);
-            float attenuation = 1.0 / (1.0 + 0.09 * distance + 0.032 * distance * distance);
+            vec3 lightDir = normalize(light.position - FragPos);
+            float distance = length(light.position - FragPos);
+            float attenuation = GetLightAttenuation(light, distance);
             
             // Calculate diffuse component
             float diff = max(dot(norm, lightDir), 0.0);
-            vec3 lightDiffuse = diff * material.diffuse * lights[i].color;
+            vec3 lightDiffuse = diff * material.diffuse * light.color;
             
             // Calculate specular component (Blinn-Phong)
             vec3 halfwayDir = normalize(lightDir + viewDir);
             float spec = pow(max(dot(norm, halfwayDir), 0.0), material.shininess);
-            vec3 lightSpecular = spec * material.specular * lights[i].color;
+            vec3 lightSpecular = spec * material.specular * light.color;
             
             // Combine all lighting components with attenuation and intensity
-            diffuse += lightDiffuse * attenuation * lights[i].intensity;
-            specular += lightSpecular * attenuation * lights[i].intensity;
+            diffuse += lightDiffuse * attenuation * light.intensity;
+            specular += lightSpecular * attenuation * light.intensity;
         }
         
         result = ambient * 0.2 + diffuse + specular;
@@ -3,20 +3,95 @@
 out vec4 FragColor;
 in vec2 TexCoord;
 
+#ifdef COMPACT_GBUFFER
+uniform sampler2D gDepth;
+uniform mat4 inverseProjection;
+uniform mat4 inverseView;
+#else
 uniform sampler2D gPosition;
+#endif
 uniform sampler2D gNormal;
 uniform sampler2D gAlbedoSpec;
 
-#define MAX_LIGHTS 10
+#ifdef TILED_LIGHTING
+// Lights binned per screen tile on the CPU, see LightGrid
+uniform samplerBuffer lightBuffer;      // position + range, color + intensity per light
+uniform usamplerBuffer tileLightRanges; // offset and count into tileLightIndices per tile
+uniform usamplerBuffer tileLightIndices;
+uniform int tileSize;
+uniform int tilesX;
+#endif
+
+#define MAX_LIGHTS 128
 struct Light {
     vec3 position;
-    vec3 color;
     float intensity;
+    vec3 color;
+    float range;
+};
+
+layout (std140) uniform LightData {
+    Light lights[MAX_LIGHTS];
+    int numLights;
+};
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    int lightingModel;
 };
 
-uniform Light lights[MAX_LIGHTS];
-uniform int numLights;
-uniform vec3 viewPos;
+#ifdef COMPACT_GBUFFER
+// View-space position from the depth buffer, then back to world space where the lights live
+vec3 ReadPosition(vec2 uv)
+{
+    float depth = texture(gDepth, uv).r;
+    vec4 viewSpace = inverseProjection * vec4(uv * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    viewSpace /= viewSpace.w;
+    return (inverseView * viewSpace).xyz;
+}
+
+vec3 ReadNormal(vec2 uv)
+{
+    vec2 f = texture(gNormal, uv).rg * 2.0 - 1.0;
+    vec3 n = vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+#else
+vec3 ReadPosition(vec2 uv)
+{
+    return texture(gPosition, uv).rgb;
+}
+
+vec3 ReadNormal(vec2 uv)
+{
+    return normalize(texture(gNormal, uv).rgb);
+}
+#endif
+
+// Blinn-Phong diffuse + specular of one light. A range smoothly fades the light out at its
+// radius so culled tiles don't show seams; range 0 keeps the unbounded falloff.
+vec3 ShadeLight(vec3 lightPosition, vec3 lightColor, float lightIntensity, float lightRange,
+                vec3 FragPos, vec3 Normal, vec3 viewDir, vec3 Albedo, float SpecularIntensity, float Shininess)
+{
+    vec3 lightDir = normalize(lightPosition - FragPos);
+    float distance = length(lightPosition - FragPos);
+    float attenuation = 1.0 / (1.0 + 0.09 * distance + 0.032 * distance * distance);
+    if (lightRange > 0.0) {
+        float x = min(distance / lightRange, 1.0);
+        float window = 1.0 - x * x * x * x;
+        attenuation *= window * window;
+    }
+    float diff = max(dot(Normal, lightDir), 0.0);
+    vec3 lightDiffuse = lightIntensity * diff * lightColor * Albedo;
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(Normal, halfwayDir), 0.0), Shininess);
+    vec3 lightSpecular = lightIntensity * spec * lightColor * vec3(SpecularIntensity);
+    return (lightDiffuse + lightSpecular) * attenuation;
+}
 
 void main()
 {
@@ -28,42 +103,53 @@ void main()
         return;
     } 
     else if (debugMode == 2) {
-        vec3 Normal = texture(gNormal, TexCoord).rgb;
+        vec3 Normal = ReadNormal(TexCoord);
         Normal = Normal * 0.5 + 0.2;
         FragColor = vec4(Normal, 1.0);
         return;
     }
     else if (debugMode == 3) {
-        vec3 FragPos = texture(gPosition, TexCoord).rgb;
+        vec3 FragPos = ReadPosition(TexCoord);
         FragPos = FragPos * 0.1 + 0.2;
         FragColor = vec4(FragPos, 1.0);
         return;
     }
+#ifdef TILED_LIGHTING
+    ivec2 tile = ivec2(gl_FragCoord.xy) / tileSize;
+    uvec2 tileLights = texelFetch(tileLightRanges, tile.y * tilesX + tile.x).rg;
+    if (debugMode == 4) {
+        // Lights per tile, red at 32 and above
+        FragColor = vec4(vec3(float(tileLights.y) / 32.0, 0.0, 0.0), 1.0);
+        return;
+    }
+#endif
 
-    vec3 FragPos = texture(gPosition, TexCoord).rgb;
-    vec3 Normal = normalize(texture(gNormal, TexCoord).rgb);
-    vec3 Albedo = texture(gAlbedoSpec, TexCoord).rgb;
-    float SpecularIntensity = texture(gAlbedoSpec, TexCoord).a;
+    vec3 FragPos = ReadPosition(TexCoord);
+    vec3 Normal = ReadNormal(TexCoord);
+    vec4 AlbedoSpec = texture(gAlbedoSpec, TexCoord);
+    vec3 Albedo = AlbedoSpec.rgb;
+    float SpecularIntensity = AlbedoSpec.a;
     float Shininess = max(SpecularIntensity * 256.0, 1.0);
 
     vec3 ambient = 0.2 * Albedo;
-    vec3 diffuse = vec3(0.0);
-    vec3 specular = vec3(0.0);
+    vec3 lighting = vec3(0.0);
     vec3 viewDir = normalize(viewPos - FragPos);
 
+#ifdef TILED_LIGHTING
+    for (uint n = 0u; n < tileLights.y; n++) {
+        int index = int(texelFetch(tileLightIndices, int(tileLights.x + n)).r);
+        vec4 positionRange = texelFetch(lightBuffer, index * 2);
+        vec4 colorIntensity = texelFetch(lightBuffer, index * 2 + 1);
+        lighting += ShadeLight(positionRange.xyz, colorIntensity.rgb, colorIntensity.a, positionRange.w,
+                               FragPos, Normal, viewDir, Albedo, SpecularIntensity, Shininess);
+    }
+#else
     for (int i = 0; i < numLights && i < MAX_LIGHTS; i++) {
-        vec3 lightDir = normalize(lights[i].position - FragPos);
-        float distance = length(lights[i].position - FragPos);
-        float attenuation = 1.0 / (1.0 + 0.09 * distance + 0.032 * distance * distance);
-        float diff = max(dot(Normal, lightDir), 0.0);
-        vec3 lightDiffuse = lights[i].intensity * diff * lights[i].color * Albedo;
-        vec3 halfwayDir = normalize(lightDir + viewDir);
-        float spec = pow(max(dot(Normal, halfwayDir), 0.0), Shininess);
-        vec3 lightSpecular = lights[i].intensity * spec * lights[i].color * vec3(SpecularIntensity);
-        diffuse += lightDiffuse * attenuation;
-        specular += lightSpecular * attenuation;
+        lighting += ShadeLight(lights[i].position, lights[i].color, lights[i].intensity, lights[i].range,
+                               FragPos, Normal, viewDir, Albedo, SpecularIntensity, Shininess);
     }
+#endif
 
-    vec3 result = ambient + diffuse + specular;
+    vec3 result = ambient + lighting;
     FragColor = vec4(result, 1.0);
 }
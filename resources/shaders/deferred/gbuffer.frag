@@ -1,8 +1,14 @@
 #version 330 core
 
+#ifdef COMPACT_GBUFFER
+// Position comes from the depth buffer, normals are octahedral-encoded into RG16
+layout (location = 0) out vec2 gNormal;
+layout (location = 1) out vec4 gAlbedoSpec;
+#else
 layout (location = 0) out vec3 gPosition;
 layout (location = 1) out vec3 gNormal;
 layout (location = 2) out vec4 gAlbedoSpec;
+#endif
 
 in vec3 FragPos;
 in vec3 Normal;
@@ -14,12 +20,38 @@ struct Material {
     vec3 specular;
     float shininess;
 };
+#ifdef INSTANCED
+flat in vec4 InstanceAmbient;
+flat in vec4 InstanceDiffuse;
+flat in vec4 InstanceSpecular;
+#define material Material(InstanceAmbient.rgb, InstanceDiffuse.rgb, InstanceSpecular.rgb, InstanceSpecular.a)
+#else
 uniform Material material;
+#endif
+
+#ifdef COMPACT_GBUFFER
+vec2 OctahedronWrap(vec2 v)
+{
+    return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Unit vector to [0, 1]^2 via the octahedron unfolded onto a square
+vec2 EncodeNormal(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    n.xy = n.z >= 0.0 ? n.xy : OctahedronWrap(n.xy);
+    return n.xy * 0.5 + 0.5;
+}
+#endif
 
 void main()
 {
+#ifdef COMPACT_GBUFFER
+    gNormal = EncodeNormal(normalize(Normal));
+#else
     gPosition = FragPos;
     gNormal = normalize(Normal);
+#endif
     gAlbedoSpec.rgb = material.diffuse;
     gAlbedoSpec.a = material.shininess / 256.0;
 }
@@ -0,0 +1,6 @@
+#version 330 core
+// Description: Writes depth only, colour writes are masked during the pre-pass
+
+void main()
+{
+}
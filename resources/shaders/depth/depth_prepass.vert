@@ -0,0 +1,26 @@
+#version 330 core
+// Description: Depth-only pre-pass over the position-only vertex stream
+
+layout (location = 0) in vec3 aPos;
+
+#ifdef INSTANCED
+layout (location = 3) in mat4 aInstanceModel;
+#define model aInstanceModel
+#else
+uniform mat4 model;
+#endif
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    int lightingModel;
+};
+
+// Same expression as the colour pass shaders, so GL_EQUAL passes exactly where they draw
+invariant gl_Position;
+
+void main()
+{
+    vec3 FragPos = vec3(model * vec4(aPos, 1.0));
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
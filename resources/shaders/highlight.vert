@@ -1,24 +0,0 @@
-#version 330 core
-// Description: Shader for highlighting selected objects
-
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
-layout (location = 2) in vec2 aTexCoords;
-
-out vec3 FragPos;
-out vec3 Normal;
-out vec2 TexCoords;
-
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
-void main()
-{
-    // Slightly enlarge the model to make it slightly bigger than the original
-    vec3 scaled_pos = aPos * 1.02;
-    FragPos = vec3(model * vec4(scaled_pos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
-    TexCoords = aTexCoords;
-    gl_Position = projection * view * vec4(FragPos, 1.0);
-}
@@ -0,0 +1,77 @@
+// Light access shared by the forward fragment shaders. Declare the FrameData block first.
+//
+//   int lightCount = GetLightCount(FragPos);
+//   for (int i = 0; i < lightCount; i++) {
+//       PointLight light = GetLight(i);
+//       float attenuation = GetLightAttenuation(light, length(light.position - FragPos));
+//   }
+//
+// The CLUSTERED_LIGHTING variant, used by the clustered forward mode, only visits the lights
+// assigned to the fragment's cluster (see ClusterGrid). Otherwise the LightData block is walked.
+
+struct PointLight {
+    vec3 position;
+    float intensity;
+    vec3 color;
+    float range;
+};
+
+#ifdef CLUSTERED_LIGHTING
+uniform samplerBuffer clusterLightData;      // position + range, color + intensity per light
+uniform usamplerBuffer clusterLightRanges;   // offset and count into clusterLightIndices per cluster
+uniform usamplerBuffer clusterLightIndices;
+uniform vec3 clusterDims;                   // clusters along x, y and depth
+uniform vec2 clusterTileSize;                // pixels covered by one cluster column
+uniform vec2 clusterDepthParams;             // depth slice = log(viewDepth) * x + y
+
+uint clusterLightOffset = 0u;
+
+int GetLightCount(vec3 worldPos)
+{
+    float viewDepth = max(-(view * vec4(worldPos, 1.0)).z, 1e-4);
+    ivec3 dims = ivec3(clusterDims);
+    int slice = clamp(int(log(viewDepth) * clusterDepthParams.x + clusterDepthParams.y), 0, dims.z - 1);
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy / clusterTileSize), ivec2(0), dims.xy - 1);
+    int cluster = (slice * dims.y + tile.y) * dims.x + tile.x;
+
+    uvec2 lightRange = texelFetch(clusterLightRanges, cluster).rg;
+    clusterLightOffset = lightRange.x;
+    return int(lightRange.y);
+}
+
+PointLight GetLight(int i)
+{
+    int index = int(texelFetch(clusterLightIndices, int(clusterLightOffset) + i).r);
+    vec4 positionRange = texelFetch(clusterLightData, index * 2);
+    vec4 colorIntensity = texelFetch(clusterLightData, index * 2 + 1);
+    return PointLight(positionRange.xyz, colorIntensity.a, colorIntensity.rgb, positionRange.w);
+}
+#else
+#define MAX_LIGHTS 128
+layout (std140) uniform LightData {
+    PointLight lights[MAX_LIGHTS];
+    int numLights;
+};
+
+int GetLightCount(vec3 worldPos)
+{
+    return min(numLights, MAX_LIGHTS);
+}
+
+PointLight GetLight(int i)
+{
+    return lights[i];
+}
+#endif
+
+// Distance falloff; lights with a range fade out smoothly at it so clusters don't show seams
+float GetLightAttenuation(PointLight light, float distance)
+{
+    float attenuation = 1.0 / (1.0 + 0.09 * distance + 0.032 * distance * distance);
+    if (light.range > 0.0) {
+        float x = min(distance / light.range, 1.0);
+        float window = 1.0 - x * x * x * x;
+        attenuation *= window * window;
+    }
+    return attenuation;
+}
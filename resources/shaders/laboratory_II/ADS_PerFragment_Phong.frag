@@ -16,15 +16,17 @@ uniform struct Material {
     float shininess;
 } material;
 
-#define MAX_LIGHTS 10
+#define MAX_LIGHTS 128
 struct Light {
     vec3 position;
-    vec3 color;
     float intensity;
+    vec3 color;
 };
 
-uniform Light lights[MAX_LIGHTS];
-uniform int numLights;
+layout (std140) uniform LightData {
+    Light lights[MAX_LIGHTS];
+    int numLights;
+};
 uniform float time;
 
 void main()
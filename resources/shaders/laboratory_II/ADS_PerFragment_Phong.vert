@@ -12,19 +12,27 @@ out vec3 ViewDir;
 out vec2 TexCoords;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform vec3 viewPos;
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    int lightingModel;
+};
 uniform float time;
 
-#define MAX_LIGHTS 10
+#define MAX_LIGHTS 128
 struct Light {
     vec3 position;
-    vec3 color;
     float intensity;
+    vec3 color;
 };
-uniform Light lights[MAX_LIGHTS];
-uniform int numLights;
+layout (std140) uniform LightData {
+    Light lights[MAX_LIGHTS];
+    int numLights;
+};
+
+// Depth must match the depth pre-pass exactly for its GL_EQUAL test
+invariant gl_Position;
 
 void main()
 {
@@ -12,10 +12,12 @@ out vec2 TexCoords;
 
 // Uniforms
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform vec3 lightPos;  // Light position in world space
-uniform vec3 viewPos;   // View/camera position in world space
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    int lightingModel;
+};
 
 // Material properties
 uniform struct Material {
@@ -25,18 +27,23 @@ uniform struct Material {
     float shininess;
 } material;
 
-#define MAX_LIGHTS 10
+#define MAX_LIGHTS 128
 struct Light {
     vec3 position;
-    vec3 color;
     float intensity;
+    vec3 color;
 };
 
 // Light properties
-uniform Light lights[MAX_LIGHTS];
-uniform int numLights;
+layout (std140) uniform LightData {
+    Light lights[MAX_LIGHTS];
+    int numLights;
+};
 uniform float time; // Global time for animations
 
+// Depth must match the depth pre-pass exactly for its GL_EQUAL test
+invariant gl_Position;
+
 void main()
 {
     vec3 worldPos = vec3(model * vec4(aPos, 1.0));
@@ -9,10 +9,12 @@ out vec4 vColor;
 out vec2 TexCoords;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform vec3 lightPos;
-uniform vec3 viewPos;
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    int lightingModel;
+};
 
 uniform struct Material {
     vec3 ambient;
@@ -21,17 +23,22 @@ uniform struct Material {
     float shininess;
 } material;
 
-#define MAX_LIGHTS 10
+#define MAX_LIGHTS 128
 struct Light {
     vec3 position;
-    vec3 color;
     float intensity;
+    vec3 color;
 };
 
-uniform Light lights[MAX_LIGHTS];
-uniform int numLights;
+layout (std140) uniform LightData {
+    Light lights[MAX_LIGHTS];
+    int numLights;
+};
 uniform float time;
 
+// Depth must match the depth pre-pass exactly for its GL_EQUAL test
+invariant gl_Position;
+
 void main()
 {
     vec3 worldPos = vec3(model * vec4(aPos, 1.0));
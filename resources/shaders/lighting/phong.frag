@@ -7,17 +7,14 @@ in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
 
-#define MAX_LIGHTS 10
-struct Light {
-    vec3 position;
-    vec3 color;
-    float intensity;
-};
-
-uniform Light lights[MAX_LIGHTS];
-uniform int numLights;
 uniform float time;
-uniform vec3 viewPos;
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    int lightingModel;
+};
+#include "../include/lights.glsl"
 
 struct Material {
     vec3 ambient;
@@ -25,7 +22,14 @@ struct Material {
     vec3 specular;
     float shininess;
 };
+#ifdef INSTANCED
+flat in vec4 InstanceAmbient;
+flat in vec4 InstanceDiffuse;
+flat in vec4 InstanceSpecular;
+#define material Material(InstanceAmbient.rgb, InstanceDiffuse.rgb, InstanceSpecular.rgb, InstanceSpecular.a)
+#else
 uniform Material material;
+#endif
 
 void main()
 {
@@ -36,16 +40,18 @@ void main()
     vec3 diffuse = vec3(0.0);
     vec3 specular = vec3(0.0);
 
-    for (int i = 0; i < numLights && i < MAX_LIGHTS; i++) {
-        vec3 lightDir = normalize(lights[i].position - FragPos);
+    int lightCount = GetLightCount(FragPos);
+    for (int i = 0; i < lightCount; i++) {
+        PointLight light = GetLight(i);
+        vec3 lightDir = normalize(light.position - FragPos);
         float diff = max(dot(norm, lightDir), 0.0);
-        float distance = length(lights[i].position - FragPos);
-        float attenuation = 1.0 / (1.0 + 0.09 * distance + 0.032 * distance * distance);
-        diffuse += diff * material.diffuse * lights[i].color * lights[i].intensity * attenuation;
+        float distance = length(light.position - FragPos);
+        float attenuation = GetLightAttenuation(light, distance);
+        diffuse += diff * material.diffuse * light.color * light.intensity * attenuation;
         float specularStrength = 0.5;
         vec3 reflectDir = reflect(-lightDir, norm);
         float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-        specular += specularStrength * spec * material.specular * lights[i].color * lights[i].intensity * attenuation;
+        specular += specularStrength * spec * material.specular * light.color * light.intensity * attenuation;
     }
 
     vec3 result = ambient + diffuse + specular;
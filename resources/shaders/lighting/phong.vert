@@ -9,12 +9,36 @@ out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
 
+#ifdef INSTANCED
+// Per-instance transform and material, see InstanceData
+layout (location = 3) in mat4 aInstanceModel;
+layout (location = 7) in vec4 aInstanceAmbient;
+layout (location = 8) in vec4 aInstanceDiffuse;
+layout (location = 9) in vec4 aInstanceSpecular;
+flat out vec4 InstanceAmbient;
+flat out vec4 InstanceDiffuse;
+flat out vec4 InstanceSpecular;
+#define model aInstanceModel
+#else
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#endif
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    int lightingModel;
+};
+
+// Depth must match the depth pre-pass exactly for its GL_EQUAL test
+invariant gl_Position;
 
 void main()
 {
+#ifdef INSTANCED
+    InstanceAmbient = aInstanceAmbient;
+    InstanceDiffuse = aInstanceDiffuse;
+    InstanceSpecular = aInstanceSpecular;
+#endif
     FragPos = vec3(model * vec4(aPos, 1.0));
     Normal = mat3(transpose(inverse(model))) * aNormal;
     TexCoords = aTexCoords;
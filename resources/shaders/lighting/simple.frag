@@ -7,15 +7,17 @@ in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
 
-#define MAX_LIGHTS 10
+#define MAX_LIGHTS 128
 struct Light {
     vec3 position;
-    vec3 color;
     float intensity;
+    vec3 color;
 };
 
-uniform Light lights[MAX_LIGHTS];
-uniform int numLights;
+layout (std140) uniform LightData {
+    Light lights[MAX_LIGHTS];
+    int numLights;
+};
 uniform float time;
 
 struct Material {
@@ -24,7 +26,14 @@ struct Material {
     vec3 specular;
     float shininess;
 };
+#ifdef INSTANCED
+flat in vec4 InstanceAmbient;
+flat in vec4 InstanceDiffuse;
+flat in vec4 InstanceSpecular;
+#define material Material(InstanceAmbient.rgb, InstanceDiffuse.rgb, InstanceSpecular.rgb, InstanceSpecular.a)
+#else
 uniform Material material;
+#endif
 
 void main()
 {
@@ -0,0 +1,24 @@
+#version 330 core
+// Description: Scales a frame rendered below display resolution up to the window
+
+in vec2 TexCoord;
+
+out vec4 FragColor;
+
+uniform sampler2D sceneColor;   // Bilinear filtered
+uniform float sharpness;        // 0 = plain bilinear upscale
+
+void main()
+{
+    vec3 color = texture(sceneColor, TexCoord).rgb;
+    
+    // Unsharp mask over the neighbouring source texels brings back some of the edge contrast the filter loses
+    vec2 texel = 1.0 / vec2(textureSize(sceneColor, 0));
+    vec3 neighbours = texture(sceneColor, TexCoord + vec2(texel.x, 0.0)).rgb +
+                      texture(sceneColor, TexCoord - vec2(texel.x, 0.0)).rgb +
+                      texture(sceneColor, TexCoord + vec2(0.0, texel.y)).rgb +
+                      texture(sceneColor, TexCoord - vec2(0.0, texel.y)).rgb;
+    color = clamp(color + sharpness * (color - neighbours * 0.25), 0.0, 1.0);
+    
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,9 @@
+#version 330 core
+// Description: Marks covered pixels in the selection mask
+
+out float MaskValue;
+
+void main()
+{
+    MaskValue = 1.0;
+}
@@ -0,0 +1,17 @@
+#version 330 core
+// Description: Writes selected objects into the selection mask, all instances of a mesh in one draw
+
+layout (location = 0) in vec3 aPos;
+layout (location = 3) in mat4 aInstanceModel;
+
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    int lightingModel;
+};
+
+void main()
+{
+    gl_Position = projection * view * aInstanceModel * vec4(aPos, 1.0);
+}
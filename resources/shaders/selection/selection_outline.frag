@@ -0,0 +1,40 @@
+#version 330 core
+// Description: Draws a pulsing outline around the pixels set in the selection mask
+
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform sampler2D selectionMask;
+uniform vec4 outlineColor;
+uniform int outlineWidth;
+uniform float time;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 maxPixel = textureSize(selectionMask, 0) - 1;
+
+    // Inside of the selection stays untouched
+    if (texelFetch(selectionMask, pixel, 0).r > 0.0)
+        discard;
+
+    // Outline wherever a selected pixel lies within outlineWidth
+    float coverage = 0.0;
+    for (int y = -outlineWidth; y <= outlineWidth; y++)
+    {
+        for (int x = -outlineWidth; x <= outlineWidth; x++)
+        {
+            if (x * x + y * y > outlineWidth * outlineWidth)
+                continue;
+            ivec2 samplePixel = clamp(pixel + ivec2(x, y), ivec2(0), maxPixel);
+            coverage = max(coverage, texelFetch(selectionMask, samplePixel, 0).r);
+        }
+    }
+
+    if (coverage == 0.0)
+        discard;
+
+    float pulse = 0.75 + 0.25 * sin(time * 3.0);
+    FragColor = vec4(outlineColor.rgb, outlineColor.a * pulse);
+}
@@ -9,15 +9,6 @@ in VS_OUT {
 
 out vec4 FragColor;
 
-#define MAX_LIGHTS 10
-struct Light {
-    vec3 position;
-    vec3 color;
-    float intensity;
-};
-
-uniform Light lights[MAX_LIGHTS];
-uniform int numLights;
 
 struct Material {
     vec3 ambient;
@@ -30,7 +21,13 @@ uniform Material material;
 const float REFLECTIVITY = 0.8;
 const float FRESNEL_FACTOR = 5.0;
 const vec3 CHROME_COLOR = vec3(0.8, 0.8, 0.9);
-uniform vec3 viewPos;
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    int lightingModel;
+};
+#include "../include/lights.glsl"
 
 void main()
 {
@@ -46,14 +43,16 @@ void main()
     vec3 diffuse = vec3(0.0);
     vec3 specular = vec3(0.0);
 
-    for (int i = 0; i < numLights && i < MAX_LIGHTS; i++) {
-        vec3 lightPos = lights[i].position;
-        vec3 lightColor = lights[i].color;
-        float lightIntensity = lights[i].intensity;
+    int lightCount = GetLightCount(fs_in.FragPos);
+    for (int i = 0; i < lightCount; i++) {
+        PointLight light = GetLight(i);
+        vec3 lightPos = light.position;
+        vec3 lightColor = light.color;
+        float lightIntensity = light.intensity;
         vec3 lightDir = normalize(lightPos - fs_in.FragPos);
         vec3 halfwayDir = normalize(lightDir + viewDir);
         float distance = length(lightPos - fs_in.FragPos);
-        float attenuation = 1.0 / (1.0 + 0.09 * distance + 0.032 * distance * distance);
+        float attenuation = GetLightAttenuation(light, distance);
         float diff = max(dot(normal, lightDir), 0.0);
         diffuse += diff * material.diffuse * lightColor * attenuation * lightIntensity;
         float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
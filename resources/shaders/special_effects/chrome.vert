@@ -12,9 +12,15 @@ out VS_OUT {
 } vs_out;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform vec3 viewPos;
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    int lightingModel;
+};
+
+// Depth must match the depth pre-pass exactly for its GL_EQUAL test
+invariant gl_Position;
 
 void main()
 {
@@ -23,5 +29,5 @@ void main()
     vs_out.Normal = transpose(inverse(mat3(model))) * aNormal;
     vec3 viewDir = normalize(viewPos - vs_out.FragPos);
     vs_out.ReflectDir = reflect(-viewDir, normalize(vs_out.Normal));
-    gl_Position = projection * view * worldPos;
+    gl_Position = projection * view * vec4(vs_out.FragPos, 1.0);
 }
@@ -17,16 +17,13 @@ struct Material {
 };
 uniform Material material;
 
-#define MAX_LIGHTS 10
-struct Light {
-    vec3 position;
-    vec3 color;
-    float intensity;
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    int lightingModel;
 };
-
-uniform Light lights[MAX_LIGHTS];
-uniform int numLights;
-uniform vec3 viewPos;
+#include "../include/lights.glsl"
 
 const int levels = 4;
 const float scaleFactor = 1.0 / levels;
@@ -41,14 +38,16 @@ void main()
     vec3 diffuse = vec3(0.0);
     vec3 specular = vec3(0.0);
 
-    for (int i = 0; i < numLights && i < MAX_LIGHTS; i++) {
-        vec3 lightPos = lights[i].position;
-        vec3 lightColor = lights[i].color;
-        float lightIntensity = lights[i].intensity;
+    int lightCount = GetLightCount(fs_in.FragPos);
+    for (int i = 0; i < lightCount; i++) {
+        PointLight light = GetLight(i);
+        vec3 lightPos = light.position;
+        vec3 lightColor = light.color;
+        float lightIntensity = light.intensity;
         vec3 lightDir = normalize(lightPos - fs_in.FragPos);
         vec3 halfwayDir = normalize(lightDir + viewDir);
         float distance = length(lightPos - fs_in.FragPos);
-        float attenuation = 1.0 / (1.0 + 0.09 * distance + 0.032 * distance * distance);
+        float attenuation = GetLightAttenuation(light, distance);
         float diffStrength = max(dot(normal, lightDir), 0.0);
         diffStrength = floor(diffStrength * levels) * scaleFactor;
         diffuse += diffStrength * material.diffuse * lightColor * attenuation * lightIntensity;
@@ -12,8 +12,15 @@ out VS_OUT {
 } vs_out;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    int lightingModel;
+};
+
+// Depth must match the depth pre-pass exactly for its GL_EQUAL test
+invariant gl_Position;
 
 void main()
 {
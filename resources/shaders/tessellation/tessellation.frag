@@ -6,10 +6,24 @@ in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoord;
 
-uniform vec3 lightPos;
-uniform vec3 viewPos;
-uniform vec3 lightColor;
-uniform float lightIntensity;
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    int lightingModel;
+};
+
+#define MAX_LIGHTS 128
+struct Light {
+    vec3 position;
+    float intensity;
+    vec3 color;
+};
+
+layout (std140) uniform LightData {
+    Light lights[MAX_LIGHTS];
+    int numLights;
+};
 
 struct Material {
     vec3 ambient;
@@ -21,6 +35,11 @@ uniform Material material;
 
 void main()
 {
+    // Tessellated surfaces are lit by the first scene light only
+    vec3 lightPos = lights[0].position;
+    vec3 lightColor = numLights > 0 ? lights[0].color : vec3(0.0);
+    float lightIntensity = numLights > 0 ? lights[0].intensity : 0.0;
+
     vec3 ambient = 0.1 * material.ambient;
     vec3 norm = normalize(Normal);
     vec3 lightDir = normalize(lightPos - FragPos);
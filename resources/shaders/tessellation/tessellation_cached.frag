@@ -0,0 +1 @@
+#include "tessellation.frag"
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""Writes the many-lights benchmark scene used by OpenGLLearningBench.
+
+A grid of primitives on a floor, lit by thousands of small point lights with a finite
+range so tiled deferred lighting can cull them per tile. The output is deterministic.
+
+Usage: python scripts/generate_many_lights_scene.py [--lights N] [--grid N] [--output path]
+"""
+
+import argparse
+import colorsys
+import json
+import random
+
+PRIMITIVES = ["Cube", "Sphere", "Cylinder", "Cone"]
+
+
+def make_object(name, primitive, position, scale, diffuse):
+    return {
+        "material": {
+            "ambient": [0.1, 0.1, 0.1],
+            "diffuse": diffuse,
+            "shininess": 32.0,
+            "specular": [0.5, 0.5, 0.5],
+        },
+        "name": name,
+        "objectType": "primitive",
+        "position": position,
+        "primitiveType": primitive,
+        "rotation": [0.0, 0.0, 0.0],
+        "scale": scale,
+        "shader": "default",
+        "visible": True,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--lights", type=int, default=2048)
+    parser.add_argument("--grid", type=int, default=16)
+    parser.add_argument("--spacing", type=float, default=2.5)
+    parser.add_argument("--seed", type=int, default=1234)
+    parser.add_argument("--output", default="resources/scenes/benchmark/many_lights.json")
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    extent = args.grid * args.spacing
+    half = extent / 2.0
+
+    objects = [make_object("Plane_Floor", "Plane", [0.0, -0.5, 0.0], [extent, 1.0, extent], [0.7, 0.7, 0.7])]
+    for z in range(args.grid):
+        for x in range(args.grid):
+            primitive = PRIMITIVES[(x + z) % len(PRIMITIVES)]
+            position = [-half + (x + 0.5) * args.spacing, 0.0, -half + (z + 0.5) * args.spacing]
+            objects.append(make_object(f"{primitive}_{z * args.grid + x + 1}", primitive, position, [1.0, 1.0, 1.0], [0.8, 0.8, 0.8]))
+
+    lights = []
+    for _ in range(args.lights):
+        r, g, b = colorsys.hsv_to_rgb(rng.random(), 0.7, 1.0)
+        lights.append({
+            "color": [round(r, 3), round(g, 3), round(b, 3)],
+            "intensity": round(rng.uniform(0.5, 1.5), 3),
+            "position": [round(rng.uniform(-half, half), 3), round(rng.uniform(0.25, 2.0), 3), round(rng.uniform(-half, half), 3)],
+            "range": round(rng.uniform(1.5, 3.5), 3),
+        })
+
+    with open(args.output, "w") as f:
+        json.dump({"lights": lights, "objects": objects}, f, indent=4)
+    print(f"Wrote {args.output}: {len(objects)} objects, {len(lights)} lights")
+
+
+if __name__ == "__main__":
+    main()
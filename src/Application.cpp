@@ -5,6 +5,7 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 #include "ResourceManager.h"
+#include "Profiler.h"
 
 Application* Application::instance = nullptr;
 
@@ -21,6 +22,8 @@ Application::~Application()
 
 bool Application::Initialize()
 {
+    PROFILE_SCOPE("Application::Initialize");
+    
     if (!glfwInit())
     {
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -66,8 +69,10 @@ bool Application::Initialize()
     ui->RefreshShaderLibrary();
 
     glfwSetFramebufferSizeCallback(window, []([[maybe_unused]] GLFWwindow* window, int width, int height) {
-        glViewport(0, 0, width, height);
         Application* app = Application::GetInstance();
+        // The renderer resizes its targets and sets the viewport at the start of the next frame
+        if (app && app->GetRenderer())
+            app->GetRenderer()->SetDisplaySize(width, height);
         if (app && app->GetCamera()) {
             if (height == 0 || width == 0) return;
             app->GetCamera()->SetAspectRatio(static_cast<float>(width) / static_cast<float>(height));
@@ -85,20 +90,31 @@ void Application::Run()
     // Main loop
     while (running && !glfwWindowShouldClose(window))
     {
-        float currentTime = static_cast<float>(glfwGetTime());
-        deltaTime = currentTime - lastFrameTime;
-        lastFrameTime = currentTime;
-
-        ProcessInput();
-        Update();
-        Render();
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        {
+            PROFILE_SCOPE("Frame");
+            
+            float currentTime = static_cast<float>(glfwGetTime());
+            deltaTime = currentTime - lastFrameTime;
+            lastFrameTime = currentTime;
+
+            ProcessInput();
+            Update();
+            Render();
+            
+            {
+                PROFILE_SCOPE("SwapBuffers");
+                glfwSwapBuffers(window);
+            }
+            glfwPollEvents();
+        }
+        PROFILE_FRAME();
     }
 }
 
 void Application::ProcessInput()
 {
+    PROFILE_SCOPE("Application::ProcessInput");
+    
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         running = false;
 
@@ -110,6 +126,8 @@ void Application::ProcessInput()
 
 void Application::Update()
 {
+    PROFILE_SCOPE("Application::Update");
+    
     if (scene)
         scene->Update(deltaTime);
 
@@ -119,6 +137,8 @@ void Application::Update()
 
 void Application::Render()
 {
+    PROFILE_SCOPE("Application::Render");
+    
     if (renderer && scene && camera)
     {
         renderer->BeginFrame();
@@ -127,7 +147,10 @@ void Application::Render()
         if (ui)
         {
             renderer->PrepareForUIRendering();
+            renderer->GetGpuProfiler().BeginPass("UI");
+            PROFILE_SCOPE("UI::Render");
             ui->Render();
+            renderer->GetGpuProfiler().EndPass();
             renderer->RestoreAfterUIRendering();
         }
             
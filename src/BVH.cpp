@@ -0,0 +1,524 @@
+#include "BVH.h"
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+namespace {
+    BoundingBox Union(const BoundingBox& a, const BoundingBox& b)
+    {
+        return BoundingBox(glm::min(a.min, b.min), glm::max(a.max, b.max));
+    }
+
+    inline void Prefetch(const void* address)
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#elif defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(address);
+#endif
+    }
+}
+
+DynamicBVH::DynamicBVH(float margin)
+    : margin(margin)
+{
+}
+
+int DynamicBVH::AllocateNode()
+{
+    int nodeId;
+    if (freeList == NullNode)
+    {
+        nodes.emplace_back();
+        links.emplace_back();
+        nodeId = static_cast<int>(nodes.size()) - 1;
+    }
+    else
+    {
+        nodeId = freeList;
+        freeList = links[nodeId].parent;
+        nodes[nodeId] = Node();
+        links[nodeId] = NodeLinks();
+    }
+
+    links[nodeId].height = 0;
+    return nodeId;
+}
+
+void DynamicBVH::FreeNode(int nodeId)
+{
+    nodes[nodeId] = Node();
+    links[nodeId] = NodeLinks();
+    links[nodeId].parent = freeList;
+    freeList = nodeId;
+}
+
+int DynamicBVH::CreateProxy(const BoundingBox& box, void* userData)
+{
+    int proxyId = AllocateNode();
+    nodes[proxyId].box = BoundingBox(box.min - glm::vec3(margin), box.max + glm::vec3(margin));
+    links[proxyId].userData = userData;
+
+    InsertLeaf(proxyId);
+    proxyCount++;
+    return proxyId;
+}
+
+void DynamicBVH::DestroyProxy(int proxyId)
+{
+    // Freed nodes also read as leaves; their height of -1 tells a stale or repeated id apart
+    bool valid = proxyId >= 0 && proxyId < static_cast<int>(nodes.size()) &&
+                 nodes[proxyId].IsLeaf() && links[proxyId].height >= 0;
+    assert(valid && "DestroyProxy called with a stale or invalid proxy id");
+    if (!valid)
+        return;
+
+    RemoveLeaf(proxyId);
+    FreeNode(proxyId);
+    proxyCount--;
+}
+
+bool DynamicBVH::MoveProxy(int proxyId, const BoundingBox& box)
+{
+    if (nodes[proxyId].box.Contains(box))
+        return false;
+
+    RemoveLeaf(proxyId);
+    nodes[proxyId].box = BoundingBox(box.min - glm::vec3(margin), box.max + glm::vec3(margin));
+    InsertLeaf(proxyId);
+    return true;
+}
+
+void DynamicBVH::Clear()
+{
+    nodes.clear();
+    links.clear();
+    root = NullNode;
+    freeList = NullNode;
+    proxyCount = 0;
+}
+
+void DynamicBVH::InsertLeaf(int leaf)
+{
+    if (root == NullNode)
+    {
+        root = leaf;
+        links[root].parent = NullNode;
+        return;
+    }
+
+    // Descend towards the sibling with the smallest surface area increase
+    BoundingBox leafBox = nodes[leaf].box;
+    int index = root;
+    while (!nodes[index].IsLeaf())
+    {
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+
+        float area = nodes[index].box.GetSurfaceArea();
+        float combinedArea = Union(nodes[index].box, leafBox).GetSurfaceArea();
+
+        // Cost of pairing the leaf with this node, and the cost pushed down to the children
+        float cost = 2.0f * combinedArea;
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](int child) {
+            float newArea = Union(leafBox, nodes[child].box).GetSurfaceArea();
+            if (nodes[child].IsLeaf())
+                return newArea + inheritanceCost;
+            return (newArea - nodes[child].box.GetSurfaceArea()) + inheritanceCost;
+        };
+
+        float cost1 = descendCost(child1);
+        float cost2 = descendCost(child2);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+
+        index = (cost1 < cost2) ? child1 : child2;
+    }
+
+    int sibling = index;
+    int oldParent = links[sibling].parent;
+    int newParent = AllocateNode();
+    links[newParent].parent = oldParent;
+    nodes[newParent].box = Union(leafBox, nodes[sibling].box);
+    links[newParent].height = links[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    links[sibling].parent = newParent;
+    links[leaf].parent = newParent;
+
+    if (oldParent != NullNode)
+    {
+        if (nodes[oldParent].child1 == sibling)
+            nodes[oldParent].child1 = newParent;
+        else
+            nodes[oldParent].child2 = newParent;
+    }
+    else
+    {
+        root = newParent;
+    }
+
+    // Refit and rebalance the ancestors
+    index = links[leaf].parent;
+    while (index != NullNode)
+    {
+        index = Balance(index);
+
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+        links[index].height = 1 + std::max(links[child1].height, links[child2].height);
+        nodes[index].box = Union(nodes[child1].box, nodes[child2].box);
+
+        index = links[index].parent;
+    }
+}
+
+void DynamicBVH::RemoveLeaf(int leaf)
+{
+    if (leaf == root)
+    {
+        root = NullNode;
+        return;
+    }
+
+    int parent = links[leaf].parent;
+    int grandParent = links[parent].parent;
+    int sibling = (nodes[parent].child1 == leaf) ? nodes[parent].child2 : nodes[parent].child1;
+
+    if (grandParent == NullNode)
+    {
+        root = sibling;
+        links[sibling].parent = NullNode;
+        FreeNode(parent);
+        return;
+    }
+
+    // Replace the parent by the sibling and refit upwards
+    if (nodes[grandParent].child1 == parent)
+        nodes[grandParent].child1 = sibling;
+    else
+        nodes[grandParent].child2 = sibling;
+    links[sibling].parent = grandParent;
+    FreeNode(parent);
+
+    int index = grandParent;
+    while (index != NullNode)
+    {
+        index = Balance(index);
+
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+        nodes[index].box = Union(nodes[child1].box, nodes[child2].box);
+        links[index].height = 1 + std::max(links[child1].height, links[child2].height);
+
+        index = links[index].parent;
+    }
+}
+
+int DynamicBVH::Balance(int iA)
+{
+    Node& A = nodes[iA];
+    NodeLinks& linksA = links[iA];
+    if (A.IsLeaf() || linksA.height < 2)
+        return iA;
+
+    int iB = A.child1;
+    int iC = A.child2;
+    Node& B = nodes[iB];
+    Node& C = nodes[iC];
+    NodeLinks& linksB = links[iB];
+    NodeLinks& linksC = links[iC];
+
+    int balance = linksC.height - linksB.height;
+
+    // Rotate C up
+    if (balance > 1)
+    {
+        int iF = C.child1;
+        int iG = C.child2;
+        Node& F = nodes[iF];
+        Node& G = nodes[iG];
+        NodeLinks& linksF = links[iF];
+        NodeLinks& linksG = links[iG];
+
+        C.child1 = iA;
+        linksC.parent = linksA.parent;
+        linksA.parent = iC;
+
+        if (linksC.parent != NullNode)
+        {
+            if (nodes[linksC.parent].child1 == iA)
+                nodes[linksC.parent].child1 = iC;
+            else
+                nodes[linksC.parent].child2 = iC;
+        }
+        else
+        {
+            root = iC;
+        }
+
+        if (linksF.height > linksG.height)
+        {
+            C.child2 = iF;
+            A.child2 = iG;
+            linksG.parent = iA;
+            A.box = Union(B.box, G.box);
+            C.box = Union(A.box, F.box);
+            linksA.height = 1 + std::max(linksB.height, linksG.height);
+            linksC.height = 1 + std::max(linksA.height, linksF.height);
+        }
+        else
+        {
+            C.child2 = iG;
+            A.child2 = iF;
+            linksF.parent = iA;
+            A.box = Union(B.box, F.box);
+            C.box = Union(A.box, G.box);
+            linksA.height = 1 + std::max(linksB.height, linksF.height);
+            linksC.height = 1 + std::max(linksA.height, linksG.height);
+        }
+
+        return iC;
+    }
+
+    // Rotate B up
+    if (balance < -1)
+    {
+        int iD = B.child1;
+        int iE = B.child2;
+        Node& D = nodes[iD];
+        Node& E = nodes[iE];
+        NodeLinks& linksD = links[iD];
+        NodeLinks& linksE = links[iE];
+
+        B.child1 = iA;
+        linksB.parent = linksA.parent;
+        linksA.parent = iB;
+
+        if (linksB.parent != NullNode)
+        {
+            if (nodes[linksB.parent].child1 == iA)
+                nodes[linksB.parent].child1 = iB;
+            else
+                nodes[linksB.parent].child2 = iB;
+        }
+        else
+        {
+            root = iB;
+        }
+
+        if (linksD.height > linksE.height)
+        {
+            B.child2 = iD;
+            A.child1 = iE;
+            linksE.parent = iA;
+            A.box = Union(C.box, E.box);
+            B.box = Union(A.box, D.box);
+            linksA.height = 1 + std::max(linksC.height, linksE.height);
+            linksB.height = 1 + std::max(linksA.height, linksD.height);
+        }
+        else
+        {
+            B.child2 = iE;
+            A.child1 = iD;
+            linksD.parent = iA;
+            A.box = Union(C.box, D.box);
+            B.box = Union(A.box, E.box);
+            linksA.height = 1 + std::max(linksC.height, linksD.height);
+            linksB.height = 1 + std::max(linksA.height, linksE.height);
+        }
+
+        return iB;
+    }
+
+    return iA;
+}
+
+void DynamicBVH::QueryFrustum(const Frustum& frustum, std::vector<void*>& results) const
+{
+    if (root == NullNode)
+        return;
+
+    // Planes with their absolute normals, so a box is tested from its centre and extents with
+    // two dot products instead of picking a corner per axis
+    glm::vec4 planes[Frustum::PlaneCount];
+    glm::vec3 absNormals[Frustum::PlaneCount];
+    for (int i = 0; i < Frustum::PlaneCount; i++)
+    {
+        planes[i] = frustum.GetPlane(i);
+        absNormals[i] = glm::abs(glm::vec3(planes[i]));
+    }
+
+    // Each entry carries the planes its parent still straddled; planes a node is fully inside
+    // are dropped for its subtree, so subtrees inside every plane are walked without tests.
+    // Nodes are visited breadth first: the next node's index is known long before it is read,
+    // so prefetching children when they are queued overlaps the cache misses of the traversal.
+    constexpr unsigned int allPlanes = (1u << Frustum::PlaneCount) - 1;
+    frustumQueue.clear();
+    frustumQueue.emplace_back(root, allPlanes);
+
+    for (std::size_t head = 0; head < frustumQueue.size(); head++)
+    {
+        auto [nodeId, planeMask] = frustumQueue[head];
+        const Node& node = nodes[nodeId];
+
+        if (planeMask != 0)
+        {
+            glm::vec3 center = node.box.GetCenter();
+            glm::vec3 extents = node.box.GetExtents();
+
+            bool outside = false;
+            for (int i = 0; i < Frustum::PlaneCount; i++)
+            {
+                unsigned int bit = 1u << i;
+                if (!(planeMask & bit))
+                    continue;
+
+                float distance = glm::dot(glm::vec3(planes[i]), center) + planes[i].w;
+                float radius = glm::dot(absNormals[i], extents);
+                if (distance + radius < 0.0f)
+                {
+                    outside = true;
+                    break;
+                }
+                if (distance - radius >= 0.0f)
+                    planeMask &= ~bit;
+            }
+
+            if (outside)
+                continue;
+        }
+
+        if (node.IsLeaf())
+        {
+            results.push_back(links[nodeId].userData);
+        }
+        else
+        {
+            Prefetch(&nodes[node.child1]);
+            Prefetch(&nodes[node.child2]);
+            frustumQueue.emplace_back(node.child1, planeMask);
+            frustumQueue.emplace_back(node.child2, planeMask);
+        }
+    }
+}
+
+void DynamicBVH::QueryBox(const BoundingBox& box, std::vector<void*>& results) const
+{
+    if (root == NullNode)
+        return;
+
+    stack.clear();
+    stack.push_back(root);
+    while (!stack.empty())
+    {
+        int nodeId = stack.back();
+        stack.pop_back();
+
+        const Node& node = nodes[nodeId];
+        if (!node.box.Intersects(box))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            results.push_back(links[nodeId].userData);
+        }
+        else
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void DynamicBVH::QuerySphere(const BoundingSphere& sphere, std::vector<void*>& results) const
+{
+    if (root == NullNode)
+        return;
+
+    stack.clear();
+    stack.push_back(root);
+    while (!stack.empty())
+    {
+        int nodeId = stack.back();
+        stack.pop_back();
+
+        const Node& node = nodes[nodeId];
+        if (!sphere.Intersects(node.box))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            results.push_back(links[nodeId].userData);
+        }
+        else
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void DynamicBVH::QueryRay(const Ray& ray, float maxDistance, std::vector<RayHit>& results) const
+{
+    if (root == NullNode)
+        return;
+
+    std::size_t firstResult = results.size();
+
+    stack.clear();
+    stack.push_back(root);
+    while (!stack.empty())
+    {
+        int nodeId = stack.back();
+        stack.pop_back();
+
+        const Node& node = nodes[nodeId];
+        float distance = 0.0f;
+        if (!node.box.IntersectsRay(ray, maxDistance, distance))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            RayHit hit;
+            hit.userData = links[nodeId].userData;
+            hit.distance = distance;
+            results.push_back(hit);
+        }
+        else
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+
+    std::sort(results.begin() + firstResult, results.end(),
+              [](const RayHit& a, const RayHit& b) { return a.distance < b.distance; });
+}
+
+float DynamicBVH::GetAreaRatio() const
+{
+    if (root == NullNode)
+        return 0.0f;
+
+    float rootArea = nodes[root].box.GetSurfaceArea();
+    if (rootArea <= 0.0f)
+        return 0.0f;
+
+    float totalArea = 0.0f;
+    for (std::size_t i = 0; i < nodes.size(); i++)
+    {
+        // Internal nodes only; leaves have height 0 and free nodes -1
+        if (links[i].height > 0)
+            totalArea += nodes[i].box.GetSurfaceArea();
+    }
+
+    return totalArea / rootArea;
+}
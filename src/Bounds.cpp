@@ -0,0 +1,173 @@
+#include "Bounds.h"
+#include "Vertex.h"
+#include <algorithm>
+#include <cmath>
+
+float BoundingBox::GetSurfaceArea() const
+{
+    if (!IsValid())
+        return 0.0f;
+
+    glm::vec3 size = max - min;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+void BoundingBox::Expand(const glm::vec3& point)
+{
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+}
+
+void BoundingBox::Expand(const BoundingBox& other)
+{
+    if (!other.IsValid())
+        return;
+
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+}
+
+bool BoundingBox::Contains(const BoundingBox& other) const
+{
+    return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+           max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+}
+
+bool BoundingBox::Intersects(const BoundingBox& other) const
+{
+    return min.x <= other.max.x && max.x >= other.min.x &&
+           min.y <= other.max.y && max.y >= other.min.y &&
+           min.z <= other.max.z && max.z >= other.min.z;
+}
+
+bool BoundingBox::IntersectsRay(const Ray& ray, float maxDistance, float& distance) const
+{
+    float tMin = 0.0f;
+    float tMax = maxDistance;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (std::abs(ray.direction[axis]) < 1e-8f)
+        {
+            // Parallel to the slab: must already be between its planes
+            if (ray.origin[axis] < min[axis] || ray.origin[axis] > max[axis])
+                return false;
+            continue;
+        }
+
+        float inverse = 1.0f / ray.direction[axis];
+        float t1 = (min[axis] - ray.origin[axis]) * inverse;
+        float t2 = (max[axis] - ray.origin[axis]) * inverse;
+        if (t1 > t2)
+            std::swap(t1, t2);
+
+        tMin = std::max(tMin, t1);
+        tMax = std::min(tMax, t2);
+        if (tMin > tMax)
+            return false;
+    }
+
+    distance = tMin;
+    return true;
+}
+
+BoundingBox BoundingBox::Transformed(const glm::mat4& transform) const
+{
+    if (!IsValid())
+        return BoundingBox();
+
+    // Transform the centre and project the extents onto the world axes (Arvo)
+    glm::vec3 center = glm::vec3(transform * glm::vec4(GetCenter(), 1.0f));
+    glm::vec3 extents = GetExtents();
+    glm::vec3 worldExtents(0.0f);
+    for (int axis = 0; axis < 3; axis++)
+    {
+        worldExtents += glm::abs(glm::vec3(transform[axis])) * extents[axis];
+    }
+
+    return BoundingBox(center - worldExtents, center + worldExtents);
+}
+
+BoundingBox BoundingBox::FromVertices(const std::vector<Vertex>& vertices)
+{
+    BoundingBox box;
+    for (const auto& vertex : vertices)
+        box.Expand(vertex.position);
+    return box;
+}
+
+BoundingSphere BoundingSphere::FromVertices(const std::vector<Vertex>& vertices, const BoundingBox& box)
+{
+    BoundingSphere sphere;
+    if (!box.IsValid())
+        return sphere;
+
+    sphere.center = box.GetCenter();
+    float radiusSquared = 0.0f;
+    for (const auto& vertex : vertices)
+    {
+        glm::vec3 offset = vertex.position - sphere.center;
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+    }
+    sphere.radius = std::sqrt(radiusSquared);
+    return sphere;
+}
+
+bool BoundingSphere::Intersects(const BoundingBox& box) const
+{
+    glm::vec3 closest = glm::clamp(center, box.min, box.max);
+    glm::vec3 offset = closest - center;
+    return glm::dot(offset, offset) <= radius * radius;
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+    Update(viewProjection);
+}
+
+void Frustum::Update(const glm::mat4& viewProjection)
+{
+    // Gribb/Hartmann: planes are sums/differences of the matrix rows (glm is column-major)
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+    planes[Left] = rows[3] + rows[0];
+    planes[Right] = rows[3] - rows[0];
+    planes[Bottom] = rows[3] + rows[1];
+    planes[Top] = rows[3] - rows[1];
+    planes[Near] = rows[3] + rows[2];
+    planes[Far] = rows[3] - rows[2];
+
+    for (auto& plane : planes)
+    {
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f)
+            plane /= length;
+    }
+}
+
+bool Frustum::Intersects(const BoundingSphere& sphere) const
+{
+    for (const auto& plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::Intersects(const BoundingBox& box) const
+{
+    for (const auto& plane : planes)
+    {
+        // Corner of the box furthest along the plane normal
+        glm::vec3 positive(
+            plane.x >= 0.0f ? box.max.x : box.min.x,
+            plane.y >= 0.0f ? box.max.y : box.min.y,
+            plane.z >= 0.0f ? box.max.z : box.min.z);
+
+        if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+            return false;
+    }
+    return true;
+}
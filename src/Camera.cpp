@@ -85,7 +85,25 @@ void Camera::ProcessMouseMovement(float xoffset, float yoffset)
     // Constrain pitch to avoid flipping
     pitch = std::clamp(pitch, -89.0f, 89.0f);
     
-    // Update camera vectors
+    UpdateCameraVectors();
+}
+
+void Camera::LookAt(const glm::vec3& target)
+{
+    glm::vec3 direction = target - position;
+    if (glm::length(direction) < 1e-6f)
+        return;
+    
+    direction = glm::normalize(direction);
+    yaw = glm::degrees(atan2(direction.z, direction.x));
+    pitch = std::clamp(glm::degrees(asin(direction.y)), -89.0f, 89.0f);
+    
+    UpdateCameraVectors();
+    UpdateViewMatrix();
+}
+
+void Camera::UpdateCameraVectors()
+{
     glm::vec3 newFront;
     newFront.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
     newFront.y = sin(glm::radians(pitch));
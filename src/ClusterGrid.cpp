@@ -0,0 +1,384 @@
+#include "ClusterGrid.h"
+#include "LightGrid.h"
+#include "Scene.h"
+#include "Shader.h"
+#include "GLState.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+namespace {
+    constexpr UniformId UNIFORM_CLUSTER_LIGHT_DATA("clusterLightData");
+    constexpr UniformId UNIFORM_CLUSTER_LIGHT_RANGES("clusterLightRanges");
+    constexpr UniformId UNIFORM_CLUSTER_LIGHT_INDICES("clusterLightIndices");
+    constexpr UniformId UNIFORM_CLUSTER_DIMS("clusterDims");
+    constexpr UniformId UNIFORM_CLUSTER_TILE_SIZE("clusterTileSize");
+    constexpr UniformId UNIFORM_CLUSTER_DEPTH_PARAMS("clusterDepthParams");
+
+    // Compute pass inputs
+    constexpr UniformId UNIFORM_LIGHT_DATA("lightData");
+    constexpr UniformId UNIFORM_CLUSTER_BOUNDS("clusterBounds");
+    constexpr UniformId UNIFORM_LIGHT_COUNT("lightCount");
+    constexpr UniformId UNIFORM_CLUSTER_COUNT("clusterCount");
+    constexpr UniformId UNIFORM_MAX_LIGHTS_PER_CLUSTER("maxLightsPerCluster");
+    constexpr UniformId UNIFORM_VIEW("view");
+
+    const char* const COMPUTE_SHADER_PATH = "resources/shaders/clustered/cluster_lights.comp";
+    constexpr int COMPUTE_GROUP_SIZE = 64;
+
+    constexpr int TILES_PER_SLICE = ClusterGrid::CLUSTERS_X * ClusterGrid::CLUSTERS_Y;
+
+    bool SphereIntersectsBox(const glm::vec4& sphere, const glm::vec3& boxMin, const glm::vec3& boxMax)
+    {
+        glm::vec3 center(sphere.x, sphere.y, sphere.z);
+        glm::vec3 offset = glm::clamp(center, boxMin, boxMax) - center;
+        return glm::dot(offset, offset) <= sphere.w * sphere.w;
+    }
+}
+
+ClusterGrid::ClusterGrid() = default;
+
+ClusterGrid::~ClusterGrid()
+{
+    Shutdown();
+}
+
+bool ClusterGrid::Initialize()
+{
+    if (initialized)
+        return true;
+
+    lightBuffer.Create(GL_RGBA32F);
+    rangeBuffer.Create(GL_RG32UI);
+    indexBuffer.Create(GL_R32UI);
+    boundsBuffer.Create(GL_RGBA32F);
+
+    GLenum err = glGetError();
+    if (err != GL_NO_ERROR)
+    {
+        std::cerr << "Failed to create cluster grid buffers: " << std::hex << err << std::dec << std::endl;
+        Shutdown();
+        return false;
+    }
+
+    sliceLights.resize(CLUSTERS_Z);
+    sliceRanges.resize(CLUSTERS_Z);
+    sliceIndices.resize(CLUSTERS_Z);
+
+    // Compute shaders and image load/store are core in 4.3, the CPU path covers older contexts
+    int majorVersion = 0, minorVersion = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+    glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+    bool versionSupportsCompute = (majorVersion > 4) || (majorVersion == 4 && minorVersion >= 3);
+    if (versionSupportsCompute && glad_glDispatchCompute && glad_glBindImageTexture && glad_glMemoryBarrier)
+    {
+        computeShader = std::make_unique<Shader>();
+        computeShader->SetName("clustered/cluster_lights");
+        if (computeShader->LoadComputeFromFile(COMPUTE_SHADER_PATH))
+        {
+            rangeBuffer.Reserve(CLUSTER_COUNT * sizeof(glm::uvec2));
+            indexBuffer.Reserve(static_cast<std::size_t>(CLUSTER_COUNT) * MAX_GPU_LIGHTS_PER_CLUSTER * sizeof(std::uint32_t));
+        }
+        else
+        {
+            std::cerr << "Failed to load the light clustering compute shader, clusters are built on the CPU" << std::endl;
+            computeShader.reset();
+        }
+    }
+
+    std::cout << "Light clusters: " << (computeShader ? "compute shader" : "CPU") << " assignment, "
+              << ThreadPool::GetInstance()->GetThreadCount() << " CPU threads" << std::endl;
+
+    initialized = true;
+    return true;
+}
+
+void ClusterGrid::Shutdown()
+{
+    computeShader.reset();
+    lightBuffer.Delete();
+    rangeBuffer.Delete();
+    indexBuffer.Delete();
+    boundsBuffer.Delete();
+    boundsUploaded = false;
+    targetWidth = 0;
+    targetHeight = 0;
+    initialized = false;
+}
+
+void ClusterGrid::UpdateClusterBounds(const glm::mat4& projection, float nearPlane, float farPlane, int width, int height)
+{
+    if (projection == clusterProjection && nearPlane == clusterNear && farPlane == clusterFar &&
+        width == targetWidth && height == targetHeight)
+        return;
+
+    clusterProjection = projection;
+    clusterNear = nearPlane;
+    clusterFar = farPlane;
+    targetWidth = width;
+    targetHeight = height;
+    boundsUploaded = false;
+
+    tileSize = glm::vec2(static_cast<float>(width) / CLUSTERS_X, static_cast<float>(height) / CLUSTERS_Y);
+
+    // slice = log(depth / near) / log(far / near) * CLUSTERS_Z, folded into log(depth) * x + y
+    float logDepthRange = std::log(farPlane / nearPlane);
+    depthParams.x = CLUSTERS_Z / logDepthRange;
+    depthParams.y = -CLUSTERS_Z * std::log(nearPlane) / logDepthRange;
+
+    // Direction through each tile corner, scaled to unit view depth
+    glm::mat4 inverseProjection = glm::inverse(projection);
+    auto cornerDirection = [&](int x, int y) {
+        glm::vec4 ndc(2.0f * x / CLUSTERS_X - 1.0f, 2.0f * y / CLUSTERS_Y - 1.0f, -1.0f, 1.0f);
+        glm::vec4 viewPosition = inverseProjection * ndc;
+        glm::vec3 direction(viewPosition.x, viewPosition.y, viewPosition.z);
+        return direction / -direction.z;
+    };
+
+    clusterBounds.resize(CLUSTER_COUNT * 2);
+    for (int z = 0; z < CLUSTERS_Z; z++)
+    {
+        float sliceNear = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(z) / CLUSTERS_Z);
+        float sliceFar = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(z + 1) / CLUSTERS_Z);
+
+        for (int y = 0; y < CLUSTERS_Y; y++)
+        {
+            for (int x = 0; x < CLUSTERS_X; x++)
+            {
+                glm::vec3 boxMin(std::numeric_limits<float>::max());
+                glm::vec3 boxMax(std::numeric_limits<float>::lowest());
+                for (int corner = 0; corner < 4; corner++)
+                {
+                    glm::vec3 direction = cornerDirection(x + (corner & 1), y + (corner >> 1));
+                    boxMin = glm::min(boxMin, glm::min(direction * sliceNear, direction * sliceFar));
+                    boxMax = glm::max(boxMax, glm::max(direction * sliceNear, direction * sliceFar));
+                }
+
+                int cluster = (z * CLUSTERS_Y + y) * CLUSTERS_X + x;
+                clusterBounds[cluster * 2] = glm::vec4(boxMin, 0.0f);
+                clusterBounds[cluster * 2 + 1] = glm::vec4(boxMax, 0.0f);
+            }
+        }
+    }
+}
+
+void ClusterGrid::Build(const std::vector<Light>& lights, const glm::mat4& view, const glm::mat4& projection,
+                        float nearPlane, float farPlane, int width, int height)
+{
+    PROFILE_FUNCTION();
+
+    if (!initialized || width <= 0 || height <= 0)
+        return;
+
+    UpdateClusterBounds(projection, nearPlane, farPlane, width, height);
+
+    lightTexels.resize(lights.size() * 2);
+    for (std::size_t i = 0; i < lights.size(); i++)
+    {
+        lightTexels[i * 2] = glm::vec4(lights[i].position, lights[i].range);
+        lightTexels[i * 2 + 1] = glm::vec4(lights[i].color, lights[i].intensity);
+    }
+    lightBuffer.Upload(lightTexels.data(), lightTexels.size() * sizeof(glm::vec4));
+
+    stats = Stats();
+    stats.lights = static_cast<int>(lights.size());
+    stats.computeAssignment = computeEnabled && computeShader;
+
+    if (stats.computeAssignment)
+    {
+        AssignOnGpu(view);
+        return;
+    }
+
+    ComputeLightBounds(lights, view);
+    AssignOnCpu();
+}
+
+void ClusterGrid::AssignOnGpu(const glm::mat4& view)
+{
+    PROFILE_FUNCTION();
+
+    if (!boundsUploaded)
+    {
+        boundsBuffer.Upload(clusterBounds.data(), clusterBounds.size() * sizeof(glm::vec4));
+        boundsUploaded = true;
+    }
+
+    GLState* state = GLState::GetInstance();
+    computeShader->Use();
+    state->BindTexture(0, GL_TEXTURE_BUFFER, lightBuffer.GetTexture());
+    state->BindTexture(1, GL_TEXTURE_BUFFER, boundsBuffer.GetTexture());
+    computeShader->SetInt(UNIFORM_LIGHT_DATA, 0);
+    computeShader->SetInt(UNIFORM_CLUSTER_BOUNDS, 1);
+    computeShader->SetInt(UNIFORM_LIGHT_COUNT, stats.lights);
+    computeShader->SetInt(UNIFORM_CLUSTER_COUNT, CLUSTER_COUNT);
+    computeShader->SetInt(UNIFORM_MAX_LIGHTS_PER_CLUSTER, MAX_GPU_LIGHTS_PER_CLUSTER);
+    computeShader->SetMat4(UNIFORM_VIEW, view);
+
+    // Image units are separate from texture units, the cache doesn't track them
+    glBindImageTexture(0, rangeBuffer.GetTexture(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32UI);
+    glBindImageTexture(1, indexBuffer.GetTexture(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
+    computeShader->SetInt(UNIFORM_CLUSTER_LIGHT_RANGES, 0);
+    computeShader->SetInt(UNIFORM_CLUSTER_LIGHT_INDICES, 1);
+
+    glDispatchCompute((CLUSTER_COUNT + COMPUTE_GROUP_SIZE - 1) / COMPUTE_GROUP_SIZE, 1, 1);
+
+    // The lists are read with texelFetch by the forward pass
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void ClusterGrid::ComputeLightBounds(const std::vector<Light>& lights, const glm::mat4& view)
+{
+    PROFILE_FUNCTION();
+
+    lightBounds.resize(lights.size());
+
+    const glm::vec2 targetSize(static_cast<float>(targetWidth), static_cast<float>(targetHeight));
+    const glm::ivec2 lastTile(CLUSTERS_X - 1, CLUSTERS_Y - 1);
+    auto ndcToTile = [&](const glm::vec2& ndc) {
+        glm::vec2 tile = (ndc * 0.5f + 0.5f) * targetSize / tileSize;
+        return glm::ivec2(std::clamp(static_cast<int>(tile.x), 0, lastTile.x), std::clamp(static_cast<int>(tile.y), 0, lastTile.y));
+    };
+    auto depthToSlice = [this](float depth) {
+        return std::clamp(static_cast<int>(std::log(depth) * depthParams.x + depthParams.y), 0, CLUSTERS_Z - 1);
+    };
+
+    ThreadPool::GetInstance()->ParallelFor(lights.size(), 64, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++)
+        {
+            const Light& light = lights[i];
+            LightBounds& bounds = lightBounds[i];
+            glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+            bounds.sphere = glm::vec4(center, light.range);
+
+            // Lights without a range reach every cluster
+            if (light.range <= 0.0f)
+            {
+                bounds.minTile = glm::ivec2(0);
+                bounds.maxTile = lastTile;
+                bounds.minSlice = 0;
+                bounds.maxSlice = CLUSTERS_Z - 1;
+                continue;
+            }
+
+            glm::vec2 ndcMin, ndcMax;
+            float depth = -center.z;
+            if (depth - light.range > clusterFar ||
+                !LightGrid::GetScreenBounds(center, light.range, clusterProjection, clusterNear, ndcMin, ndcMax))
+            {
+                bounds.minSlice = 0;
+                bounds.maxSlice = -1;
+                continue;
+            }
+
+            bounds.minTile = ndcToTile(ndcMin);
+            bounds.maxTile = ndcToTile(ndcMax);
+            bounds.minSlice = depthToSlice(std::max(depth - light.range, clusterNear));
+            bounds.maxSlice = depthToSlice(std::min(depth + light.range, clusterFar));
+        }
+    });
+}
+
+void ClusterGrid::AssignSlice(int slice)
+{
+    // Lights whose depth range reaches this slice
+    std::vector<std::uint32_t>& candidates = sliceLights[slice];
+    candidates.clear();
+    for (std::size_t i = 0; i < lightBounds.size(); i++)
+    {
+        if (lightBounds[i].minSlice <= slice && lightBounds[i].maxSlice >= slice)
+            candidates.push_back(static_cast<std::uint32_t>(i));
+    }
+
+    // Compact per-cluster lists, offsets relative to the start of the slice
+    std::vector<glm::uvec2>& ranges = sliceRanges[slice];
+    std::vector<std::uint32_t>& indices = sliceIndices[slice];
+    ranges.resize(TILES_PER_SLICE);
+    indices.clear();
+
+    for (int y = 0; y < CLUSTERS_Y; y++)
+    {
+        for (int x = 0; x < CLUSTERS_X; x++)
+        {
+            int cluster = (slice * CLUSTERS_Y + y) * CLUSTERS_X + x;
+            glm::vec3 boxMin(clusterBounds[cluster * 2]);
+            glm::vec3 boxMax(clusterBounds[cluster * 2 + 1]);
+
+            glm::uvec2& range = ranges[y * CLUSTERS_X + x];
+            range.x = static_cast<std::uint32_t>(indices.size());
+            for (std::uint32_t lightIndex : candidates)
+            {
+                const LightBounds& bounds = lightBounds[lightIndex];
+                if (x < bounds.minTile.x || x > bounds.maxTile.x || y < bounds.minTile.y || y > bounds.maxTile.y)
+                    continue;
+                if (bounds.sphere.w > 0.0f && !SphereIntersectsBox(bounds.sphere, boxMin, boxMax))
+                    continue;
+                indices.push_back(lightIndex);
+            }
+            range.y = static_cast<std::uint32_t>(indices.size()) - range.x;
+        }
+    }
+}
+
+void ClusterGrid::AssignOnCpu()
+{
+    PROFILE_FUNCTION();
+
+    // Slices are independent, each worker fills the lists of whole slices
+    ThreadPool::GetInstance()->ParallelFor(CLUSTERS_Z, 1, [this](std::size_t begin, std::size_t end) {
+        for (std::size_t slice = begin; slice < end; slice++)
+            AssignSlice(static_cast<int>(slice));
+    });
+
+    // Concatenate the slices into one index list
+    clusterRanges.resize(CLUSTER_COUNT);
+    std::size_t totalIndices = 0;
+    for (const std::vector<std::uint32_t>& indices : sliceIndices)
+        totalIndices += indices.size();
+    clusterIndices.resize(totalIndices);
+
+    std::uint32_t sliceOffset = 0;
+    for (int slice = 0; slice < CLUSTERS_Z; slice++)
+    {
+        const std::vector<glm::uvec2>& ranges = sliceRanges[slice];
+        const std::vector<std::uint32_t>& indices = sliceIndices[slice];
+        for (int tile = 0; tile < TILES_PER_SLICE; tile++)
+        {
+            glm::uvec2 range = ranges[tile];
+            clusterRanges[slice * TILES_PER_SLICE + tile] = glm::uvec2(range.x + sliceOffset, range.y);
+
+            if (range.y > 0)
+                stats.activeClusters++;
+            stats.maxLightsPerCluster = std::max(stats.maxLightsPerCluster, static_cast<int>(range.y));
+        }
+
+        if (!indices.empty())
+            std::memcpy(clusterIndices.data() + sliceOffset, indices.data(), indices.size() * sizeof(std::uint32_t));
+        sliceOffset += static_cast<std::uint32_t>(indices.size());
+    }
+
+    if (stats.activeClusters > 0)
+        stats.avgLightsPerActiveCluster = static_cast<float>(totalIndices) / static_cast<float>(stats.activeClusters);
+
+    rangeBuffer.Upload(clusterRanges.data(), clusterRanges.size() * sizeof(glm::uvec2));
+    indexBuffer.Upload(clusterIndices.data(), clusterIndices.size() * sizeof(std::uint32_t));
+}
+
+void ClusterGrid::Bind(Shader* shader, GLuint firstUnit)
+{
+    GLState* state = GLState::GetInstance();
+    state->BindTexture(firstUnit, GL_TEXTURE_BUFFER, lightBuffer.GetTexture());
+    state->BindTexture(firstUnit + 1, GL_TEXTURE_BUFFER, rangeBuffer.GetTexture());
+    state->BindTexture(firstUnit + 2, GL_TEXTURE_BUFFER, indexBuffer.GetTexture());
+
+    shader->SetInt(UNIFORM_CLUSTER_LIGHT_DATA, static_cast<int>(firstUnit));
+    shader->SetInt(UNIFORM_CLUSTER_LIGHT_RANGES, static_cast<int>(firstUnit + 1));
+    shader->SetInt(UNIFORM_CLUSTER_LIGHT_INDICES, static_cast<int>(firstUnit + 2));
+    shader->SetVec3(UNIFORM_CLUSTER_DIMS, glm::vec3(CLUSTERS_X, CLUSTERS_Y, CLUSTERS_Z));
+    shader->SetVec2(UNIFORM_CLUSTER_TILE_SIZE, tileSize);
+    shader->SetVec2(UNIFORM_CLUSTER_DEPTH_PARAMS, depthParams);
+}
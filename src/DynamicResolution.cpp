@@ -0,0 +1,62 @@
+#include "DynamicResolution.h"
+#include <algorithm>
+#include <cmath>
+
+void DynamicResolution::SetEnabled(bool enable)
+{
+    if (enable == enabled)
+        return;
+
+    enabled = enable;
+    SetScale(maxScale);
+}
+
+void DynamicResolution::SetScaleRange(float minimum, float maximum)
+{
+    minScale = std::clamp(minimum, SCALE_STEP, 1.0f);
+    maxScale = std::clamp(maximum, minScale, 1.0f);
+    SetScale(std::clamp(scale, minScale, maxScale));
+}
+
+void DynamicResolution::SetScale(float newScale)
+{
+    scale = newScale;
+    smoothedFrameMs = 0.0f;
+    framesOverBudget = 0;
+    framesUnderBudget = 0;
+}
+
+bool DynamicResolution::Update(float gpuFrameMs)
+{
+    if (!enabled || gpuFrameMs <= 0.0f || targetFrameMs <= 0.0f)
+        return false;
+
+    // Timer results lag a few frames, a short average keeps single spikes from rescaling
+    smoothedFrameMs = smoothedFrameMs > 0.0f ? smoothedFrameMs + (gpuFrameMs - smoothedFrameMs) * 0.25f : gpuFrameMs;
+
+    if (smoothedFrameMs > targetFrameMs)
+    {
+        framesUnderBudget = 0;
+        if (++framesOverBudget < FRAMES_BEFORE_DOWNSCALE || scale <= minScale)
+            return false;
+
+        // Jump straight to the scale that should fit, at least one step down
+        float fittingScale = scale * std::sqrt(targetFrameMs / smoothedFrameMs);
+        float steppedScale = std::floor(fittingScale / SCALE_STEP) * SCALE_STEP;
+        SetScale(std::max(std::min(steppedScale, scale - SCALE_STEP), minScale));
+        return true;
+    }
+
+    framesOverBudget = 0;
+    if (smoothedFrameMs > targetFrameMs * UPSCALE_HEADROOM || scale >= maxScale)
+    {
+        framesUnderBudget = 0;
+        return false;
+    }
+
+    if (++framesUnderBudget < FRAMES_BEFORE_UPSCALE)
+        return false;
+
+    SetScale(std::min(scale + SCALE_STEP, maxScale));
+    return true;
+}
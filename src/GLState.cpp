@@ -0,0 +1,348 @@
+#include "GLState.h"
+#include <algorithm>
+#include <iostream>
+
+GLState::GLState()
+{
+    Invalidate();
+}
+
+GLState* GLState::GetInstance()
+{
+    static GLState instance;
+    return &instance;
+}
+
+void GLState::Initialize()
+{
+    int majorVersion = 0, minorVersion = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+    glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+
+    // Direct state access is core in 4.5; the entry points are only used if the loader resolved them
+    bool versionSupportsDSA = (majorVersion > 4) || (majorVersion == 4 && minorVersion >= 5);
+    directStateAccess = versionSupportsDSA && glad_glBindTextureUnit && glad_glNamedBufferData && glad_glNamedBufferSubData;
+
+    std::cout << "GL state cache: direct state access " << (directStateAccess ? "enabled" : "unavailable") << std::endl;
+    Invalidate();
+}
+
+void GLState::Invalidate()
+{
+    program = UNKNOWN;
+    vertexArray = UNKNOWN;
+    framebuffer = UNKNOWN;
+    std::fill(std::begin(buffers), std::end(buffers), UNKNOWN);
+    activeTextureUnit = UNKNOWN;
+    std::fill(std::begin(textures), std::end(textures), TextureBinding());
+    std::fill(std::begin(capabilities), std::end(capabilities), static_cast<signed char>(-1));
+    blendSource = 0;
+    blendDestination = 0;
+    blendColorKnown = false;
+    depthMask = -1;
+    colorMask = -1;
+    depthFunction = 0;
+    polygonMode = 0;
+    viewportKnown = false;
+}
+
+bool GLState::Changed(bool changed)
+{
+    if (changed)
+        stats.issued++;
+    else
+        stats.skipped++;
+    return changed;
+}
+
+int GLState::GetBufferSlot(GLenum target)
+{
+    switch (target)
+    {
+    case GL_ARRAY_BUFFER: return ArrayBufferSlot;
+    case GL_UNIFORM_BUFFER: return UniformBufferSlot;
+    default: return -1;
+    }
+}
+
+int GLState::GetCapabilitySlot(GLenum capability)
+{
+    switch (capability)
+    {
+    case GL_BLEND: return BlendSlot;
+    case GL_DEPTH_TEST: return DepthTestSlot;
+    case GL_CULL_FACE: return CullFaceSlot;
+    case GL_MULTISAMPLE: return MultisampleSlot;
+    case GL_SCISSOR_TEST: return ScissorTestSlot;
+    case GL_STENCIL_TEST: return StencilTestSlot;
+    default: return -1;
+    }
+}
+
+void GLState::UseProgram(GLuint newProgram)
+{
+    if (Changed(program != newProgram))
+    {
+        glUseProgram(newProgram);
+        program = newProgram;
+    }
+}
+
+void GLState::BindVertexArray(GLuint newVertexArray)
+{
+    if (Changed(vertexArray != newVertexArray))
+    {
+        glBindVertexArray(newVertexArray);
+        vertexArray = newVertexArray;
+    }
+}
+
+void GLState::BindBuffer(GLenum target, GLuint buffer)
+{
+    int slot = GetBufferSlot(target);
+    if (slot < 0)
+    {
+        Changed(true);
+        glBindBuffer(target, buffer);
+        return;
+    }
+
+    if (Changed(buffers[slot] != buffer))
+    {
+        glBindBuffer(target, buffer);
+        buffers[slot] = buffer;
+    }
+}
+
+void GLState::BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    // Indexed binds also replace the generic binding point
+    Changed(true);
+    glBindBufferBase(target, index, buffer);
+
+    int slot = GetBufferSlot(target);
+    if (slot >= 0)
+        buffers[slot] = buffer;
+}
+
+void GLState::SetActiveTextureUnit(GLuint unit)
+{
+    if (Changed(activeTextureUnit != unit))
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeTextureUnit = unit;
+    }
+}
+
+void GLState::BindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+    if (unit >= MAX_TEXTURE_UNITS)
+    {
+        Changed(true);
+        SetActiveTextureUnit(unit);
+        glBindTexture(target, texture);
+        return;
+    }
+
+    TextureBinding& binding = textures[unit];
+    if (!Changed(binding.target != target || binding.texture != texture))
+        return;
+
+    // glBindTextureUnit replaces every target on the unit, only use it when nothing else is bound there
+    if (directStateAccess && (binding.target == target || binding.texture == 0))
+    {
+        glBindTextureUnit(unit, texture);
+    }
+    else
+    {
+        SetActiveTextureUnit(unit);
+        glBindTexture(target, texture);
+    }
+
+    binding.target = target;
+    binding.texture = texture;
+}
+
+void GLState::BindTextureForEditing(GLenum target, GLuint texture)
+{
+    SetActiveTextureUnit(0);
+
+    TextureBinding& binding = textures[0];
+    if (Changed(binding.target != target || binding.texture != texture))
+    {
+        glBindTexture(target, texture);
+        binding.target = target;
+        binding.texture = texture;
+    }
+}
+
+void GLState::BindFramebuffer(GLuint newFramebuffer)
+{
+    if (Changed(framebuffer != newFramebuffer))
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, newFramebuffer);
+        framebuffer = newFramebuffer;
+    }
+}
+
+void GLState::SetEnabled(GLenum capability, bool enabled)
+{
+    int slot = GetCapabilitySlot(capability);
+    if (slot >= 0 && !Changed(capabilities[slot] != static_cast<signed char>(enabled)))
+        return;
+    if (slot < 0)
+        Changed(true);
+
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+
+    if (slot >= 0)
+        capabilities[slot] = static_cast<signed char>(enabled);
+}
+
+void GLState::BlendFunc(GLenum source, GLenum destination)
+{
+    if (Changed(blendSource != source || blendDestination != destination))
+    {
+        glBlendFunc(source, destination);
+        blendSource = source;
+        blendDestination = destination;
+    }
+}
+
+void GLState::BlendColor(float red, float green, float blue, float alpha)
+{
+    bool changed = !blendColorKnown || blendColor[0] != red || blendColor[1] != green || blendColor[2] != blue || blendColor[3] != alpha;
+    if (Changed(changed))
+    {
+        glBlendColor(red, green, blue, alpha);
+        blendColor[0] = red;
+        blendColor[1] = green;
+        blendColor[2] = blue;
+        blendColor[3] = alpha;
+        blendColorKnown = true;
+    }
+}
+
+void GLState::DepthMask(bool write)
+{
+    if (Changed(depthMask != static_cast<signed char>(write)))
+    {
+        glDepthMask(write ? GL_TRUE : GL_FALSE);
+        depthMask = static_cast<signed char>(write);
+    }
+}
+
+void GLState::ColorMask(bool write)
+{
+    if (Changed(colorMask != static_cast<signed char>(write)))
+    {
+        GLboolean value = write ? GL_TRUE : GL_FALSE;
+        glColorMask(value, value, value, value);
+        colorMask = static_cast<signed char>(write);
+    }
+}
+
+void GLState::DepthFunc(GLenum function)
+{
+    if (Changed(depthFunction != function))
+    {
+        glDepthFunc(function);
+        depthFunction = function;
+    }
+}
+
+void GLState::PolygonMode(GLenum mode)
+{
+    if (Changed(polygonMode != mode))
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+        polygonMode = mode;
+    }
+}
+
+void GLState::Viewport(int x, int y, int width, int height)
+{
+    bool changed = !viewportKnown || viewport[0] != x || viewport[1] != y || viewport[2] != width || viewport[3] != height;
+    if (Changed(changed))
+    {
+        glViewport(x, y, width, height);
+        viewport[0] = x;
+        viewport[1] = y;
+        viewport[2] = width;
+        viewport[3] = height;
+        viewportKnown = true;
+    }
+}
+
+GLuint GLState::CreateBuffer()
+{
+    GLuint buffer = 0;
+    if (directStateAccess)
+        glCreateBuffers(1, &buffer);
+    else
+        glGenBuffers(1, &buffer);
+    return buffer;
+}
+
+void GLState::BufferData(GLenum target, GLuint buffer, GLsizeiptr size, const void* data, GLenum usage)
+{
+    if (directStateAccess)
+    {
+        glNamedBufferData(buffer, size, data, usage);
+        return;
+    }
+
+    BindBuffer(target, buffer);
+    glBufferData(target, size, data, usage);
+}
+
+void GLState::BufferSubData(GLenum target, GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    if (directStateAccess)
+    {
+        glNamedBufferSubData(buffer, offset, size, data);
+        return;
+    }
+
+    BindBuffer(target, buffer);
+    glBufferSubData(target, offset, size, data);
+}
+
+void GLState::OnProgramDeleted(GLuint deletedProgram)
+{
+    if (program == deletedProgram)
+        program = UNKNOWN;
+}
+
+void GLState::OnVertexArrayDeleted(GLuint deletedVertexArray)
+{
+    if (vertexArray == deletedVertexArray)
+        vertexArray = UNKNOWN;
+}
+
+void GLState::OnBufferDeleted(GLuint deletedBuffer)
+{
+    for (GLuint& buffer : buffers)
+    {
+        if (buffer == deletedBuffer)
+            buffer = UNKNOWN;
+    }
+}
+
+void GLState::OnTextureDeleted(GLuint deletedTexture)
+{
+    for (TextureBinding& binding : textures)
+    {
+        if (binding.texture == deletedTexture)
+            binding = TextureBinding();
+    }
+}
+
+void GLState::OnFramebufferDeleted(GLuint deletedFramebuffer)
+{
+    if (framebuffer == deletedFramebuffer)
+        framebuffer = UNKNOWN;
+}
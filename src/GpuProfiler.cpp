@@ -0,0 +1,228 @@
+#include "GpuProfiler.h"
+#include <glad/glad.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+
+using json = nlohmann::json;
+
+GpuProfiler::~GpuProfiler()
+{
+    Shutdown();
+}
+
+bool GpuProfiler::Initialize()
+{
+    // Timer queries are core since GL 3.3, including Mesa's software rasterizers
+    int majorVersion = 0, minorVersion = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+    glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+    supported = (majorVersion > 3) || (majorVersion == 3 && minorVersion >= 3);
+
+    if (!supported)
+        std::cerr << "GPU timer queries not supported: OpenGL " << majorVersion << "." << minorVersion << std::endl;
+
+    return supported;
+}
+
+void GpuProfiler::Shutdown()
+{
+    for (auto& pass : passes)
+    {
+        glDeleteQueries(FRAME_LATENCY, pass.queries);
+    }
+    passes.clear();
+    passStats.clear();
+    activePass = -1;
+}
+
+void GpuProfiler::Reset()
+{
+    EndPass();
+    for (auto& pass : passes)
+    {
+        std::fill(std::begin(pass.pending), std::end(pass.pending), false);
+        pass.historyCount = 0;
+        pass.historyIndex = 0;
+    }
+    lastFrameMs = 0.0f;
+}
+
+int GpuProfiler::FindOrCreatePass(const char* name)
+{
+    for (std::size_t i = 0; i < passes.size(); i++)
+    {
+        if (passes[i].name == name)
+            return static_cast<int>(i);
+    }
+
+    PassTimer pass;
+    pass.name = name;
+    glGenQueries(FRAME_LATENCY, pass.queries);
+    passes.push_back(pass);
+    return static_cast<int>(passes.size()) - 1;
+}
+
+float GpuProfiler::CollectResults(PassTimer& pass)
+{
+    float newestMs = -1.0f;
+
+    // Oldest slot first, so history stays in frame order
+    for (int offset = 1; offset <= FRAME_LATENCY; offset++)
+    {
+        int slot = static_cast<int>((frameNumber + offset) % FRAME_LATENCY);
+        if (!pass.pending[slot])
+            continue;
+
+        GLint available = 0;
+        glGetQueryObjectiv(pass.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue;
+
+        GLuint64 elapsedNs = 0;
+        glGetQueryObjectui64v(pass.queries[slot], GL_QUERY_RESULT, &elapsedNs);
+        pass.pending[slot] = false;
+
+        newestMs = static_cast<float>(elapsedNs / 1.0e6);
+        pass.history[pass.historyIndex] = newestMs;
+        pass.historyIndex = (pass.historyIndex + 1) % HISTORY_SIZE;
+        pass.historyCount = std::min(pass.historyCount + 1, HISTORY_SIZE);
+    }
+
+    return newestMs;
+}
+
+void GpuProfiler::BeginFrame()
+{
+    if (!supported)
+        return;
+
+    if (activePass != -1)
+    {
+        std::cerr << "GpuProfiler: pass '" << passes[activePass].name << "' was not ended" << std::endl;
+        EndPass();
+    }
+
+    float frameMs = 0.0f;
+    bool collected = false;
+    for (auto& pass : passes)
+    {
+        float passMs = CollectResults(pass);
+        if (passMs >= 0.0f)
+        {
+            frameMs += passMs;
+            collected = true;
+        }
+    }
+    lastFrameMs = collected ? frameMs : 0.0f;
+
+    frameNumber++;
+}
+
+void GpuProfiler::BeginPass(const char* name)
+{
+    if (!supported || !enabled)
+        return;
+
+    if (activePass != -1)
+    {
+        std::cerr << "GpuProfiler: pass '" << name << "' started inside '" << passes[activePass].name << "'" << std::endl;
+        return;
+    }
+
+    int index = FindOrCreatePass(name);
+    PassTimer& pass = passes[index];
+    int slot = static_cast<int>(frameNumber % FRAME_LATENCY);
+
+    // A pass is timed once per frame, and skipped while the GPU still hasn't
+    // finished the query from FRAME_LATENCY frames ago
+    if (pass.lastFrame == frameNumber || pass.pending[slot])
+        return;
+
+    glBeginQuery(GL_TIME_ELAPSED, pass.queries[slot]);
+    pass.pending[slot] = true;
+    pass.lastFrame = frameNumber;
+    activePass = index;
+}
+
+void GpuProfiler::EndPass()
+{
+    if (activePass == -1)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    activePass = -1;
+}
+
+const std::vector<GpuProfiler::PassStats>& GpuProfiler::GetPassStats()
+{
+    passStats.resize(passes.size());
+    for (std::size_t i = 0; i < passes.size(); i++)
+    {
+        const PassTimer& pass = passes[i];
+        PassStats& stats = passStats[i];
+        stats.name = pass.name;
+        stats.samples = pass.historyCount;
+
+        if (pass.historyCount == 0)
+        {
+            stats.lastMs = stats.minMs = stats.avgMs = stats.p99Ms = 0.0f;
+            continue;
+        }
+
+        sortScratch.assign(pass.history, pass.history + pass.historyCount);
+        float sum = 0.0f;
+        for (float sample : sortScratch)
+            sum += sample;
+
+        std::size_t p99Index = static_cast<std::size_t>((sortScratch.size() - 1) * 0.99f);
+        std::nth_element(sortScratch.begin(), sortScratch.begin() + p99Index, sortScratch.end());
+
+        stats.lastMs = pass.history[(pass.historyIndex + HISTORY_SIZE - 1) % HISTORY_SIZE];
+        stats.minMs = *std::min_element(pass.history, pass.history + pass.historyCount);
+        stats.avgMs = sum / static_cast<float>(pass.historyCount);
+        stats.p99Ms = sortScratch[p99Index];
+    }
+
+    return passStats;
+}
+
+bool GpuProfiler::DumpToFile(const std::string& filepath)
+{
+    json dump;
+    dump["frame"] = frameNumber;
+    dump["passes"] = json::array();
+
+    const auto& stats = GetPassStats();
+    for (std::size_t i = 0; i < passes.size(); i++)
+    {
+        const PassTimer& pass = passes[i];
+
+        // Samples oldest to newest
+        json samples = json::array();
+        int first = (pass.historyIndex + HISTORY_SIZE - pass.historyCount) % HISTORY_SIZE;
+        for (int j = 0; j < pass.historyCount; j++)
+            samples.push_back(pass.history[(first + j) % HISTORY_SIZE]);
+
+        json passJson;
+        passJson["name"] = stats[i].name;
+        passJson["minMs"] = stats[i].minMs;
+        passJson["avgMs"] = stats[i].avgMs;
+        passJson["p99Ms"] = stats[i].p99Ms;
+        passJson["samplesMs"] = samples;
+        dump["passes"].push_back(passJson);
+    }
+
+    std::ofstream file(filepath);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open file for writing GPU timings: " << filepath << std::endl;
+        return false;
+    }
+
+    file << dump.dump(4);
+    std::cout << "GPU timings written to " << filepath << std::endl;
+    return true;
+}
@@ -0,0 +1,193 @@
+#include "LightGrid.h"
+#include "Scene.h"
+#include "Shader.h"
+#include "GLState.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+namespace {
+    constexpr UniformId UNIFORM_LIGHT_BUFFER("lightBuffer");
+    constexpr UniformId UNIFORM_TILE_LIGHT_RANGES("tileLightRanges");
+    constexpr UniformId UNIFORM_TILE_LIGHT_INDICES("tileLightIndices");
+    constexpr UniformId UNIFORM_TILE_SIZE("tileSize");
+    constexpr UniformId UNIFORM_TILES_X("tilesX");
+}
+
+LightGrid::~LightGrid()
+{
+    Shutdown();
+}
+
+bool LightGrid::Initialize()
+{
+    if (initialized)
+        return true;
+
+    lightBuffer.Create(GL_RGBA32F);
+    tileBuffer.Create(GL_RG32UI);
+    indexBuffer.Create(GL_R32UI);
+
+    GLenum err = glGetError();
+    if (err != GL_NO_ERROR)
+    {
+        std::cerr << "Failed to create light grid buffers: " << std::hex << err << std::dec << std::endl;
+        Shutdown();
+        return false;
+    }
+
+    initialized = true;
+    return true;
+}
+
+void LightGrid::Shutdown()
+{
+    lightBuffer.Delete();
+    tileBuffer.Delete();
+    indexBuffer.Delete();
+    initialized = false;
+}
+
+bool LightGrid::GetScreenBounds(const glm::vec3& viewCenter, float radius, const glm::mat4& projection,
+                                float nearPlane, glm::vec2& ndcMin, glm::vec2& ndcMax)
+{
+    // The camera looks down -z; spheres entirely behind the near plane light nothing
+    if (viewCenter.z - radius > -nearPlane)
+        return false;
+
+    // Spheres crossing the near plane can't be projected, they may cover the whole screen
+    if (viewCenter.z + radius > -nearPlane)
+    {
+        ndcMin = glm::vec2(-1.0f);
+        ndcMax = glm::vec2(1.0f);
+        return true;
+    }
+
+    // Screen bounds of the sphere's view-space box
+    ndcMin = glm::vec2(std::numeric_limits<float>::max());
+    ndcMax = glm::vec2(std::numeric_limits<float>::lowest());
+    for (int corner = 0; corner < 8; corner++)
+    {
+        glm::vec3 offset((corner & 1) ? radius : -radius, (corner & 2) ? radius : -radius, (corner & 4) ? radius : -radius);
+        glm::vec4 clip = projection * glm::vec4(viewCenter + offset, 1.0f);
+        glm::vec2 ndc = glm::vec2(clip.x, clip.y) / clip.w;
+        ndcMin = glm::min(ndcMin, ndc);
+        ndcMax = glm::max(ndcMax, ndc);
+    }
+
+    if (ndcMax.x < -1.0f || ndcMax.y < -1.0f || ndcMin.x > 1.0f || ndcMin.y > 1.0f)
+        return false;
+
+    ndcMin = glm::clamp(ndcMin, -1.0f, 1.0f);
+    ndcMax = glm::clamp(ndcMax, -1.0f, 1.0f);
+    return true;
+}
+
+void LightGrid::Build(const std::vector<Light>& lights, const glm::mat4& view, const glm::mat4& projection, int width, int height)
+{
+    PROFILE_FUNCTION();
+
+    tilesX = std::max(1, (width + TILE_SIZE - 1) / TILE_SIZE);
+    tilesY = std::max(1, (height + TILE_SIZE - 1) / TILE_SIZE);
+    const std::size_t tileCount = static_cast<std::size_t>(tilesX) * tilesY;
+
+    lightTexels.resize(lights.size() * 2);
+    lightRects.resize(lights.size());
+    tileRanges.assign(tileCount, glm::uvec2(0));
+
+    // Near plane distance recovered from the perspective projection
+    const float nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+    const glm::ivec4 allTiles(0, 0, tilesX - 1, tilesY - 1);
+    const glm::ivec4 noTiles(0, 0, -1, -1);
+
+    // Conservative tile rectangle of each light
+    for (std::size_t i = 0; i < lights.size(); i++)
+    {
+        const Light& light = lights[i];
+        lightTexels[i * 2] = glm::vec4(light.position, light.range);
+        lightTexels[i * 2 + 1] = glm::vec4(light.color, light.intensity);
+
+        glm::ivec4& rect = lightRects[i];
+        if (light.range <= 0.0f)
+        {
+            rect = allTiles;
+            continue;
+        }
+
+        glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+        glm::vec2 ndcMin, ndcMax;
+        if (!GetScreenBounds(center, light.range, projection, nearPlane, ndcMin, ndcMax))
+        {
+            rect = noTiles;
+            continue;
+        }
+
+        glm::vec2 pixelMin = (ndcMin * 0.5f + 0.5f) * glm::vec2(width, height);
+        glm::vec2 pixelMax = (ndcMax * 0.5f + 0.5f) * glm::vec2(width, height);
+        rect.x = std::clamp(static_cast<int>(pixelMin.x) / TILE_SIZE, 0, tilesX - 1);
+        rect.y = std::clamp(static_cast<int>(pixelMin.y) / TILE_SIZE, 0, tilesY - 1);
+        rect.z = std::clamp(static_cast<int>(pixelMax.x) / TILE_SIZE, 0, tilesX - 1);
+        rect.w = std::clamp(static_cast<int>(pixelMax.y) / TILE_SIZE, 0, tilesY - 1);
+    }
+
+    // Counting sort into per-tile lists: count, prefix sum, then fill
+    for (const glm::ivec4& rect : lightRects)
+    {
+        for (int y = rect.y; y <= rect.w; y++)
+            for (int x = rect.x; x <= rect.z; x++)
+                tileRanges[y * tilesX + x].y++;
+    }
+
+    std::uint32_t offset = 0;
+    int maxLightsPerTile = 0;
+    for (glm::uvec2& range : tileRanges)
+    {
+        range.x = offset;
+        offset += range.y;
+        maxLightsPerTile = std::max(maxLightsPerTile, static_cast<int>(range.y));
+        range.y = 0;
+    }
+
+    tileIndices.resize(offset);
+    for (std::size_t i = 0; i < lightRects.size(); i++)
+    {
+        const glm::ivec4& rect = lightRects[i];
+        for (int y = rect.y; y <= rect.w; y++)
+        {
+            for (int x = rect.x; x <= rect.z; x++)
+            {
+                glm::uvec2& range = tileRanges[y * tilesX + x];
+                tileIndices[range.x + range.y++] = static_cast<std::uint32_t>(i);
+            }
+        }
+    }
+
+    stats.lights = static_cast<int>(lights.size());
+    stats.tiles = static_cast<int>(tileCount);
+    stats.maxLightsPerTile = maxLightsPerTile;
+    stats.avgLightsPerTile = static_cast<float>(offset) / static_cast<float>(tileCount);
+}
+
+void LightGrid::Upload()
+{
+    PROFILE_FUNCTION();
+
+    lightBuffer.Upload(lightTexels.data(), lightTexels.size() * sizeof(glm::vec4));
+    tileBuffer.Upload(tileRanges.data(), tileRanges.size() * sizeof(glm::uvec2));
+    indexBuffer.Upload(tileIndices.data(), tileIndices.size() * sizeof(std::uint32_t));
+}
+
+void LightGrid::Bind(Shader* shader, GLuint firstUnit)
+{
+    GLState* state = GLState::GetInstance();
+    state->BindTexture(firstUnit, GL_TEXTURE_BUFFER, lightBuffer.GetTexture());
+    state->BindTexture(firstUnit + 1, GL_TEXTURE_BUFFER, tileBuffer.GetTexture());
+    state->BindTexture(firstUnit + 2, GL_TEXTURE_BUFFER, indexBuffer.GetTexture());
+
+    shader->SetInt(UNIFORM_LIGHT_BUFFER, static_cast<int>(firstUnit));
+    shader->SetInt(UNIFORM_TILE_LIGHT_RANGES, static_cast<int>(firstUnit + 1));
+    shader->SetInt(UNIFORM_TILE_LIGHT_INDICES, static_cast<int>(firstUnit + 2));
+    shader->SetInt(UNIFORM_TILE_SIZE, TILE_SIZE);
+    shader->SetInt(UNIFORM_TILES_X, tilesX);
+}
@@ -1,5 +1,78 @@
 #include "Mesh.h"
+#include "GLState.h"
+#include "MeshOptimizer.h"
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <unordered_set>
+
+namespace {
+    std::uint64_t nextMeshRevision = 1;
+    bool compactVerticesEnabled = true;
+    // Meshes currently holding a position-only stream
+    std::unordered_set<const Mesh*> meshesWithDepthStreams;
+    
+    // Largest rounding the compact layout may introduce: positions relative to the bounding box
+    // diagonal, texture coordinates in UV units (about a texel of a 2048 texture)
+    constexpr float COMPACT_POSITION_TOLERANCE = 1.0f / 1024.0f;
+    constexpr float COMPACT_TEXCOORD_TOLERANCE = 1.0f / 2048.0f;
+    
+    // Half floats have 11 significant bits, so meshes far from their origin or with large tiled
+    // UVs fail the bounds and stay in floats. Normals always fit in 10 bits per component.
+    bool PackCompactVertices(const std::vector<Vertex>& vertices, const BoundingBox& bounds, std::vector<CompactVertex>& packed)
+    {
+        float maxPositionError = bounds.IsValid() ? glm::length(bounds.max - bounds.min) * COMPACT_POSITION_TOLERANCE : 0.0f;
+        
+        packed.resize(vertices.size());
+        for (std::size_t i = 0; i < vertices.size(); i++)
+        {
+            const Vertex& vertex = vertices[i];
+            CompactVertex& compact = packed[i];
+            
+            for (int axis = 0; axis < 3; axis++)
+            {
+                compact.position[axis] = glm::packHalf1x16(vertex.position[axis]);
+                if (!(std::fabs(glm::unpackHalf1x16(compact.position[axis]) - vertex.position[axis]) <= maxPositionError))
+                    return false;
+            }
+            compact.position[3] = 0;
+            
+            for (int axis = 0; axis < 2; axis++)
+            {
+                compact.texCoords[axis] = glm::packHalf1x16(vertex.texCoords[axis]);
+                if (!(std::fabs(glm::unpackHalf1x16(compact.texCoords[axis]) - vertex.texCoords[axis]) <= COMPACT_TEXCOORD_TOLERANCE))
+                    return false;
+            }
+            
+            compact.normal = glm::packSnorm3x10_1x2(glm::vec4(vertex.normal, 0.0f));
+        }
+        return true;
+    }
+}
+
+void Mesh::SetCompactVerticesEnabled(bool enable)
+{
+    compactVerticesEnabled = enable;
+}
+
+bool Mesh::IsCompactVerticesEnabled()
+{
+    return compactVerticesEnabled;
+}
+
+void Mesh::ReleaseDepthStreams()
+{
+    // Copied first: deleting a stream unregisters its mesh
+    std::vector<const Mesh*> meshes(meshesWithDepthStreams.begin(), meshesWithDepthStreams.end());
+    for (const Mesh* mesh : meshes)
+        mesh->DeleteDepthStream();
+}
+
+std::size_t Mesh::GetVertexBufferSize() const
+{
+    return vertices.size() * (vertexFormat == VertexFormat::Compact ? sizeof(CompactVertex) : sizeof(Vertex));
+}
 
 Mesh::Mesh()
 {
@@ -13,74 +86,327 @@ Mesh::~Mesh()
 void Mesh::SetVertices(const std::vector<Vertex>& newVertices)
 {
     vertices = newVertices;
+    bounds = BoundingBox::FromVertices(vertices);
+    boundingSphere = BoundingSphere::FromVertices(vertices, bounds);
     SetupMesh();
 }
 
 void Mesh::SetIndices(const std::vector<unsigned int>& newIndices)
 {
     indices = newIndices;
+    lodIndices.clear();
+    lods.clear();
+    SetupMesh();
+}
+
+void Mesh::SetGeometry(const std::vector<Vertex>& newVertices, const std::vector<unsigned int>& newIndices,
+                       const std::vector<MeshSimplifier::Lod>& newLods)
+{
+    vertices = newVertices;
+    indices = newIndices;
+    bounds = BoundingBox::FromVertices(vertices);
+    boundingSphere = BoundingSphere::FromVertices(vertices, bounds);
+    StoreLods(newLods);
     SetupMesh();
 }
 
-void Mesh::Draw(RenderMode mode) const
+void Mesh::SetLods(const std::vector<MeshSimplifier::Lod>& newLods)
+{
+    StoreLods(newLods);
+    SetupMesh();
+}
+
+void Mesh::GenerateLods()
+{
+    SetLods(BuildLodChain(vertices, indices));
+}
+
+std::vector<MeshSimplifier::Lod> Mesh::BuildLodChain(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                                     const std::vector<unsigned char>* locked)
+{
+    std::vector<MeshSimplifier::Lod> lods = MeshSimplifier::BuildLodChain(vertices, indices, MAX_LODS - 1, locked);
+    for (MeshSimplifier::Lod& lod : lods)
+        MeshOptimizer::OptimizeVertexCache(lod.indices, vertices.size());
+    return lods;
+}
+
+void Mesh::StoreLods(const std::vector<MeshSimplifier::Lod>& newLods)
+{
+    lodIndices.clear();
+    lods.clear();
+    if (indices.empty())
+        return;
+    
+    for (const MeshSimplifier::Lod& lod : newLods)
+    {
+        if (static_cast<int>(lods.size()) + 1 >= MAX_LODS)
+            break;
+        lods.push_back({ indices.size() + lodIndices.size(), lod.indices.size(), lod.error });
+        lodIndices.insert(lodIndices.end(), lod.indices.begin(), lod.indices.end());
+    }
+}
+
+const Mesh::LodRange* Mesh::GetLodRange(int lod) const
+{
+    if (lod <= 0 || lods.empty())
+        return nullptr;
+    return &lods[std::min(static_cast<std::size_t>(lod), lods.size()) - 1];
+}
+
+std::size_t Mesh::GetLodTriangleCount(int lod) const
+{
+    const LodRange* range = GetLodRange(lod);
+    return range ? range->indexCount / 3 : GetTriangleCount();
+}
+
+float Mesh::GetLodError(int lod) const
+{
+    const LodRange* range = GetLodRange(lod);
+    return range ? range->error : 0.0f;
+}
+
+const unsigned int* Mesh::GetLodIndices(int lod) const
+{
+    if (indices.empty())
+        return nullptr;
+    const LodRange* range = GetLodRange(lod);
+    return range ? lodIndices.data() + (range->indexOffset - indices.size()) : indices.data();
+}
+
+void Mesh::Draw(RenderMode mode, int lod) const
 {
     if (VAO == 0 || vertices.empty())
         return;
     
-    glBindVertexArray(VAO);
+    GLState::GetInstance()->BindVertexArray(VAO);
     
     GLenum primitiveType = (mode == RenderMode::PATCHES) ? GL_PATCHES : GL_TRIANGLES;
     if (mode == RenderMode::PATCHES) {
         glPatchParameteri(GL_PATCH_VERTICES, 3);
     }
     
+    DrawPrimitives(primitiveType, lod, 0);
+}
+
+void Mesh::DrawInstanced(unsigned int instanceBuffer, std::size_t byteOffset, int instanceCount, RenderMode mode, int lod) const
+{
+    if (VAO == 0 || vertices.empty() || instanceCount <= 0)
+        return;
+    
+    GLState::GetInstance()->BindVertexArray(VAO);
+    BindInstanceData(instanceBuffer, byteOffset, true);
+    
+    GLenum primitiveType = (mode == RenderMode::PATCHES) ? GL_PATCHES : GL_TRIANGLES;
+    if (mode == RenderMode::PATCHES) {
+        glPatchParameteri(GL_PATCH_VERTICES, 3);
+    }
+    
+    DrawPrimitives(primitiveType, lod, instanceCount);
+}
+
+void Mesh::DrawDepth(int lod) const
+{
+    if (VAO == 0 || vertices.empty())
+        return;
+    if (depthVAO == 0)
+        SetupDepthStream();
+    
+    GLState::GetInstance()->BindVertexArray(depthVAO);
+    DrawPrimitives(GL_TRIANGLES, lod, 0);
+}
+
+void Mesh::DrawDepthInstanced(unsigned int instanceBuffer, std::size_t byteOffset, int instanceCount, int lod) const
+{
+    if (VAO == 0 || vertices.empty() || instanceCount <= 0)
+        return;
+    if (depthVAO == 0)
+        SetupDepthStream();
+    
+    GLState::GetInstance()->BindVertexArray(depthVAO);
+    BindInstanceData(instanceBuffer, byteOffset, false);
+    DrawPrimitives(GL_TRIANGLES, lod, instanceCount);
+}
+
+void Mesh::BindInstanceData(unsigned int instanceBuffer, std::size_t byteOffset, bool withMaterial) const
+{
+    // No base instance in GL 4.1, so the instance attributes are re-pointed at this batch's slice
+    GLState::GetInstance()->BindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    for (unsigned int column = 0; column < 4; column++)
+    {
+        unsigned int location = INSTANCE_ATTRIB_LOCATION + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                              (void*)(byteOffset + offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(location, 1);
+    }
+    
+    if (!withMaterial)
+        return;
+    
+    const std::size_t materialOffsets[3] = {
+        offsetof(InstanceData, ambient), offsetof(InstanceData, diffuse), offsetof(InstanceData, specular)
+    };
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        unsigned int location = INSTANCE_ATTRIB_LOCATION + 4 + i;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(byteOffset + materialOffsets[i]));
+        glVertexAttribDivisor(location, 1);
+    }
+}
+
+void Mesh::DrawPrimitives(GLenum primitiveType, int lod, int instanceCount) const
+{
     if (!indices.empty())
     {
-        glDrawElements(primitiveType, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
+        const LodRange* range = GetLodRange(lod);
+        std::size_t count = range ? range->indexCount : indices.size();
+        std::size_t offset = range ? range->indexOffset : 0;
+        if (instanceCount > 0)
+            glDrawElementsInstanced(primitiveType, static_cast<GLsizei>(count), indexType,
+                                    (void*)(offset * GetIndexSize()), instanceCount);
+        else
+            glDrawElements(primitiveType, static_cast<GLsizei>(count), indexType, (void*)(offset * GetIndexSize()));
+    }
+    else if (instanceCount > 0)
+    {
+        glDrawArraysInstanced(primitiveType, 0, static_cast<GLsizei>(vertices.size()), instanceCount);
     }
     else
     {
         glDrawArrays(primitiveType, 0, static_cast<GLsizei>(vertices.size()));
     }
-    
-    glBindVertexArray(0);
 }
 
 void Mesh::SetupMesh()
 {
     DeleteBuffers();
+    revision = nextMeshRevision++;
     
     if (vertices.empty())
         return;
     
+    std::vector<CompactVertex> compactVertices;
+    vertexFormat = (compactVerticesEnabled && PackCompactVertices(vertices, bounds, compactVertices))
+        ? VertexFormat::Compact : VertexFormat::Float;
+    
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+    GLState* state = GLState::GetInstance();
+    state->BindVertexArray(VAO);
+    state->BindBuffer(GL_ARRAY_BUFFER, VBO);
+    if (vertexFormat == VertexFormat::Compact)
+        glBufferData(GL_ARRAY_BUFFER, compactVertices.size() * sizeof(CompactVertex), compactVertices.data(), GL_STATIC_DRAW);
+    else
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
     
     if (!indices.empty())
     {
+        // 16-bit indices whenever every vertex is addressable, halving index memory and fetch
+        indexType = vertices.size() <= MAX_16BIT_VERTICES ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        
         glGenBuffers(1, &EBO);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        // The LOD index lists follow the base indices in the same buffer
+        if (indexType == GL_UNSIGNED_SHORT)
+        {
+            std::vector<std::uint16_t> shortIndices;
+            shortIndices.reserve(indices.size() + lodIndices.size());
+            shortIndices.insert(shortIndices.end(), indices.begin(), indices.end());
+            shortIndices.insert(shortIndices.end(), lodIndices.begin(), lodIndices.end());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(std::uint16_t), shortIndices.data(), GL_STATIC_DRAW);
+        }
+        else
+        {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, (indices.size() + lodIndices.size()) * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(unsigned int), indices.data());
+            if (!lodIndices.empty())
+            {
+                glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int),
+                                lodIndices.size() * sizeof(unsigned int), lodIndices.data());
+            }
+        }
     }
     
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-    
     glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
+    if (vertexFormat == VertexFormat::Compact)
+    {
+        // Normalized fetch turns the packed normal back into [-1, 1]; w is ignored by vec3 inputs
+        glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, position));
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, normal));
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, texCoords));
+    }
+    else
+    {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
+    }
+    
+    state->BindVertexArray(0);
+}
+
+void Mesh::SetupDepthStream() const
+{
+    // Compact meshes store the decoded half floats, which convert to float exactly
+    std::vector<glm::vec3> positions(vertices.size());
+    for (std::size_t i = 0; i < vertices.size(); i++)
+    {
+        if (vertexFormat == VertexFormat::Compact)
+        {
+            for (int axis = 0; axis < 3; axis++)
+                positions[i][axis] = glm::unpackHalf1x16(glm::packHalf1x16(vertices[i].position[axis]));
+        }
+        else
+        {
+            positions[i] = vertices[i].position;
+        }
+    }
     
-    glBindVertexArray(0);
+    glGenVertexArrays(1, &depthVAO);
+    glGenBuffers(1, &positionVBO);
+    
+    GLState* state = GLState::GetInstance();
+    state->BindVertexArray(depthVAO);
+    state->BindBuffer(GL_ARRAY_BUFFER, positionVBO);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+    if (EBO != 0)
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    
+    meshesWithDepthStreams.insert(this);
+}
+
+void Mesh::DeleteDepthStream() const
+{
+    if (depthVAO == 0)
+        return;
+    
+    GLState* state = GLState::GetInstance();
+    state->OnVertexArrayDeleted(depthVAO);
+    state->OnBufferDeleted(positionVBO);
+    
+    glDeleteBuffers(1, &positionVBO);
+    positionVBO = 0;
+    glDeleteVertexArrays(1, &depthVAO);
+    depthVAO = 0;
+    
+    meshesWithDepthStreams.erase(this);
 }
 
 void Mesh::DeleteBuffers()
 {
+    DeleteDepthStream();
+    
+    GLState* state = GLState::GetInstance();
+    state->OnVertexArrayDeleted(VAO);
+    state->OnBufferDeleted(VBO);
+    
     if (EBO != 0)
     {
         glDeleteBuffers(1, &EBO);
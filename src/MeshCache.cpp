@@ -0,0 +1,330 @@
+#include "MeshCache.h"
+#include "Profiler.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <type_traits>
+
+namespace {
+    bool cacheEnabled = true;
+    bool indexCompressionEnabled = true;
+
+    constexpr std::uint32_t CACHE_MAGIC = 0x4D534843;     // "CHSM" little endian
+    constexpr std::uint32_t FLAG_COMPRESSED_INDICES = 1u;
+
+    static_assert(std::is_trivially_copyable<Vertex>::value, "Vertices are stored as raw bytes");
+
+    void WriteU32(std::vector<std::uint8_t>& out, std::uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+            out.push_back(static_cast<std::uint8_t>(value >> (i * 8)));
+    }
+
+    void WriteBytes(std::vector<std::uint8_t>& out, const void* data, std::size_t size)
+    {
+        const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+        out.insert(out.end(), bytes, bytes + size);
+    }
+
+    // Bounds-checked cursor over the loaded file
+    struct Reader {
+        const std::uint8_t* data;
+        std::size_t size;
+        std::size_t position = 0;
+
+        bool ReadU32(std::uint32_t& value)
+        {
+            if (size - position < 4)
+                return false;
+            value = 0;
+            for (int i = 0; i < 4; i++)
+                value |= static_cast<std::uint32_t>(data[position + i]) << (i * 8);
+            position += 4;
+            return true;
+        }
+
+        bool ReadBytes(void* destination, std::size_t count)
+        {
+            if (size - position < count)
+                return false;
+            std::memcpy(destination, data + position, count);
+            position += count;
+            return true;
+        }
+    };
+
+    void WriteIndexBlock(std::vector<std::uint8_t>& out, const std::vector<unsigned int>& indices, bool compressed)
+    {
+        WriteU32(out, static_cast<std::uint32_t>(indices.size()));
+        if (compressed)
+        {
+            std::vector<std::uint8_t> encoded;
+            MeshCache::EncodeIndices(indices, encoded);
+            WriteU32(out, static_cast<std::uint32_t>(encoded.size()));
+            WriteBytes(out, encoded.data(), encoded.size());
+        }
+        else
+        {
+            for (unsigned int index : indices)
+                WriteU32(out, index);
+        }
+    }
+
+    bool ReadIndexBlock(Reader& reader, std::vector<unsigned int>& indices, bool compressed, std::size_t vertexCount)
+    {
+        std::uint32_t indexCount = 0;
+        if (!reader.ReadU32(indexCount) || indexCount % 3 != 0)
+            return false;
+
+        if (compressed)
+        {
+            std::uint32_t byteSize = 0;
+            // Every index takes at least one byte, which bounds the allocation by the file size
+            if (!reader.ReadU32(byteSize) || reader.size - reader.position < byteSize || indexCount > byteSize)
+                return false;
+            if (!MeshCache::DecodeIndices(reader.data + reader.position, byteSize, indexCount, indices))
+                return false;
+            reader.position += byteSize;
+        }
+        else
+        {
+            if ((reader.size - reader.position) / 4 < indexCount)
+                return false;
+            indices.resize(indexCount);
+            for (unsigned int& index : indices)
+            {
+                std::uint32_t value = 0;
+                reader.ReadU32(value);
+                index = value;
+            }
+        }
+
+        for (unsigned int index : indices)
+        {
+            if (index >= vertexCount)
+                return false;
+        }
+        return true;
+    }
+}
+
+void MeshCache::SetEnabled(bool enable)
+{
+    cacheEnabled = enable;
+}
+
+bool MeshCache::IsEnabled()
+{
+    return cacheEnabled;
+}
+
+void MeshCache::SetIndexCompressionEnabled(bool enable)
+{
+    indexCompressionEnabled = enable;
+}
+
+bool MeshCache::IsIndexCompressionEnabled()
+{
+    return indexCompressionEnabled;
+}
+
+std::string MeshCache::GetCachePath(const std::string& sourcePath)
+{
+    return sourcePath + ".meshcache";
+}
+
+void MeshCache::EncodeIndices(const std::vector<unsigned int>& indices, std::vector<std::uint8_t>& encoded)
+{
+    encoded.clear();
+    encoded.reserve(indices.size() + indices.size() / 4);
+
+    // Delta from the next unused index: a fresh vertex codes as 0, recent ones as small positives
+    long long next = 0;
+    for (unsigned int index : indices)
+    {
+        long long delta = next - static_cast<long long>(index);
+        std::uint64_t zigzag = delta >= 0 ? static_cast<std::uint64_t>(delta) << 1 : (static_cast<std::uint64_t>(-delta) << 1) - 1;
+        do
+        {
+            std::uint8_t byte = static_cast<std::uint8_t>(zigzag & 0x7F);
+            zigzag >>= 7;
+            encoded.push_back(zigzag ? static_cast<std::uint8_t>(byte | 0x80) : byte);
+        } while (zigzag);
+
+        if (static_cast<long long>(index) >= next)
+            next = static_cast<long long>(index) + 1;
+    }
+}
+
+bool MeshCache::DecodeIndices(const std::uint8_t* data, std::size_t size, std::size_t indexCount,
+                              std::vector<unsigned int>& indices, std::size_t* bytesRead)
+{
+    if (indexCount > size)
+        return false;
+
+    indices.resize(indexCount);
+    std::size_t position = 0;
+    long long next = 0;
+    for (std::size_t i = 0; i < indexCount; i++)
+    {
+        std::uint64_t zigzag = 0;
+        int shift = 0;
+        while (true)
+        {
+            if (position >= size || shift > 35)
+                return false;
+            std::uint8_t byte = data[position++];
+            zigzag |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            shift += 7;
+            if (!(byte & 0x80))
+                break;
+        }
+
+        long long delta = (zigzag & 1) ? -static_cast<long long>((zigzag + 1) >> 1) : static_cast<long long>(zigzag >> 1);
+        long long index = next - delta;
+        if (index < 0 || index > 0xFFFFFFFFll)
+            return false;
+
+        indices[i] = static_cast<unsigned int>(index);
+        if (index >= next)
+            next = index + 1;
+    }
+
+    if (bytesRead)
+        *bytesRead = position;
+    return true;
+}
+
+bool MeshCache::Load(const std::string& sourcePath, std::vector<MeshData>& meshes)
+{
+    if (!cacheEnabled)
+        return false;
+
+    PROFILE_SCOPE("MeshCache::Load");
+
+    namespace fs = std::filesystem;
+    std::error_code error;
+    const std::string cachePath = GetCachePath(sourcePath);
+    fs::file_time_type cacheTime = fs::last_write_time(cachePath, error);
+    if (error)
+        return false;
+    fs::file_time_type sourceTime = fs::last_write_time(sourcePath, error);
+    if (error || cacheTime < sourceTime)
+        return false;
+
+    std::ifstream file(cachePath, std::ios::binary);
+    if (!file)
+        return false;
+    std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    Reader reader{ bytes.data(), bytes.size() };
+    std::uint32_t magic = 0, version = 0, flags = 0, meshCount = 0;
+    if (!reader.ReadU32(magic) || !reader.ReadU32(version) || !reader.ReadU32(flags) || !reader.ReadU32(meshCount) ||
+        magic != CACHE_MAGIC || version != VERSION)
+        return false;
+    const bool compressed = (flags & FLAG_COMPRESSED_INDICES) != 0;
+
+    std::vector<MeshData> loaded;
+    for (std::uint32_t m = 0; m < meshCount; m++)
+    {
+        MeshData data;
+        std::uint32_t vertexCount = 0;
+        if (!reader.ReadU32(vertexCount) || (reader.size - reader.position) / sizeof(Vertex) < vertexCount)
+            break;
+        data.vertices.resize(vertexCount);
+        reader.ReadBytes(data.vertices.data(), vertexCount * sizeof(Vertex));
+
+        if (!ReadIndexBlock(reader, data.indices, compressed, vertexCount))
+            break;
+
+        std::uint32_t lodCount = 0;
+        if (!reader.ReadU32(lodCount) || lodCount >= static_cast<std::uint32_t>(Mesh::MAX_LODS))
+            break;
+        data.lods.resize(lodCount);
+        bool lodsValid = true;
+        for (MeshSimplifier::Lod& lod : data.lods)
+        {
+            lodsValid = reader.ReadBytes(&lod.error, sizeof(float)) && ReadIndexBlock(reader, lod.indices, compressed, vertexCount);
+            if (!lodsValid)
+                break;
+        }
+        if (!lodsValid)
+            break;
+
+        loaded.push_back(std::move(data));
+    }
+
+    if (loaded.size() != meshCount || reader.position != reader.size)
+    {
+        std::cerr << "Ignoring corrupt mesh cache: " << cachePath << std::endl;
+        return false;
+    }
+
+    meshes = std::move(loaded);
+    return true;
+}
+
+bool MeshCache::Save(const std::string& sourcePath, const std::vector<MeshData>& meshes)
+{
+    if (!cacheEnabled)
+        return false;
+
+    PROFILE_SCOPE("MeshCache::Save");
+
+    // Load only accepts whole triangles, so meshes with point or line faces would write a cache that
+    // never loads
+    for (const MeshData& data : meshes)
+    {
+        bool triangles = data.indices.size() % 3 == 0;
+        for (const MeshSimplifier::Lod& lod : data.lods)
+            triangles = triangles && lod.indices.size() % 3 == 0;
+        if (!triangles)
+        {
+            std::cerr << "Not caching " << sourcePath << ": it has faces that aren't triangles" << std::endl;
+            return false;
+        }
+    }
+
+    const bool compressed = indexCompressionEnabled;
+    std::vector<std::uint8_t> bytes;
+    WriteU32(bytes, CACHE_MAGIC);
+    WriteU32(bytes, VERSION);
+    WriteU32(bytes, compressed ? FLAG_COMPRESSED_INDICES : 0u);
+    WriteU32(bytes, static_cast<std::uint32_t>(meshes.size()));
+    for (const MeshData& data : meshes)
+    {
+        WriteU32(bytes, static_cast<std::uint32_t>(data.vertices.size()));
+        WriteBytes(bytes, data.vertices.data(), data.vertices.size() * sizeof(Vertex));
+        WriteIndexBlock(bytes, data.indices, compressed);
+        WriteU32(bytes, static_cast<std::uint32_t>(data.lods.size()));
+        for (const MeshSimplifier::Lod& lod : data.lods)
+        {
+            WriteBytes(bytes, &lod.error, sizeof(float));
+            WriteIndexBlock(bytes, lod.indices, compressed);
+        }
+    }
+
+    // Written aside and renamed, so an interrupted save never leaves a truncated cache behind
+    const std::string cachePath = GetCachePath(sourcePath);
+    const std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file || !file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size())))
+        {
+            std::cerr << "Failed to write mesh cache: " << tempPath << std::endl;
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, cachePath, error);
+    if (error)
+    {
+        std::cerr << "Failed to write mesh cache: " << cachePath << " (" << error.message() << ")" << std::endl;
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,379 @@
+#include "MeshOptimizer.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+    // Below this many triangles reordering can't gain anything measurable
+    constexpr std::size_t MIN_OVERDRAW_TRIANGLES = 64;
+
+    // Vertex to triangle adjacency in compressed rows
+    struct TriangleAdjacency {
+        std::vector<unsigned int> offsets;
+        std::vector<unsigned int> triangles;
+
+        void Build(const std::vector<unsigned int>& indices, std::size_t vertexCount)
+        {
+            offsets.assign(vertexCount + 1, 0);
+            for (unsigned int index : indices)
+                offsets[index + 1]++;
+            std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+            std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+            triangles.resize(indices.size());
+            for (std::size_t i = 0; i < indices.size(); i++)
+                triangles[cursor[indices[i]]++] = static_cast<unsigned int>(i / 3);
+        }
+    };
+}
+
+void MeshOptimizer::Stats::Add(const Stats& other)
+{
+    triangles += other.triangles;
+    vertices += other.vertices;
+    transforms += other.transforms;
+}
+
+MeshOptimizer::Stats MeshOptimizer::AnalyzeVertexCache(const std::vector<unsigned int>& indices, std::size_t vertexCount, int cacheSize)
+{
+    Stats stats;
+    stats.triangles = indices.size() / 3;
+
+    // FIFO cache: a vertex is resident while fewer than cacheSize misses happened since it was loaded
+    std::vector<std::size_t> loadedAt(vertexCount, 0);
+    std::vector<unsigned char> referenced(vertexCount, 0);
+    std::size_t time = static_cast<std::size_t>(cacheSize) + 1;
+    for (unsigned int index : indices)
+    {
+        if (index >= vertexCount)
+            continue;
+
+        if (time - loadedAt[index] > static_cast<std::size_t>(cacheSize))
+        {
+            loadedAt[index] = time++;
+            stats.transforms++;
+        }
+        if (!referenced[index])
+        {
+            referenced[index] = 1;
+            stats.vertices++;
+        }
+    }
+    return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int>& indices, std::size_t vertexCount, int cacheSize)
+{
+    const std::size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || indices.size() % 3 != 0)
+        return;
+
+    TriangleAdjacency adjacency;
+    adjacency.Build(indices, vertexCount);
+
+    std::vector<unsigned int> liveTriangles(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; v++)
+        liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+    std::vector<std::size_t> loadedAt(vertexCount, 0);
+    std::vector<unsigned char> emitted(triangleCount, 0);
+    std::vector<unsigned int> deadEnd;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    deadEnd.reserve(indices.size());
+
+    const std::size_t cache = static_cast<std::size_t>(cacheSize);
+    std::size_t time = cache + 1;
+    std::size_t scan = 0;
+
+    // Fans out from the current vertex, then moves to the candidate that will still be in the
+    // cache once its remaining triangles are emitted, preferring the one loaded longest ago
+    auto nextVertex = [&]() -> long long {
+        long long best = -1;
+        std::size_t bestPriority = 0;
+        for (unsigned int v : candidates)
+        {
+            if (liveTriangles[v] == 0)
+                continue;
+
+            std::size_t priority = 0;
+            std::size_t age = time - loadedAt[v];
+            if (age + 2 * liveTriangles[v] <= cache)
+                priority = age;
+            if (best < 0 || priority > bestPriority)
+            {
+                best = v;
+                bestPriority = priority;
+            }
+        }
+        if (best >= 0)
+            return best;
+
+        // Dead end: back to a recently used vertex with triangles left, else the next unused one
+        while (!deadEnd.empty())
+        {
+            unsigned int v = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveTriangles[v] > 0)
+                return v;
+        }
+        while (scan < vertexCount)
+        {
+            if (liveTriangles[scan] > 0)
+                return static_cast<long long>(scan);
+            scan++;
+        }
+        return -1;
+    };
+
+    long long fanning = nextVertex();
+    while (fanning >= 0)
+    {
+        candidates.clear();
+        const unsigned int vertex = static_cast<unsigned int>(fanning);
+        for (unsigned int i = adjacency.offsets[vertex]; i < adjacency.offsets[vertex + 1]; i++)
+        {
+            unsigned int t = adjacency.triangles[i];
+            if (emitted[t])
+                continue;
+            emitted[t] = 1;
+
+            for (int corner = 0; corner < 3; corner++)
+            {
+                unsigned int v = indices[t * 3 + corner];
+                result.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+                if (time - loadedAt[v] > cache)
+                    loadedAt[v] = time++;
+            }
+        }
+        fanning = nextVertex();
+    }
+
+    indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeOverdraw(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, float threshold)
+{
+    const std::size_t triangleCount = indices.size() / 3;
+    if (triangleCount < MIN_OVERDRAW_TRIANGLES || indices.size() % 3 != 0)
+        return;
+
+    // Clusters are simulated from a cold cache, so however they end up ordered the total stays
+    // within threshold of the current ACMR
+    const float targetAcmr = AnalyzeVertexCache(indices, vertices.size()).GetAcmr() * threshold;
+    const std::size_t cache = static_cast<std::size_t>(CACHE_SIZE);
+
+    std::vector<std::size_t> clusterStarts;
+    std::vector<std::size_t> loadedAt(vertices.size(), 0);
+    std::size_t time = cache + 1;
+    std::size_t clusterMisses = 0;
+    std::size_t clusterStart = 0;
+    clusterStarts.push_back(0);
+    for (std::size_t t = 0; t < triangleCount; t++)
+    {
+        std::size_t clusterTriangles = t - clusterStart;
+        if (clusterTriangles > 0 && static_cast<float>(clusterMisses) <= targetAcmr * static_cast<float>(clusterTriangles))
+        {
+            clusterStarts.push_back(t);
+            clusterStart = t;
+            clusterMisses = 0;
+            time += cache + 1;
+        }
+
+        for (int corner = 0; corner < 3; corner++)
+        {
+            unsigned int v = indices[t * 3 + corner];
+            if (time - loadedAt[v] > cache)
+            {
+                loadedAt[v] = time++;
+                clusterMisses++;
+            }
+        }
+    }
+    clusterStarts.push_back(triangleCount);
+
+    const std::size_t clusterCount = clusterStarts.size() - 1;
+    if (clusterCount < 2)
+        return;
+
+    // Area weighted centroid and normal of each cluster and of the whole mesh
+    std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0f));
+    std::vector<float> clusterAreas(clusterCount, 0.0f);
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (std::size_t c = 0; c < clusterCount; c++)
+    {
+        for (std::size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+        {
+            const glm::vec3& p0 = vertices[indices[t * 3]].position;
+            const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float area = glm::length(normal);
+            glm::vec3 centroid = (p0 + p1 + p2) * (area / 3.0f);
+
+            clusterCentroids[c] += centroid;
+            clusterNormals[c] += normal;
+            clusterAreas[c] += area;
+        }
+        meshCentroid += clusterCentroids[c];
+        meshArea += clusterAreas[c];
+    }
+    if (meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    // Clusters facing away from the centre are drawn first, they're the likeliest occluders
+    std::vector<float> sortKeys(clusterCount, 0.0f);
+    for (std::size_t c = 0; c < clusterCount; c++)
+    {
+        if (clusterAreas[c] <= 0.0f)
+            continue;
+        glm::vec3 centroid = clusterCentroids[c] / clusterAreas[c];
+        float normalLength = glm::length(clusterNormals[c]);
+        if (normalLength > 0.0f)
+            sortKeys[c] = glm::dot(centroid - meshCentroid, clusterNormals[c] / normalLength);
+    }
+
+    std::vector<std::size_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), std::size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (std::size_t c : order)
+        result.insert(result.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+    indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    constexpr unsigned int unassigned = ~0u;
+    std::vector<unsigned int> remap(vertices.size(), unassigned);
+    std::vector<Vertex> result;
+    result.reserve(vertices.size());
+
+    for (unsigned int& index : indices)
+    {
+        if (remap[index] == unassigned)
+        {
+            remap[index] = static_cast<unsigned int>(result.size());
+            result.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    vertices.swap(result);
+}
+
+std::vector<MeshOptimizer::Chunk> MeshOptimizer::SplitByVertexCount(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                                                    std::size_t maxVertices)
+{
+    std::vector<Chunk> chunks;
+    if (maxVertices < 3)
+        return chunks;
+
+    // Cut edges are found by position rather than by index so that seam vertices split on either
+    // side of a cut count too: positionId[v] is the lowest index at v's position
+    std::vector<unsigned int> order(vertices.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+        const glm::vec3& pa = vertices[a].position;
+        const glm::vec3& pb = vertices[b].position;
+        if (pa.x != pb.x) return pa.x < pb.x;
+        if (pa.y != pb.y) return pa.y < pb.y;
+        if (pa.z != pb.z) return pa.z < pb.z;
+        return a < b;
+    });
+    std::vector<unsigned int> positionId(vertices.size());
+    for (std::size_t i = 0; i < order.size(); i++)
+    {
+        bool samePosition = i > 0 && vertices[order[i]].position == vertices[order[i - 1]].position;
+        positionId[order[i]] = samePosition ? positionId[order[i - 1]] : order[i];
+    }
+
+    // Every chunk vertex with the position it came from
+    struct ChunkVertex {
+        unsigned int position;
+        unsigned int chunk;
+        unsigned int vertex;
+    };
+    std::vector<ChunkVertex> chunkVertices;
+
+    // remap[v] is v's index in the chunk numbered remapChunk[v]
+    constexpr std::size_t unassigned = ~std::size_t(0);
+    std::vector<unsigned int> remap(vertices.size(), 0);
+    std::vector<std::size_t> remapChunk(vertices.size(), unassigned);
+
+    for (std::size_t t = 0; t + 2 < indices.size(); t += 3)
+    {
+        std::size_t newVertices = 0;
+        for (int corner = 0; corner < 3; corner++)
+        {
+            if (chunks.empty() || remapChunk[indices[t + corner]] != chunks.size() - 1)
+                newVertices++;
+        }
+        if (chunks.empty() || chunks.back().vertices.size() + newVertices > maxVertices)
+            chunks.emplace_back();
+
+        Chunk& chunk = chunks.back();
+        for (int corner = 0; corner < 3; corner++)
+        {
+            unsigned int v = indices[t + corner];
+            if (remapChunk[v] != chunks.size() - 1)
+            {
+                remapChunk[v] = chunks.size() - 1;
+                remap[v] = static_cast<unsigned int>(chunk.vertices.size());
+                chunk.vertices.push_back(vertices[v]);
+                chunkVertices.push_back({ positionId[v], static_cast<unsigned int>(chunks.size() - 1), remap[v] });
+            }
+            chunk.indices.push_back(remap[v]);
+        }
+    }
+
+    // A position used by more than one chunk lies on a cut
+    for (Chunk& chunk : chunks)
+        chunk.cut.assign(chunk.vertices.size(), 0);
+    std::sort(chunkVertices.begin(), chunkVertices.end(), [](const ChunkVertex& a, const ChunkVertex& b) {
+        return a.position != b.position ? a.position < b.position : a.chunk < b.chunk;
+    });
+    for (std::size_t begin = 0; begin < chunkVertices.size();)
+    {
+        std::size_t end = begin + 1;
+        while (end < chunkVertices.size() && chunkVertices[end].position == chunkVertices[begin].position)
+            end++;
+
+        if (chunkVertices[end - 1].chunk != chunkVertices[begin].chunk)
+        {
+            for (std::size_t i = begin; i < end; i++)
+                chunks[chunkVertices[i].chunk].cut[chunkVertices[i].vertex] = 1;
+        }
+        begin = end;
+    }
+
+    return chunks;
+}
+
+void MeshOptimizer::Optimize(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, Stats* before, Stats* after)
+{
+    // Non-indexed or malformed lists are left alone
+    bool valid = !indices.empty() && indices.size() % 3 == 0 &&
+                 *std::max_element(indices.begin(), indices.end()) < vertices.size();
+
+    if (before)
+        *before = AnalyzeVertexCache(indices, vertices.size());
+
+    if (valid)
+    {
+        OptimizeVertexCache(indices, vertices.size());
+        OptimizeOverdraw(vertices, indices);
+        OptimizeVertexFetch(vertices, indices);
+    }
+
+    if (after)
+        *after = AnalyzeVertexCache(indices, vertices.size());
+}
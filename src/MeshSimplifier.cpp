@@ -0,0 +1,445 @@
+#include "MeshSimplifier.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+namespace {
+    // Border edges are held in place by planes through the edge, weighted this much stronger than surface planes
+    constexpr float BORDER_WEIGHT = 10.0f;
+    // A collapse is rejected when a remaining triangle's normal turns by more than ~78 degrees
+    constexpr float MIN_NORMAL_COSINE = 0.2f;
+    // BuildLodChain stops below this many triangles, or when a level keeps more than MIN_REDUCTION of its source
+    constexpr std::size_t MIN_LOD_TRIANGLES = 32;
+    constexpr float MIN_REDUCTION = 0.75f;
+
+    // Symmetric 4x4 matrix of accumulated, weighted plane equations, upper triangle only
+    struct Quadric {
+        float a00 = 0.0f, a01 = 0.0f, a02 = 0.0f, a11 = 0.0f, a12 = 0.0f, a22 = 0.0f;
+        float b0 = 0.0f, b1 = 0.0f, b2 = 0.0f;
+        float c = 0.0f;
+        float weight = 0.0f;
+
+        void AddPlane(const glm::vec3& n, float d, float w)
+        {
+            a00 += n.x * n.x * w; a01 += n.x * n.y * w; a02 += n.x * n.z * w;
+            a11 += n.y * n.y * w; a12 += n.y * n.z * w; a22 += n.z * n.z * w;
+            b0 += n.x * d * w; b1 += n.y * d * w; b2 += n.z * d * w;
+            c += d * d * w;
+            weight += w;
+        }
+
+        void Add(const Quadric& other)
+        {
+            a00 += other.a00; a01 += other.a01; a02 += other.a02;
+            a11 += other.a11; a12 += other.a12; a22 += other.a22;
+            b0 += other.b0; b1 += other.b1; b2 += other.b2;
+            c += other.c;
+            weight += other.weight;
+        }
+
+        // Weighted mean squared distance of p to the planes
+        float Evaluate(const glm::vec3& p) const
+        {
+            float r = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z +
+                      2.0f * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z) +
+                      2.0f * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+            return weight > 0.0f ? std::fabs(r) / weight : 0.0f;
+        }
+    };
+
+    struct Collapse {
+        float cost;
+        unsigned int from;
+        unsigned int to;
+    };
+
+    uint64_t EdgeKey(unsigned int a, unsigned int b)
+    {
+        if (a > b)
+            std::swap(a, b);
+        return (static_cast<uint64_t>(a) << 32) | b;
+    }
+
+    float AttributeDistance(const Vertex& a, const Vertex& b)
+    {
+        glm::vec3 normal = a.normal - b.normal;
+        glm::vec2 uv = a.texCoords - b.texCoords;
+        return glm::dot(normal, normal) + glm::dot(uv, uv);
+    }
+}
+
+std::vector<unsigned int> MeshSimplifier::Simplify(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                                   std::size_t targetIndexCount, float maxError, float* resultError,
+                                                   const std::vector<unsigned char>* locked)
+{
+    if (resultError)
+        *resultError = 0.0f;
+
+    std::vector<unsigned int> result = indices;
+    const std::size_t vertexCount = vertices.size();
+    if (vertexCount == 0 || result.size() % 3 != 0 || result.size() <= targetIndexCount)
+        return result;
+
+    // Positions are normalised to the unit box so the quadrics stay well conditioned
+    glm::vec3 minPosition(std::numeric_limits<float>::max());
+    glm::vec3 maxPosition(std::numeric_limits<float>::lowest());
+    for (const Vertex& vertex : vertices)
+    {
+        minPosition = glm::min(minPosition, vertex.position);
+        maxPosition = glm::max(maxPosition, vertex.position);
+    }
+    glm::vec3 extent = maxPosition - minPosition;
+    float scale = std::max(extent.x, std::max(extent.y, extent.z));
+    if (scale <= 0.0f)
+        return result;
+
+    std::vector<glm::vec3> positions(vertexCount);
+    for (std::size_t i = 0; i < vertexCount; i++)
+        positions[i] = (vertices[i].position - minPosition) / scale;
+
+    // Weld vertices that share a position: canonical[v] is the lowest index at v's position, and
+    // wedgeNext links every vertex of a position into a ring
+    std::vector<unsigned int> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+        const glm::vec3& pa = vertices[a].position;
+        const glm::vec3& pb = vertices[b].position;
+        if (pa.x != pb.x) return pa.x < pb.x;
+        if (pa.y != pb.y) return pa.y < pb.y;
+        if (pa.z != pb.z) return pa.z < pb.z;
+        return a < b;
+    });
+
+    std::vector<unsigned int> canonical(vertexCount);
+    std::vector<unsigned int> wedgeNext(vertexCount);
+    std::vector<unsigned char> border(vertexCount, 0);
+    std::vector<unsigned char> seam(vertexCount, 0);
+    // A position is pinned when any of its vertices is locked
+    std::vector<unsigned char> pinned(vertexCount, 0);
+    for (std::size_t begin = 0; begin < vertexCount;)
+    {
+        std::size_t end = begin + 1;
+        while (end < vertexCount && vertices[order[end]].position == vertices[order[begin]].position)
+            end++;
+
+        unsigned int first = order[begin];
+        for (std::size_t i = begin; i < end; i++)
+        {
+            canonical[order[i]] = first;
+            wedgeNext[order[i]] = order[i + 1 < end ? i + 1 : begin];
+            if (AttributeDistance(vertices[order[i]], vertices[first]) > 0.0f)
+                seam[first] = 1;
+            if (locked && order[i] < locked->size() && (*locked)[order[i]])
+                pinned[first] = 1;
+        }
+        begin = end;
+    }
+
+    // Surface quadrics from the triangle planes, weighted by area
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<std::pair<uint64_t, std::size_t>> edges;
+    edges.reserve(result.size());
+    for (std::size_t t = 0; t < result.size() / 3; t++)
+    {
+        unsigned int c0 = canonical[result[t * 3]], c1 = canonical[result[t * 3 + 1]], c2 = canonical[result[t * 3 + 2]];
+        if (c0 == c1 || c1 == c2 || c0 == c2)
+            continue;
+
+        glm::vec3 normal = glm::cross(positions[c1] - positions[c0], positions[c2] - positions[c0]);
+        float doubleArea = glm::length(normal);
+        if (doubleArea <= 0.0f)
+            continue;
+
+        normal /= doubleArea;
+        float d = -glm::dot(normal, positions[c0]);
+        quadrics[c0].AddPlane(normal, d, doubleArea * 0.5f);
+        quadrics[c1].AddPlane(normal, d, doubleArea * 0.5f);
+        quadrics[c2].AddPlane(normal, d, doubleArea * 0.5f);
+
+        edges.emplace_back(EdgeKey(c0, c1), t);
+        edges.emplace_back(EdgeKey(c1, c2), t);
+        edges.emplace_back(EdgeKey(c2, c0), t);
+    }
+
+    // Edges used by a single triangle are open borders: constrain them with a plane through the
+    // edge, perpendicular to the triangle
+    std::sort(edges.begin(), edges.end());
+    for (std::size_t i = 0; i < edges.size();)
+    {
+        std::size_t next = i + 1;
+        while (next < edges.size() && edges[next].first == edges[i].first)
+            next++;
+
+        if (next - i == 1)
+        {
+            unsigned int a = static_cast<unsigned int>(edges[i].first >> 32);
+            unsigned int b = static_cast<unsigned int>(edges[i].first & 0xFFFFFFFFu);
+            std::size_t t = edges[i].second;
+            glm::vec3 p0 = positions[canonical[result[t * 3]]];
+            glm::vec3 p1 = positions[canonical[result[t * 3 + 1]]];
+            glm::vec3 p2 = positions[canonical[result[t * 3 + 2]]];
+            glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+            glm::vec3 edge = positions[b] - positions[a];
+            glm::vec3 planeNormal = glm::cross(edge, faceNormal);
+            float length = glm::length(planeNormal);
+            if (length > 0.0f)
+            {
+                planeNormal /= length;
+                float d = -glm::dot(planeNormal, positions[a]);
+                float weight = glm::dot(edge, edge) * BORDER_WEIGHT;
+                quadrics[a].AddPlane(planeNormal, d, weight);
+                quadrics[b].AddPlane(planeNormal, d, weight);
+            }
+            border[a] = 1;
+            border[b] = 1;
+        }
+        i = next;
+    }
+
+    // Locked vertices stay put. Borders and seams may only slide along themselves: a border or seam
+    // vertex only collapses along an edge of the same kind, never across the surface onto another
+    auto canCollapse = [&](unsigned int from, unsigned int to, bool borderEdge, bool seamEdge) {
+        return !pinned[from] && (!border[from] || (border[to] && borderEdge)) && (!seam[from] || (seam[to] && seamEdge));
+    };
+
+    std::vector<unsigned int> collapseTarget(vertexCount);
+    std::iota(collapseTarget.begin(), collapseTarget.end(), 0u);
+
+    // Collapsed vertices are replaced by the vertex at the target position with the closest attributes
+    auto remap = [&](unsigned int vertex) {
+        unsigned int target = collapseTarget[canonical[vertex]];
+        if (target == canonical[vertex])
+            return vertex;
+
+        unsigned int best = target;
+        float bestDistance = AttributeDistance(vertices[vertex], vertices[target]);
+        for (unsigned int wedge = wedgeNext[target]; wedge != target; wedge = wedgeNext[wedge])
+        {
+            float distance = AttributeDistance(vertices[vertex], vertices[wedge]);
+            if (distance < bestDistance)
+            {
+                best = wedge;
+                bestDistance = distance;
+            }
+        }
+        return best;
+    };
+
+    const float maxCost = (maxError / scale) * (maxError / scale);
+    float maxAppliedCost = 0.0f;
+
+    std::vector<unsigned int> adjacencyOffsets;
+    std::vector<unsigned int> adjacencyCursor;
+    std::vector<unsigned int> adjacency;
+    std::vector<unsigned int> neighbours;
+    std::vector<Collapse> collapses;
+    std::vector<unsigned char> touched(vertexCount);
+
+    // Each pass collapses a batch of independent edges, then rebuilds the index list
+    while (result.size() > targetIndexCount)
+    {
+        const std::size_t triangleCount = result.size() / 3;
+
+        // Triangles around each position
+        adjacencyOffsets.assign(vertexCount + 1, 0);
+        for (unsigned int index : result)
+            adjacencyOffsets[canonical[index] + 1]++;
+        std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+        adjacencyCursor.assign(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        adjacency.resize(result.size());
+        for (std::size_t i = 0; i < result.size(); i++)
+            adjacency[adjacencyCursor[canonical[result[i]]]++] = static_cast<unsigned int>(i / 3);
+
+        // Every edge is a candidate, in its cheaper allowed direction. Edges are found through the
+        // triangles of their lower endpoint.
+        collapses.clear();
+        for (unsigned int a = 0; a < vertexCount; a++)
+        {
+            neighbours.clear();
+            for (unsigned int i = adjacencyOffsets[a]; i < adjacencyOffsets[a + 1]; i++)
+            {
+                unsigned int t = adjacency[i];
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    unsigned int b = canonical[result[t * 3 + corner]];
+                    if (b <= a || std::find(neighbours.begin(), neighbours.end(), b) != neighbours.end())
+                        continue;
+                    neighbours.push_back(b);
+
+                    // The edge's triangles: a single one makes it an open border, and different
+                    // attributes at either end between them make it a seam
+                    unsigned int edgeTriangles = 0;
+                    unsigned int wedgeA = 0, wedgeB = 0;
+                    bool seamEdge = false;
+                    for (unsigned int j = adjacencyOffsets[a]; j < adjacencyOffsets[a + 1]; j++)
+                    {
+                        unsigned int u = adjacency[j];
+                        int cornerA = -1, cornerB = -1;
+                        for (int k = 0; k < 3; k++)
+                        {
+                            unsigned int c = canonical[result[u * 3 + k]];
+                            if (c == a)
+                                cornerA = k;
+                            else if (c == b)
+                                cornerB = k;
+                        }
+                        if (cornerA < 0 || cornerB < 0)
+                            continue;
+
+                        unsigned int va = result[u * 3 + cornerA], vb = result[u * 3 + cornerB];
+                        if (edgeTriangles++ == 0)
+                        {
+                            wedgeA = va;
+                            wedgeB = vb;
+                        }
+                        else if (AttributeDistance(vertices[va], vertices[wedgeA]) > 0.0f ||
+                                 AttributeDistance(vertices[vb], vertices[wedgeB]) > 0.0f)
+                        {
+                            seamEdge = true;
+                        }
+                    }
+                    bool borderEdge = edgeTriangles == 1;
+
+                    bool toB = canCollapse(a, b, borderEdge, seamEdge);
+                    bool toA = canCollapse(b, a, borderEdge, seamEdge);
+                    if (!toB && !toA)
+                        continue;
+
+                    Quadric combined = quadrics[a];
+                    combined.Add(quadrics[b]);
+                    float costToB = toB ? combined.Evaluate(positions[b]) : std::numeric_limits<float>::max();
+                    float costToA = toA ? combined.Evaluate(positions[a]) : std::numeric_limits<float>::max();
+                    if (costToB <= costToA)
+                        collapses.push_back({ costToB, a, b });
+                    else
+                        collapses.push_back({ costToA, b, a });
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        // Collapses stop once the triangles they remove reach the target
+        const std::size_t excessTriangles = (result.size() - targetIndexCount + 2) / 3;
+        std::fill(touched.begin(), touched.end(), 0);
+        std::size_t applied = 0;
+        std::size_t removedTriangles = 0;
+
+        for (const Collapse& collapse : collapses)
+        {
+            if (collapse.cost > maxCost)
+                break;
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+
+            // Triangles on the collapsed edge disappear, the others must not flip or fold over
+            bool flips = false;
+            std::size_t removed = 0;
+            for (unsigned int i = adjacencyOffsets[collapse.from]; i < adjacencyOffsets[collapse.from + 1] && !flips; i++)
+            {
+                unsigned int t = adjacency[i];
+                unsigned int corners[3] = { canonical[result[t * 3]], canonical[result[t * 3 + 1]], canonical[result[t * 3 + 2]] };
+                if (corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to)
+                {
+                    removed++;
+                    continue;
+                }
+
+                glm::vec3 before[3] = { positions[corners[0]], positions[corners[1]], positions[corners[2]] };
+                glm::vec3 after[3] = { before[0], before[1], before[2] };
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    if (corners[corner] == collapse.from)
+                        after[corner] = positions[collapse.to];
+                }
+
+                glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+                glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+                float lengths = glm::length(normalBefore) * glm::length(normalAfter);
+                flips = lengths <= 0.0f || glm::dot(normalBefore, normalAfter) < MIN_NORMAL_COSINE * lengths;
+            }
+            if (flips)
+                continue;
+
+            collapseTarget[collapse.from] = collapse.to;
+            quadrics[collapse.to].Add(quadrics[collapse.from]);
+            maxAppliedCost = std::max(maxAppliedCost, collapse.cost);
+
+            // The neighbourhood is re-evaluated in the next pass
+            touched[collapse.to] = 1;
+            for (unsigned int i = adjacencyOffsets[collapse.from]; i < adjacencyOffsets[collapse.from + 1]; i++)
+            {
+                unsigned int t = adjacency[i];
+                touched[canonical[result[t * 3]]] = 1;
+                touched[canonical[result[t * 3 + 1]]] = 1;
+                touched[canonical[result[t * 3 + 2]]] = 1;
+            }
+
+            applied++;
+            removedTriangles += removed;
+            if (removedTriangles >= excessTriangles)
+                break;
+        }
+
+        if (applied == 0)
+            break;
+
+        // Rewrite the triangles, dropping those that lost an edge
+        std::size_t write = 0;
+        for (std::size_t t = 0; t < triangleCount; t++)
+        {
+            unsigned int v0 = remap(result[t * 3]);
+            unsigned int v1 = remap(result[t * 3 + 1]);
+            unsigned int v2 = remap(result[t * 3 + 2]);
+            unsigned int c0 = canonical[v0], c1 = canonical[v1], c2 = canonical[v2];
+            if (c0 == c1 || c1 == c2 || c0 == c2)
+                continue;
+
+            result[write++] = v0;
+            result[write++] = v1;
+            result[write++] = v2;
+        }
+        result.resize(write);
+
+        for (unsigned int i = 0; i < vertexCount; i++)
+            collapseTarget[i] = i;
+    }
+
+    if (resultError)
+        *resultError = std::sqrt(maxAppliedCost) * scale;
+    return result;
+}
+
+std::vector<MeshSimplifier::Lod> MeshSimplifier::BuildLodChain(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, int maxLods,
+                                                                const std::vector<unsigned char>* locked)
+{
+    std::vector<Lod> lods;
+    lods.reserve(std::max(maxLods, 0));
+
+    float accumulatedError = 0.0f;
+    for (int level = 0; level < maxLods; level++)
+    {
+        const std::vector<unsigned int>& source = lods.empty() ? indices : lods.back().indices;
+        std::size_t targetIndexCount = source.size() / 6 * 3;
+        if (targetIndexCount / 3 < MIN_LOD_TRIANGLES)
+            break;
+
+        Lod lod;
+        float error = 0.0f;
+        lod.indices = Simplify(vertices, source, targetIndexCount, std::numeric_limits<float>::max(), &error, locked);
+
+        // Stalled, e.g. only seams and borders are left to collapse
+        if (static_cast<float>(lod.indices.size()) > static_cast<float>(source.size()) * MIN_REDUCTION)
+            break;
+
+        // Each level is simplified from the previous one, so deviations add up
+        accumulatedError += error;
+        lod.error = accumulatedError;
+        lods.push_back(std::move(lod));
+    }
+
+    return lods;
+}
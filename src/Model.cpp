@@ -1,5 +1,10 @@
 #include "Model.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
 #include <iostream>
+#include <algorithm>
 #include <filesystem>
 #include <glad/glad.h>
 #include <assimp/Importer.hpp>
@@ -20,35 +25,50 @@ Model::~Model()
 
 bool Model::LoadFromFile(const std::string& path)
 {
+    PROFILE_SCOPE("Model::LoadFromFile");
+    
     filepath = path;
     isLoaded = false;
     
-    Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(path, 
-        aiProcess_Triangulate |
-        aiProcess_GenSmoothNormals |
-        aiProcess_FlipUVs |
-        aiProcess_CalcTangentSpace);
-    
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
-    {
-        std::cerr << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
-        return false;
-    }
-    
     // Extract directory path
     directory = path.substr(0, path.find_last_of('/'));
     if (directory.empty())
         directory = path.substr(0, path.find_last_of('\\'));
     
-    ProcessNode(scene->mRootNode, scene);
+    std::vector<MeshData> meshData;
+    if (MeshCache::Load(path, meshData))
+    {
+        std::cout << "Loaded " << meshData.size() << " meshes from " << MeshCache::GetCachePath(path) << std::endl;
+    }
+    else
+    {
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(path, 
+            aiProcess_Triangulate |
+            aiProcess_GenSmoothNormals |
+            aiProcess_FlipUVs |
+            aiProcess_CalcTangentSpace);
+        
+        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+        {
+            std::cerr << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+            return false;
+        }
+        
+        ProcessNode(scene->mRootNode, scene, meshData);
+        PrepareMeshes(meshData);
+        MeshCache::Save(path, meshData);
+    }
+    
+    BuildMeshes(meshData);
+    ComputeBounds();
     
     isLoaded = true;
     std::cout << "Successfully loaded model: " << path << std::endl;
     return true;
 }
 
-void Model::Draw(Mesh::RenderMode mode) const
+void Model::Draw(Mesh::RenderMode mode, int lod) const
 {
     if (!isLoaded) {
         std::cerr << "Model not loaded: " << filepath << std::endl;
@@ -58,31 +78,218 @@ void Model::Draw(Mesh::RenderMode mode) const
     for (const auto& mesh : meshes)
     {
         if (mesh)
-            mesh->Draw(mode);
+            mesh->Draw(mode, lod);
+    }
+}
+
+void Model::DrawInstanced(unsigned int instanceBuffer, std::size_t byteOffset, int instanceCount, Mesh::RenderMode mode, int lod) const
+{
+    if (!isLoaded)
+        return;
+    
+    for (const auto& mesh : meshes)
+    {
+        if (mesh)
+            mesh->DrawInstanced(instanceBuffer, byteOffset, instanceCount, mode, lod);
+    }
+}
+
+void Model::DrawDepth(int lod) const
+{
+    if (!isLoaded)
+        return;
+    
+    for (const auto& mesh : meshes)
+    {
+        if (mesh)
+            mesh->DrawDepth(lod);
+    }
+}
+
+void Model::DrawDepthInstanced(unsigned int instanceBuffer, std::size_t byteOffset, int instanceCount, int lod) const
+{
+    if (!isLoaded)
+        return;
+    
+    for (const auto& mesh : meshes)
+    {
+        if (mesh)
+            mesh->DrawDepthInstanced(instanceBuffer, byteOffset, instanceCount, lod);
+    }
+}
+
+std::size_t Model::GetTriangleCount(int lod) const
+{
+    std::size_t triangles = 0;
+    for (const auto& mesh : meshes)
+    {
+        if (mesh)
+            triangles += mesh->GetLodTriangleCount(lod);
     }
+    return triangles;
 }
 
-void Model::ProcessNode(aiNode* node, const aiScene* scene)
+int Model::GetLodCount() const
+{
+    int lodCount = 1;
+    for (const auto& mesh : meshes)
+    {
+        if (mesh)
+            lodCount = std::max(lodCount, mesh->GetLodCount());
+    }
+    return lodCount;
+}
+
+float Model::GetLodError(int lod) const
+{
+    float error = 0.0f;
+    for (const auto& mesh : meshes)
+    {
+        if (mesh)
+            error = std::max(error, mesh->GetLodError(lod));
+    }
+    return error;
+}
+
+void Model::PrepareMeshes(std::vector<MeshData>& meshData)
+{
+    PROFILE_SCOPE("Model::PrepareMeshes");
+    
+    // Reordering, splitting and simplification are CPU-only and run on the workers
+    std::vector<std::vector<MeshData>> pieces(meshData.size());
+    std::vector<MeshOptimizer::Stats> before(meshData.size());
+    std::vector<MeshOptimizer::Stats> after(meshData.size());
+    ThreadPool::GetInstance()->ParallelFor(meshData.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++)
+        {
+            MeshData& data = meshData[i];
+            MeshOptimizer::Optimize(data.vertices, data.indices, &before[i], &after[i]);
+            
+            // Chunks keep the optimised triangle order, so they need no second pass. Splitting pays
+            // when the vertices duplicated along the cuts cost less than halving the base indices
+            // and the LOD chain, which adds about as many again.
+            if (data.vertices.size() > Mesh::MAX_16BIT_VERTICES)
+            {
+                std::vector<MeshOptimizer::Chunk> chunks =
+                    MeshOptimizer::SplitByVertexCount(data.vertices, data.indices, Mesh::MAX_16BIT_VERTICES);
+                std::size_t chunkVertices = 0;
+                for (const MeshOptimizer::Chunk& chunk : chunks)
+                    chunkVertices += chunk.vertices.size();
+                std::size_t duplicatedBytes = (chunkVertices - data.vertices.size()) * sizeof(Vertex);
+                std::size_t savedBytes = 2 * data.indices.size() * (sizeof(std::uint32_t) - sizeof(std::uint16_t));
+                if (duplicatedBytes < savedBytes)
+                {
+                    // Chunks simplify independently, so their cut vertices are locked to keep
+                    // neighbouring chunks' edges matching at every level
+                    for (MeshOptimizer::Chunk& chunk : chunks)
+                    {
+                        MeshData piece;
+                        piece.lods = Mesh::BuildLodChain(chunk.vertices, chunk.indices, &chunk.cut);
+                        piece.vertices = std::move(chunk.vertices);
+                        piece.indices = std::move(chunk.indices);
+                        pieces[i].push_back(std::move(piece));
+                    }
+                }
+            }
+            if (pieces[i].empty())
+            {
+                data.lods = Mesh::BuildLodChain(data.vertices, data.indices);
+                pieces[i].push_back(std::move(data));
+            }
+        }
+    });
+    
+    MeshOptimizer::Stats totalBefore;
+    MeshOptimizer::Stats totalAfter;
+    std::vector<MeshData> prepared;
+    for (std::size_t i = 0; i < pieces.size(); i++)
+    {
+        for (MeshData& piece : pieces[i])
+            prepared.push_back(std::move(piece));
+        totalBefore.Add(before[i]);
+        totalAfter.Add(after[i]);
+    }
+    
+    std::cout << "Optimized " << meshData.size() << " meshes of " << filepath << " into " << prepared.size() << ": ACMR "
+              << totalBefore.GetAcmr() << " -> " << totalAfter.GetAcmr() << ", ATVR "
+              << totalBefore.GetAtvr() << " -> " << totalAfter.GetAtvr() << std::endl;
+    meshData.swap(prepared);
+}
+
+void Model::BuildMeshes(const std::vector<MeshData>& meshData)
+{
+    PROFILE_SCOPE("Model::BuildMeshes");
+    
+    std::size_t vertexBytes = 0;
+    std::size_t indexBytes = 0;
+    std::size_t compactMeshes = 0;
+    std::size_t shortIndexMeshes = 0;
+    for (const MeshData& data : meshData)
+    {
+        auto mesh = std::make_unique<Mesh>();
+        mesh->SetGeometry(data.vertices, data.indices, data.lods);
+        vertexBytes += mesh->GetVertexBufferSize();
+        indexBytes += mesh->GetIndexBufferSize();
+        if (mesh->GetVertexFormat() == Mesh::VertexFormat::Compact)
+            compactMeshes++;
+        if (mesh->GetIndexType() == GL_UNSIGNED_SHORT)
+            shortIndexMeshes++;
+        meshes.push_back(std::move(mesh));
+    }
+    
+    std::cout << "Uploaded " << meshData.size() << " meshes of " << filepath << ": "
+              << vertexBytes / 1024 << " KB of vertices (" << compactMeshes << " compact), "
+              << indexBytes / 1024 << " KB of indices (" << shortIndexMeshes << " 16-bit)" << std::endl;
+}
+
+void Model::ComputeBounds()
+{
+    bounds = BoundingBox();
+    for (const auto& mesh : meshes)
+    {
+        if (mesh)
+            bounds.Expand(mesh->GetBounds());
+    }
+    
+    // Enclose every mesh sphere in one centred on the combined box
+    boundingSphere = BoundingSphere();
+    if (!bounds.IsValid())
+        return;
+    
+    boundingSphere.center = bounds.GetCenter();
+    boundingSphere.radius = 0.0f;
+    for (const auto& mesh : meshes)
+    {
+        if (mesh && mesh->GetBoundingSphere().IsValid())
+        {
+            const BoundingSphere& meshSphere = mesh->GetBoundingSphere();
+            float reach = glm::length(meshSphere.center - boundingSphere.center) + meshSphere.radius;
+            boundingSphere.radius = std::max(boundingSphere.radius, reach);
+        }
+    }
+}
+
+void Model::ProcessNode(aiNode* node, const aiScene* scene, std::vector<MeshData>& meshData)
 {
     // Process all the node's meshes
     for (unsigned int i = 0; i < node->mNumMeshes; i++)
     {
         aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(ProcessMesh(mesh));
+        meshData.push_back(ProcessMesh(mesh));
     }
     
     // Then process all child nodes recursively
     for (unsigned int i = 0; i < node->mNumChildren; i++)
     {
-        ProcessNode(node->mChildren[i], scene);
+        ProcessNode(node->mChildren[i], scene, meshData);
     }
 }
 
-std::unique_ptr<Mesh> Model::ProcessMesh(aiMesh* mesh)
+MeshData Model::ProcessMesh(aiMesh* mesh)
 {
-
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
+    MeshData data;
+    std::vector<Vertex>& vertices = data.vertices;
+    std::vector<unsigned int>& indices = data.indices;
     for (unsigned int i = 0; i < mesh->mNumVertices; i++)
     {
         Vertex vertex;
@@ -117,9 +324,5 @@ std::unique_ptr<Mesh> Model::ProcessMesh(aiMesh* mesh)
             indices.push_back(face.mIndices[j]);
     }
     
-    auto meshObj = std::make_unique<Mesh>();
-    meshObj->SetVertices(vertices);
-    meshObj->SetIndices(indices);
-    
-    return meshObj;
+    return data;
 }
\ No newline at end of file
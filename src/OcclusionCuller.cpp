@@ -0,0 +1,550 @@
+#include "OcclusionCuller.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define OCCLUSION_X64 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define OCCLUSION_TARGET_AVX2
+#else
+#define OCCLUSION_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+    // Snapping grid, 1/16 pixel: snapped coordinates are exact in float
+    constexpr float SUBPIXEL_STEPS = 16.0f;
+    // Triangles are clipped to this many viewports around the screen, which keeps snapped
+    // coordinates small enough for the edge functions to stay precise
+    constexpr float GUARD_BAND = 16.0f;
+    constexpr int MAX_CLIPPED_VERTICES = 8;
+
+    using ScreenTriangle = OcclusionCuller::ScreenTriangle;
+
+    bool CpuSupportsAvx2()
+    {
+#if defined(OCCLUSION_X64) && defined(_MSC_VER) && !defined(__clang__)
+        int info[4] = {};
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#elif defined(OCCLUSION_X64)
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+
+    // Sutherland-Hodgman against one clip-space plane, keeping dot(plane, v) >= 0
+    int ClipPolygon(const glm::vec4* input, int count, const glm::vec4& plane, glm::vec4* output)
+    {
+        int outputCount = 0;
+        for (int i = 0; i < count; i++)
+        {
+            const glm::vec4& current = input[i];
+            const glm::vec4& next = input[(i + 1) % count];
+            float currentDistance = glm::dot(plane, current);
+            float nextDistance = glm::dot(plane, next);
+            if (currentDistance >= 0.0f)
+                output[outputCount++] = current;
+            if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+            {
+                float t = currentDistance / (currentDistance - nextDistance);
+                output[outputCount++] = current + (next - current) * t;
+            }
+        }
+        return outputCount;
+    }
+
+    // The kernels below run the same float operations in the same order per pixel, so their
+    // results match bit for bit. Tile bounds are inclusive.
+
+    void RasterizeScalar(const ScreenTriangle& tri, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY, float* depth, int stride)
+    {
+        const int minX = std::max(tri.minX, tileMinX);
+        const int maxX = std::min(tri.maxX, tileMaxX);
+        const int minY = std::max(tri.minY, tileMinY);
+        const int maxY = std::min(tri.maxY, tileMaxY);
+
+        for (int y = minY; y <= maxY; y++)
+        {
+            const float py = static_cast<float>(y) + 0.5f;
+            float rowEdge[3];
+            for (int i = 0; i < 3; i++)
+                rowEdge[i] = tri.edgeB[i] * (py - tri.edgeY[i]);
+            const float rowDepth = tri.depthB * (py - tri.depthY);
+
+            float* row = depth + static_cast<std::size_t>(y) * stride;
+            for (int x = minX; x <= maxX; x++)
+            {
+                const float px = static_cast<float>(x) + 0.5f;
+                bool inside = true;
+                for (int i = 0; i < 3; i++)
+                {
+                    float edge = tri.edgeA[i] * (px - tri.edgeX[i]) + rowEdge[i];
+                    inside = inside && (tri.inclusive[i] ? edge >= 0.0f : edge > 0.0f);
+                }
+                if (!inside)
+                    continue;
+
+                float z = (tri.depthZ + tri.depthA * (px - tri.depthX)) + rowDepth;
+                z = z < tri.depthMax ? z : tri.depthMax;
+                row[x] = z < row[x] ? z : row[x];
+            }
+        }
+    }
+
+#ifdef OCCLUSION_X64
+    void RasterizeSse2(const ScreenTriangle& tri, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY, float* depth, int stride)
+    {
+        const int minX = std::max(tri.minX, tileMinX);
+        const int maxX = std::min(tri.maxX, tileMaxX);
+        const int minY = std::max(tri.minY, tileMinY);
+        const int maxY = std::min(tri.maxY, tileMaxY);
+        // Tiles start on multiples of 4, so aligned groups never leave the tile
+        const int startX = minX & ~3;
+
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 uncovered = _mm_set1_ps(INFINITY);
+        const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 firstCentre = _mm_set1_ps(static_cast<float>(minX) + 0.5f);
+        const __m128 lastCentre = _mm_set1_ps(static_cast<float>(maxX) + 0.5f);
+        __m128 edgeA[3], edgeX[3];
+        for (int i = 0; i < 3; i++)
+        {
+            edgeA[i] = _mm_set1_ps(tri.edgeA[i]);
+            edgeX[i] = _mm_set1_ps(tri.edgeX[i]);
+        }
+        const __m128 depthA = _mm_set1_ps(tri.depthA);
+        const __m128 depthX = _mm_set1_ps(tri.depthX);
+        const __m128 depthZ = _mm_set1_ps(tri.depthZ);
+        const __m128 depthMax = _mm_set1_ps(tri.depthMax);
+
+        for (int y = minY; y <= maxY; y++)
+        {
+            const float py = static_cast<float>(y) + 0.5f;
+            __m128 rowEdge[3];
+            for (int i = 0; i < 3; i++)
+                rowEdge[i] = _mm_set1_ps(tri.edgeB[i] * (py - tri.edgeY[i]));
+            const __m128 rowDepth = _mm_set1_ps(tri.depthB * (py - tri.depthY));
+
+            float* row = depth + static_cast<std::size_t>(y) * stride;
+            for (int x = startX; x <= maxX; x += 4)
+            {
+                const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+                __m128 mask = _mm_and_ps(_mm_cmpge_ps(px, firstCentre), _mm_cmple_ps(px, lastCentre));
+                for (int i = 0; i < 3; i++)
+                {
+                    __m128 edge = _mm_add_ps(_mm_mul_ps(edgeA[i], _mm_sub_ps(px, edgeX[i])), rowEdge[i]);
+                    mask = _mm_and_ps(mask, tri.inclusive[i] ? _mm_cmpge_ps(edge, zero) : _mm_cmpgt_ps(edge, zero));
+                }
+                if (_mm_movemask_ps(mask) == 0)
+                    continue;
+
+                __m128 z = _mm_add_ps(_mm_add_ps(depthZ, _mm_mul_ps(depthA, _mm_sub_ps(px, depthX))), rowDepth);
+                z = _mm_min_ps(z, depthMax);
+                // Uncovered lanes compare against infinity and keep their depth
+                z = _mm_or_ps(_mm_and_ps(mask, z), _mm_andnot_ps(mask, uncovered));
+                _mm_storeu_ps(row + x, _mm_min_ps(z, _mm_loadu_ps(row + x)));
+            }
+        }
+    }
+
+    OCCLUSION_TARGET_AVX2
+    void RasterizeAvx2(const ScreenTriangle& tri, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY, float* depth, int stride)
+    {
+        const int minX = std::max(tri.minX, tileMinX);
+        const int maxX = std::min(tri.maxX, tileMaxX);
+        const int minY = std::max(tri.minY, tileMinY);
+        const int maxY = std::min(tri.maxY, tileMaxY);
+        // Tiles start on multiples of 8, so aligned groups never leave the tile
+        const int startX = minX & ~7;
+
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 uncovered = _mm256_set1_ps(INFINITY);
+        const __m256 laneOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+        const __m256 firstCentre = _mm256_set1_ps(static_cast<float>(minX) + 0.5f);
+        const __m256 lastCentre = _mm256_set1_ps(static_cast<float>(maxX) + 0.5f);
+        __m256 edgeA[3], edgeX[3];
+        for (int i = 0; i < 3; i++)
+        {
+            edgeA[i] = _mm256_set1_ps(tri.edgeA[i]);
+            edgeX[i] = _mm256_set1_ps(tri.edgeX[i]);
+        }
+        const __m256 depthA = _mm256_set1_ps(tri.depthA);
+        const __m256 depthX = _mm256_set1_ps(tri.depthX);
+        const __m256 depthZ = _mm256_set1_ps(tri.depthZ);
+        const __m256 depthMax = _mm256_set1_ps(tri.depthMax);
+
+        for (int y = minY; y <= maxY; y++)
+        {
+            const float py = static_cast<float>(y) + 0.5f;
+            __m256 rowEdge[3];
+            for (int i = 0; i < 3; i++)
+                rowEdge[i] = _mm256_set1_ps(tri.edgeB[i] * (py - tri.edgeY[i]));
+            const __m256 rowDepth = _mm256_set1_ps(tri.depthB * (py - tri.depthY));
+
+            float* row = depth + static_cast<std::size_t>(y) * stride;
+            for (int x = startX; x <= maxX; x += 8)
+            {
+                const __m256 px = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), laneOffsets);
+                __m256 mask = _mm256_and_ps(_mm256_cmp_ps(px, firstCentre, _CMP_GE_OQ), _mm256_cmp_ps(px, lastCentre, _CMP_LE_OQ));
+                for (int i = 0; i < 3; i++)
+                {
+                    __m256 edge = _mm256_add_ps(_mm256_mul_ps(edgeA[i], _mm256_sub_ps(px, edgeX[i])), rowEdge[i]);
+                    mask = _mm256_and_ps(mask, tri.inclusive[i] ? _mm256_cmp_ps(edge, zero, _CMP_GE_OQ) : _mm256_cmp_ps(edge, zero, _CMP_GT_OQ));
+                }
+                if (_mm256_movemask_ps(mask) == 0)
+                    continue;
+
+                __m256 z = _mm256_add_ps(_mm256_add_ps(depthZ, _mm256_mul_ps(depthA, _mm256_sub_ps(px, depthX))), rowDepth);
+                z = _mm256_min_ps(z, depthMax);
+                z = _mm256_blendv_ps(uncovered, z, mask);
+                _mm256_storeu_ps(row + x, _mm256_min_ps(z, _mm256_loadu_ps(row + x)));
+            }
+        }
+    }
+#endif
+}
+
+OcclusionCuller::OcclusionCuller()
+{
+    SetResolution(DEFAULT_WIDTH, DEFAULT_HEIGHT);
+    simdPath = GetBestSimdPath();
+}
+
+void OcclusionCuller::SetResolution(int newWidth, int newHeight)
+{
+    tilesX = std::max((newWidth + TILE_WIDTH - 1) / TILE_WIDTH, 1);
+    tilesY = std::max((newHeight + TILE_HEIGHT - 1) / TILE_HEIGHT, 1);
+    width = tilesX * TILE_WIDTH;
+    height = tilesY * TILE_HEIGHT;
+    depth.assign(static_cast<std::size_t>(width) * height, 1.0f);
+    blockMaxDepth.assign(static_cast<std::size_t>(width / BLOCK_SIZE) * (height / BLOCK_SIZE), 1.0f);
+    tileBins.resize(static_cast<std::size_t>(tilesX) * tilesY);
+}
+
+OcclusionCuller::SimdPath OcclusionCuller::GetBestSimdPath()
+{
+#ifdef OCCLUSION_X64
+    static const bool avx2 = CpuSupportsAvx2();
+    return avx2 ? SimdPath::AVX2 : SimdPath::SSE2;
+#else
+    return SimdPath::Scalar;
+#endif
+}
+
+const char* OcclusionCuller::GetSimdPathName(SimdPath path)
+{
+    switch (path)
+    {
+    case SimdPath::SSE2:
+        return "SSE2";
+    case SimdPath::AVX2:
+        return "AVX2";
+    case SimdPath::Scalar:
+    default:
+        return "Scalar";
+    }
+}
+
+void OcclusionCuller::SetSimdPath(SimdPath path)
+{
+    simdPath = static_cast<int>(path) <= static_cast<int>(GetBestSimdPath()) ? path : GetBestSimdPath();
+}
+
+void OcclusionCuller::BeginFrame(const glm::mat4& newViewProjection)
+{
+    viewProjection = newViewProjection;
+    occluders.clear();
+    stats = Stats();
+}
+
+void OcclusionCuller::AddOccluder(const Vertex* vertices, std::size_t vertexCount, const unsigned int* indices, std::size_t indexCount,
+                                  const glm::mat4& model)
+{
+    if (!vertices || !indices || indexCount < 3)
+        return;
+
+    occluders.push_back({ vertices, vertexCount, indices, indexCount, viewProjection * model });
+    stats.occluders++;
+    stats.occluderTriangles += indexCount / 3;
+}
+
+void OcclusionCuller::SetupTriangles(const Occluder& occluder, std::vector<ScreenTriangle>& triangles) const
+{
+    triangles.clear();
+
+    const glm::vec4 clipPlanes[5] = {
+        glm::vec4(0.0f, 0.0f, 1.0f, 1.0f),              // near
+        glm::vec4(1.0f, 0.0f, 0.0f, GUARD_BAND),
+        glm::vec4(-1.0f, 0.0f, 0.0f, GUARD_BAND),
+        glm::vec4(0.0f, 1.0f, 0.0f, GUARD_BAND),
+        glm::vec4(0.0f, -1.0f, 0.0f, GUARD_BAND)
+    };
+    const float halfWidth = static_cast<float>(width) * 0.5f;
+    const float halfHeight = static_cast<float>(height) * 0.5f;
+
+    glm::vec4 polygon[MAX_CLIPPED_VERTICES];
+    glm::vec4 clipped[MAX_CLIPPED_VERTICES];
+    glm::vec3 screen[MAX_CLIPPED_VERTICES];
+    for (std::size_t t = 0; t + 2 < occluder.indexCount; t += 3)
+    {
+        bool validIndices = true;
+        for (int corner = 0; corner < 3; corner++)
+        {
+            unsigned int index = occluder.indices[t + corner];
+            if (index >= occluder.vertexCount)
+            {
+                validIndices = false;
+                break;
+            }
+            polygon[corner] = occluder.modelViewProjection * glm::vec4(occluder.vertices[index].position, 1.0f);
+        }
+        if (!validIndices)
+            continue;
+
+        // Trivially inside triangles skip the clipper
+        int count = 3;
+        bool needsClipping = false;
+        for (int corner = 0; corner < 3 && !needsClipping; corner++)
+        {
+            for (const glm::vec4& plane : clipPlanes)
+                needsClipping = needsClipping || glm::dot(plane, polygon[corner]) < 0.0f;
+        }
+        if (needsClipping)
+        {
+            for (const glm::vec4& plane : clipPlanes)
+            {
+                count = ClipPolygon(polygon, count, plane, clipped);
+                std::copy(clipped, clipped + count, polygon);
+                if (count < 3)
+                    break;
+            }
+            if (count < 3)
+                continue;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            float inverseW = 1.0f / polygon[i].w;
+            float x = (polygon[i].x * inverseW + 1.0f) * halfWidth;
+            float y = (polygon[i].y * inverseW + 1.0f) * halfHeight;
+            screen[i] = glm::vec3(std::round(x * SUBPIXEL_STEPS) / SUBPIXEL_STEPS,
+                                  std::round(y * SUBPIXEL_STEPS) / SUBPIXEL_STEPS,
+                                  polygon[i].z * inverseW);
+        }
+
+        // Fan over the clipped polygon
+        for (int i = 1; i + 1 < count; i++)
+        {
+            const glm::vec3 v[3] = { screen[0], screen[i], screen[i + 1] };
+
+            // Counter-clockwise is front facing; back faces and slivers can't occlude anything
+            float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+            if (!(area > 0.0f))
+                continue;
+
+            float minZ = std::min(v[0].z, std::min(v[1].z, v[2].z));
+            if (minZ > 1.0f)
+                continue;
+
+            ScreenTriangle tri;
+            float minX = std::min(v[0].x, std::min(v[1].x, v[2].x));
+            float maxX = std::max(v[0].x, std::max(v[1].x, v[2].x));
+            float minY = std::min(v[0].y, std::min(v[1].y, v[2].y));
+            float maxY = std::max(v[0].y, std::max(v[1].y, v[2].y));
+            tri.minX = std::max(static_cast<int>(std::ceil(minX - 0.5f)), 0);
+            tri.maxX = std::min(static_cast<int>(std::floor(maxX - 0.5f)), width - 1);
+            tri.minY = std::max(static_cast<int>(std::ceil(minY - 0.5f)), 0);
+            tri.maxY = std::min(static_cast<int>(std::floor(maxY - 0.5f)), height - 1);
+            if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+                continue;
+
+            for (int edge = 0; edge < 3; edge++)
+            {
+                const glm::vec3& from = v[edge];
+                const glm::vec3& to = v[(edge + 1) % 3];
+                tri.edgeA[edge] = from.y - to.y;
+                tri.edgeB[edge] = to.x - from.x;
+                tri.edgeX[edge] = from.x;
+                tri.edgeY[edge] = from.y;
+                // Left edges run downwards, top edges leftwards (y up, counter-clockwise)
+                tri.inclusive[edge] = tri.edgeA[edge] > 0.0f || (tri.edgeA[edge] == 0.0f && tri.edgeB[edge] < 0.0f);
+            }
+
+            float depthA = ((v[1].z - v[0].z) * (v[2].y - v[0].y) - (v[2].z - v[0].z) * (v[1].y - v[0].y)) / area;
+            float depthB = ((v[1].x - v[0].x) * (v[2].z - v[0].z) - (v[2].x - v[0].x) * (v[1].z - v[0].z)) / area;
+            tri.depthA = depthA;
+            tri.depthB = depthB;
+            tri.depthX = v[0].x;
+            tri.depthY = v[0].y;
+            // The farthest the plane gets within half a pixel of the centre
+            tri.depthZ = v[0].z + 0.5f * (std::fabs(depthA) + std::fabs(depthB));
+            tri.depthMax = std::max(v[0].z, std::max(v[1].z, v[2].z));
+            triangles.push_back(tri);
+        }
+    }
+}
+
+void OcclusionCuller::RasterizeOccluders()
+{
+    if (occluderTriangles.size() < occluders.size())
+        occluderTriangles.resize(occluders.size());
+
+    ThreadPool* pool = ThreadPool::GetInstance();
+    auto setup = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++)
+            SetupTriangles(occluders[i], occluderTriangles[i]);
+    };
+    if (multithreaded)
+        pool->ParallelFor(occluders.size(), 1, setup);
+    else
+        setup(0, occluders.size());
+
+    for (std::vector<TriangleRef>& bin : tileBins)
+        bin.clear();
+
+    for (std::size_t o = 0; o < occluders.size(); o++)
+    {
+        const std::vector<ScreenTriangle>& triangles = occluderTriangles[o];
+        stats.rasterizedTriangles += triangles.size();
+        for (std::size_t t = 0; t < triangles.size(); t++)
+        {
+            const ScreenTriangle& tri = triangles[t];
+            for (int tileY = tri.minY / TILE_HEIGHT; tileY <= tri.maxY / TILE_HEIGHT; tileY++)
+            {
+                for (int tileX = tri.minX / TILE_WIDTH; tileX <= tri.maxX / TILE_WIDTH; tileX++)
+                    tileBins[tileY * tilesX + tileX].push_back({ static_cast<unsigned int>(o), static_cast<unsigned int>(t) });
+            }
+        }
+    }
+
+    auto rasterize = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t tile = begin; tile < end; tile++)
+            RasterizeTile(static_cast<int>(tile));
+    };
+    if (multithreaded)
+        pool->ParallelFor(tileBins.size(), 1, rasterize);
+    else
+        rasterize(0, tileBins.size());
+}
+
+void OcclusionCuller::RasterizeTile(int tile)
+{
+    const int tileMinX = (tile % tilesX) * TILE_WIDTH;
+    const int tileMinY = (tile / tilesX) * TILE_HEIGHT;
+    const int tileMaxX = tileMinX + TILE_WIDTH - 1;
+    const int tileMaxY = tileMinY + TILE_HEIGHT - 1;
+
+    for (int y = tileMinY; y <= tileMaxY; y++)
+        std::fill_n(depth.begin() + static_cast<std::size_t>(y) * width + tileMinX, TILE_WIDTH, 1.0f);
+
+    for (const TriangleRef& ref : tileBins[tile])
+    {
+        const ScreenTriangle& tri = occluderTriangles[ref.occluder][ref.triangle];
+        switch (simdPath)
+        {
+#ifdef OCCLUSION_X64
+        case SimdPath::AVX2:
+            RasterizeAvx2(tri, tileMinX, tileMinY, tileMaxX, tileMaxY, depth.data(), width);
+            break;
+        case SimdPath::SSE2:
+            RasterizeSse2(tri, tileMinX, tileMinY, tileMaxX, tileMaxY, depth.data(), width);
+            break;
+#endif
+        case SimdPath::Scalar:
+        default:
+            RasterizeScalar(tri, tileMinX, tileMinY, tileMaxX, tileMaxY, depth.data(), width);
+            break;
+        }
+    }
+
+    // Hierarchical level: the farthest depth of each block
+    const int blocksPerRow = width / BLOCK_SIZE;
+    for (int blockY = tileMinY / BLOCK_SIZE; blockY <= tileMaxY / BLOCK_SIZE; blockY++)
+    {
+        for (int blockX = tileMinX / BLOCK_SIZE; blockX <= tileMaxX / BLOCK_SIZE; blockX++)
+        {
+            float farthest = 0.0f;
+            for (int y = blockY * BLOCK_SIZE; y < (blockY + 1) * BLOCK_SIZE; y++)
+            {
+                const float* row = depth.data() + static_cast<std::size_t>(y) * width + blockX * BLOCK_SIZE;
+                farthest = std::max(farthest, *std::max_element(row, row + BLOCK_SIZE));
+            }
+            blockMaxDepth[blockY * blocksPerRow + blockX] = farthest;
+        }
+    }
+}
+
+bool OcclusionCuller::IsVisible(const BoundingBox& worldBox)
+{
+    stats.tested++;
+    if (stats.rasterizedTriangles == 0 || !worldBox.IsValid())
+        return true;
+
+    float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    float nearestZ = INFINITY;
+    for (int corner = 0; corner < 8; corner++)
+    {
+        glm::vec3 point((corner & 1) ? worldBox.max.x : worldBox.min.x,
+                        (corner & 2) ? worldBox.max.y : worldBox.min.y,
+                        (corner & 4) ? worldBox.max.z : worldBox.min.z);
+        glm::vec4 clip = viewProjection * glm::vec4(point, 1.0f);
+        if (clip.z < -clip.w || clip.w <= 0.0f)
+            return true;
+
+        float inverseW = 1.0f / clip.w;
+        float x = (clip.x * inverseW + 1.0f) * 0.5f * static_cast<float>(width);
+        float y = (clip.y * inverseW + 1.0f) * 0.5f * static_cast<float>(height);
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearestZ = std::min(nearestZ, clip.z * inverseW);
+    }
+
+    // Every pixel the box touches
+    int pixelMinX = std::max(static_cast<int>(std::floor(minX)), 0);
+    int pixelMaxX = std::min(static_cast<int>(std::ceil(maxX)) - 1, width - 1);
+    int pixelMinY = std::max(static_cast<int>(std::floor(minY)), 0);
+    int pixelMaxY = std::min(static_cast<int>(std::ceil(maxY)) - 1, height - 1);
+    if (pixelMinX > pixelMaxX || pixelMinY > pixelMaxY)
+        return true;
+
+    // Blocks whose farthest depth is nearer than the box are hidden as a whole, the rest are
+    // checked per pixel
+    const int blocksPerRow = width / BLOCK_SIZE;
+    for (int blockY = pixelMinY / BLOCK_SIZE; blockY <= pixelMaxY / BLOCK_SIZE; blockY++)
+    {
+        for (int blockX = pixelMinX / BLOCK_SIZE; blockX <= pixelMaxX / BLOCK_SIZE; blockX++)
+        {
+            if (blockMaxDepth[blockY * blocksPerRow + blockX] < nearestZ)
+                continue;
+
+            int x0 = std::max(pixelMinX, blockX * BLOCK_SIZE);
+            int x1 = std::min(pixelMaxX, blockX * BLOCK_SIZE + BLOCK_SIZE - 1);
+            int y0 = std::max(pixelMinY, blockY * BLOCK_SIZE);
+            int y1 = std::min(pixelMaxY, blockY * BLOCK_SIZE + BLOCK_SIZE - 1);
+            for (int y = y0; y <= y1; y++)
+            {
+                const float* row = depth.data() + static_cast<std::size_t>(y) * width;
+                for (int x = x0; x <= x1; x++)
+                {
+                    if (row[x] >= nearestZ)
+                        return true;
+                }
+            }
+        }
+    }
+
+    stats.culled++;
+    return false;
+}
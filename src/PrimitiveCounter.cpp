@@ -0,0 +1,86 @@
+#include "PrimitiveCounter.h"
+#include <glad/glad.h>
+
+PrimitiveCounter::~PrimitiveCounter()
+{
+    Shutdown();
+}
+
+bool PrimitiveCounter::Initialize()
+{
+    if (initialized)
+        return true;
+
+    glGenQueries(FRAME_LATENCY, queries);
+    initialized = true;
+    return true;
+}
+
+void PrimitiveCounter::Shutdown()
+{
+    if (!initialized)
+        return;
+
+    End();
+    glDeleteQueries(FRAME_LATENCY, queries);
+    for (int slot = 0; slot < FRAME_LATENCY; slot++)
+    {
+        queries[slot] = 0;
+        pending[slot] = false;
+    }
+    lastCount = -1;
+    initialized = false;
+}
+
+void PrimitiveCounter::BeginFrame()
+{
+    if (!initialized)
+        return;
+
+    End();
+
+    // Oldest slot first, so the newest finished result wins
+    for (int offset = 1; offset <= FRAME_LATENCY; offset++)
+    {
+        int slot = static_cast<int>((frameNumber + offset) % FRAME_LATENCY);
+        if (!pending[slot])
+            continue;
+
+        GLint available = 0;
+        glGetQueryObjectiv(queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue;
+
+        GLuint64 primitives = 0;
+        glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &primitives);
+        pending[slot] = false;
+        lastCount = static_cast<long long>(primitives);
+    }
+
+    frameNumber++;
+}
+
+void PrimitiveCounter::Begin()
+{
+    if (!initialized || active)
+        return;
+
+    // Skipped while the GPU still hasn't finished the query from FRAME_LATENCY frames ago
+    int slot = static_cast<int>(frameNumber % FRAME_LATENCY);
+    if (lastFrame == frameNumber || pending[slot])
+        return;
+
+    glBeginQuery(GL_PRIMITIVES_GENERATED, queries[slot]);
+    pending[slot] = true;
+    lastFrame = frameNumber;
+    active = true;
+}
+
+void PrimitiveCounter::End()
+{
+    if (!active)
+        return;
+
+    glEndQuery(GL_PRIMITIVES_GENERATED);
+    active = false;
+}
@@ -1,11 +1,94 @@
 #include "Primitives.h"
 #include "Mesh.h"
+#include "MeshOptimizer.h"
 #include "ResourceManager.h"
 #include <vector>
+#include <map>
+#include <tuple>
+#include <functional>
 #include <iostream>
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+namespace {
+    enum class PrimitiveType {
+        Cube,
+        Sphere,
+        Plane,
+        Cylinder,
+        Cone
+    };
+    
+    // Unused parameters are left at zero so equal shapes map to the same key
+    struct PrimitiveKey {
+        PrimitiveType type;
+        float sizeA = 0.0f;
+        float sizeB = 0.0f;
+        unsigned int segments = 0;
+        
+        bool operator<(const PrimitiveKey& other) const
+        {
+            return std::tie(type, sizeA, sizeB, segments) < std::tie(other.type, other.sizeA, other.sizeB, other.segments);
+        }
+    };
+    
+    // Weak references only, so the cache never keeps GL objects alive past their last user
+    std::map<PrimitiveKey, std::weak_ptr<Mesh>> meshCache;
+    
+    std::shared_ptr<Mesh> GetOrCreateMesh(const PrimitiveKey& key, const std::function<std::unique_ptr<Mesh>()>& create)
+    {
+        auto it = meshCache.find(key);
+        if (it != meshCache.end())
+        {
+            if (std::shared_ptr<Mesh> mesh = it->second.lock())
+                return mesh;
+        }
+        
+        std::shared_ptr<Mesh> mesh = create();
+        meshCache[key] = mesh;
+        return mesh;
+    }
+}
+
+std::shared_ptr<Mesh> Primitives::GetCube(float size)
+{
+    return GetOrCreateMesh({ PrimitiveType::Cube, size, 0.0f, 0 }, [=]() { return CreateCube(size); });
+}
+
+std::shared_ptr<Mesh> Primitives::GetSphere(float radius, unsigned int segments)
+{
+    return GetOrCreateMesh({ PrimitiveType::Sphere, radius, 0.0f, segments }, [=]() { return CreateSphere(radius, segments); });
+}
+
+std::shared_ptr<Mesh> Primitives::GetPlane(float width, float height)
+{
+    return GetOrCreateMesh({ PrimitiveType::Plane, width, height, 0 }, [=]() { return CreatePlane(width, height); });
+}
+
+std::shared_ptr<Mesh> Primitives::GetCylinder(float radius, float height, unsigned int segments)
+{
+    return GetOrCreateMesh({ PrimitiveType::Cylinder, radius, height, segments }, [=]() { return CreateCylinder(radius, height, segments); });
+}
+
+std::shared_ptr<Mesh> Primitives::GetCone(float radius, float height, unsigned int segments)
+{
+    return GetOrCreateMesh({ PrimitiveType::Cone, radius, height, segments }, [=]() { return CreateCone(radius, height, segments); });
+}
+
+std::size_t Primitives::GetCachedMeshCount()
+{
+    // Drop entries whose meshes have been released while counting the live ones
+    for (auto it = meshCache.begin(); it != meshCache.end();)
+    {
+        if (it->second.expired())
+            it = meshCache.erase(it);
+        else
+            ++it;
+    }
+    
+    return meshCache.size();
+}
+
 std::unique_ptr<Mesh> Primitives::CreateCube(float size)
 {
     float halfSize = size / 2.0f;
@@ -70,9 +153,9 @@ std::unique_ptr<Mesh> Primitives::CreateCube(float size)
         20, 21, 22, 22, 23, 20
     };
     
+    MeshOptimizer::Optimize(vertices, indices);
     auto mesh = std::make_unique<Mesh>();
-    mesh->SetVertices(vertices);
-    mesh->SetIndices(indices);
+    mesh->SetGeometry(vertices, indices, {});
     
     return mesh;
 }
@@ -125,9 +208,9 @@ std::unique_ptr<Mesh> Primitives::CreateSphere(float radius, unsigned int segmen
         }
     }
     
+    MeshOptimizer::Optimize(vertices, indices);
     auto mesh = std::make_unique<Mesh>();
-    mesh->SetVertices(vertices);
-    mesh->SetIndices(indices);
+    mesh->SetGeometry(vertices, indices, Mesh::BuildLodChain(vertices, indices));
     
     return mesh;
 }
@@ -148,9 +231,9 @@ std::unique_ptr<Mesh> Primitives::CreatePlane(float width, float height)
         0, 1, 2, 2, 3, 0
     };
     
+    MeshOptimizer::Optimize(vertices, indices);
     auto mesh = std::make_unique<Mesh>();
-    mesh->SetVertices(vertices);
-    mesh->SetIndices(indices);
+    mesh->SetGeometry(vertices, indices, {});
     
     return mesh;
 }
@@ -230,9 +313,9 @@ std::unique_ptr<Mesh> Primitives::CreateCylinder(float radius, float height, uns
         indices.push_back(next + 1);
     }
     
+    MeshOptimizer::Optimize(vertices, indices);
     auto mesh = std::make_unique<Mesh>();
-    mesh->SetVertices(vertices);
-    mesh->SetIndices(indices);
+    mesh->SetGeometry(vertices, indices, Mesh::BuildLodChain(vertices, indices));
     
     return mesh;
 }
@@ -289,9 +372,9 @@ std::unique_ptr<Mesh> Primitives::CreateCone(float radius, float height, unsigne
         indices.push_back(3 + (i * 2));
     }
     
+    MeshOptimizer::Optimize(vertices, indices);
     auto mesh = std::make_unique<Mesh>();
-    mesh->SetVertices(vertices);
-    mesh->SetIndices(indices);
+    mesh->SetGeometry(vertices, indices, Mesh::BuildLodChain(vertices, indices));
     
     return mesh;
 }
@@ -299,27 +382,27 @@ std::unique_ptr<Mesh> Primitives::CreateCone(float radius, float height, unsigne
 std::unique_ptr<SceneObject> Primitives::CreatePrimitiveObject(const std::string& type, const std::string& name)
 {
     auto object = std::make_unique<SceneObject>(name);
-    std::unique_ptr<Mesh> mesh;
+    std::shared_ptr<Mesh> mesh;
     
     if (type == "Cube")
     {
-        mesh = CreateCube();
+        mesh = GetCube();
     }
     else if (type == "Sphere")
     {
-        mesh = CreateSphere();
+        mesh = GetSphere();
     }
     else if (type == "Plane")
     {
-        mesh = CreatePlane();
+        mesh = GetPlane();
     }
     else if (type == "Cylinder")
     {
-        mesh = CreateCylinder();
+        mesh = GetCylinder();
     }
     else if (type == "Cone")
     {
-        mesh = CreateCone();
+        mesh = GetCone();
     }
     else
     {
@@ -327,7 +410,7 @@ std::unique_ptr<SceneObject> Primitives::CreatePrimitiveObject(const std::string
         return nullptr;
     }
 
-    object->SetMesh(std::move(mesh));
+    object->SetMesh(mesh);
 
     ResourceManager* resourceManager = ResourceManager::GetInstance();
     Shader* shader = resourceManager->GetShader("default");
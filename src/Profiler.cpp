@@ -0,0 +1,141 @@
+#include "Profiler.h"
+
+#ifdef ENABLE_PROFILER
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+Profiler* Profiler::GetInstance()
+{
+    static Profiler instance;
+    return &instance;
+}
+
+uint64_t Profiler::Now()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+{
+    thread_local ThreadBuffer* threadBuffer = nullptr;
+    if (!threadBuffer)
+    {
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->events.resize(ThreadBuffer::CAPACITY);
+
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffer->threadId = static_cast<uint32_t>(buffers.size()) + 1;
+        buffer->threadName = "Thread " + std::to_string(buffer->threadId);
+        threadBuffer = buffer.get();
+        buffers.push_back(std::move(buffer));
+    }
+    return threadBuffer;
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffer->threadName = name;
+}
+
+void Profiler::Record(const char* name, uint64_t startNs, uint64_t endNs)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+
+    std::size_t index = buffer->count.load(std::memory_order_relaxed);
+    if (index >= ThreadBuffer::CAPACITY)
+    {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer->events[index] = { name, startNs, endNs - startNs };
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+bool Profiler::BeginCapture(int frameCount, const std::string& filepath)
+{
+    if (IsCapturing())
+    {
+        std::cerr << "A CPU trace capture is already running" << std::endl;
+        return false;
+    }
+    if (frameCount <= 0)
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for (auto& buffer : buffers)
+        {
+            buffer->count.store(0, std::memory_order_relaxed);
+            buffer->dropped.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    framesRemaining = frameCount;
+    capturePath = filepath;
+    captureStartNs = Now();
+    capturing.store(true, std::memory_order_release);
+    return true;
+}
+
+void Profiler::EndFrame()
+{
+    if (!IsCapturing() || --framesRemaining > 0)
+        return;
+
+    capturing.store(false, std::memory_order_release);
+    WriteCapture();
+}
+
+bool Profiler::WriteCapture()
+{
+    std::ofstream file(capturePath);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open file for writing CPU trace: " << capturePath << std::endl;
+        return false;
+    }
+
+    // Complete ("X") events with microsecond timestamps, plus thread name metadata
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+    bool first = true;
+    std::size_t eventCount = 0;
+    std::size_t droppedCount = 0;
+    for (const auto& buffer : buffers)
+    {
+        file << (first ? "" : ",\n")
+             << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+             << ",\"args\":{\"name\":\"" << buffer->threadName << "\"}}";
+        first = false;
+
+        std::size_t count = buffer->count.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const Event& event = buffer->events[i];
+            uint64_t start = event.startNs > captureStartNs ? event.startNs - captureStartNs : 0;
+            file << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                 << ",\"ts\":" << start / 1000.0 << ",\"dur\":" << event.durationNs / 1000.0 << "}";
+        }
+
+        eventCount += count;
+        droppedCount += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    file << "\n]}\n";
+
+    std::cout << "CPU trace written to " << capturePath << " (" << eventCount << " events";
+    if (droppedCount > 0)
+        std::cout << ", " << droppedCount << " dropped";
+    std::cout << ")" << std::endl;
+    return true;
+}
+
+#endif
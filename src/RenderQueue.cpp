@@ -0,0 +1,141 @@
+#include "RenderQueue.h"
+#include "Profiler.h"
+#include <utility>
+
+namespace {
+    // Element moves the insertion sort may spend per item before the radix sort takes over
+    constexpr std::size_t MAX_PATCH_MOVES_PER_ITEM = 2;
+}
+
+uint64_t RenderQueue::MakeSortKey(RenderPass pass, uint32_t depthSlice, uint32_t shader, uint32_t mesh, uint32_t material, uint32_t depth)
+{
+    if (pass == RenderPass::Transparent)
+    {
+        return (static_cast<uint64_t>(pass) & 0xF) << 60 |
+               (static_cast<uint64_t>(0xFFFF - (depth & 0xFFFF))) << 44 |
+               (static_cast<uint64_t>(shader) & 0xFFF) << 32 |
+               (static_cast<uint64_t>(mesh) & 0xFFFF) << 16 |
+               (static_cast<uint64_t>(material) & 0xFFFF);
+    }
+
+    return (static_cast<uint64_t>(pass) & 0xF) << 60 |
+           (static_cast<uint64_t>(depthSlice) & 0xF) << 56 |
+           (static_cast<uint64_t>(shader) & 0xFFF) << 44 |
+           (static_cast<uint64_t>(mesh) & 0xFFFF) << 28 |
+           (static_cast<uint64_t>(material) & 0xFFFF) << 12 |
+           (static_cast<uint64_t>(depth >> 4) & 0xFFF);
+}
+
+void RenderQueue::Sort()
+{
+    PROFILE_SCOPE("RenderQueue::Sort");
+
+    const std::size_t count = items.size();
+    sortIncremental = false;
+
+    entries.resize(count);
+    scratchEntries.resize(count);
+    if (!PatchPreviousOrder())
+    {
+        for (std::size_t i = 0; i < count; i++)
+            entries[i] = { items[i].sortKey, static_cast<uint32_t>(i) };
+        RadixSortEntries();
+    }
+
+    // Remember this frame's input and result for the next one
+    previousObjects.resize(count);
+    previousOrder.resize(count);
+    scratch.resize(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        previousObjects[i] = items[i].object;
+        previousOrder[i] = entries[i].index;
+        scratch[i] = items[entries[i].index];
+    }
+    items.swap(scratch);
+}
+
+bool RenderQueue::PatchPreviousOrder()
+{
+    const std::size_t count = items.size();
+    if (count != previousObjects.size())
+        return false;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        if (items[i].object != previousObjects[i])
+            return false;
+    }
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        uint32_t index = previousOrder[i];
+        entries[i] = { items[index].sortKey, index };
+    }
+
+    // Ties break on the insertion index, like the stable radix sort
+    auto less = [](const SortEntry& a, const SortEntry& b) {
+        return a.key < b.key || (a.key == b.key && a.index < b.index);
+    };
+
+    std::size_t movesLeft = count * MAX_PATCH_MOVES_PER_ITEM;
+    for (std::size_t i = 1; i < count; i++)
+    {
+        SortEntry entry = entries[i];
+        std::size_t j = i;
+        while (j > 0 && less(entry, entries[j - 1]))
+        {
+            if (movesLeft == 0)
+                return false;
+            movesLeft--;
+            entries[j] = entries[j - 1];
+            j--;
+        }
+        entries[j] = entry;
+    }
+
+    sortIncremental = true;
+    return true;
+}
+
+void RenderQueue::RadixSortEntries()
+{
+    const std::size_t count = entries.size();
+    if (count < 2)
+        return;
+
+    // Bits that differ between at least two keys; byte passes outside of it are skipped
+    uint64_t firstKey = entries[0].key;
+    uint64_t differingBits = 0;
+    for (const auto& entry : entries)
+        differingBits |= entry.key ^ firstKey;
+
+    SortEntry* source = entries.data();
+    SortEntry* destination = scratchEntries.data();
+
+    for (unsigned int shift = 0; shift < 64; shift += 8)
+    {
+        if (((differingBits >> shift) & 0xFF) == 0)
+            continue;
+
+        std::size_t offsets[256] = { 0 };
+        for (std::size_t i = 0; i < count; i++)
+            offsets[(source[i].key >> shift) & 0xFF]++;
+
+        std::size_t sum = 0;
+        for (std::size_t& offset : offsets)
+        {
+            std::size_t bucketSize = offset;
+            offset = sum;
+            sum += bucketSize;
+        }
+
+        for (std::size_t i = 0; i < count; i++)
+            destination[offsets[(source[i].key >> shift) & 0xFF]++] = source[i];
+
+        std::swap(source, destination);
+    }
+
+    // An odd number of passes leaves the result in the scratch buffer
+    if (source != entries.data())
+        entries.swap(scratchEntries);
+}
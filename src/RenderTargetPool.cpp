@@ -0,0 +1,115 @@
+#include "RenderTargetPool.h"
+#include "GLState.h"
+#include <algorithm>
+
+RenderTargetPool::~RenderTargetPool()
+{
+    Clear();
+}
+
+GLuint RenderTargetPool::Acquire(const RenderTargetDesc& desc)
+{
+    for (Entry& entry : entries)
+    {
+        if (!entry.inUse && entry.desc == desc)
+        {
+            entry.inUse = true;
+            entry.unusedFrames = 0;
+            return entry.texture;
+        }
+    }
+
+    Entry entry;
+    entry.desc = desc;
+    entry.inUse = true;
+
+    glGenTextures(1, &entry.texture);
+    GLState::GetInstance()->BindTextureForEditing(GL_TEXTURE_2D, entry.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, desc.internalFormat, desc.width, desc.height, 0, desc.format, desc.type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, desc.filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, desc.filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    entries.push_back(entry);
+    return entry.texture;
+}
+
+void RenderTargetPool::Release(GLuint texture)
+{
+    if (texture == 0)
+        return;
+
+    for (Entry& entry : entries)
+    {
+        if (entry.texture == texture)
+        {
+            entry.inUse = false;
+            entry.unusedFrames = 0;
+            return;
+        }
+    }
+}
+
+void RenderTargetPool::BeginFrame()
+{
+    for (Entry& entry : entries)
+    {
+        if (!entry.inUse)
+            entry.unusedFrames++;
+    }
+
+    auto expired = [](const Entry& entry) { return !entry.inUse && entry.unusedFrames > MAX_UNUSED_FRAMES; };
+    for (const Entry& entry : entries)
+    {
+        if (expired(entry))
+            DeleteTexture(entry.texture);
+    }
+    entries.erase(std::remove_if(entries.begin(), entries.end(), expired), entries.end());
+}
+
+void RenderTargetPool::Clear()
+{
+    for (const Entry& entry : entries)
+        DeleteTexture(entry.texture);
+    entries.clear();
+}
+
+RenderTargetPool::Stats RenderTargetPool::GetStats() const
+{
+    Stats stats;
+    for (const Entry& entry : entries)
+    {
+        stats.textures++;
+        if (entry.inUse)
+            stats.texturesInUse++;
+        stats.bytes += GetBytesPerPixel(entry.desc.internalFormat) * entry.desc.width * entry.desc.height;
+    }
+    return stats;
+}
+
+std::size_t RenderTargetPool::GetBytesPerPixel(GLenum internalFormat)
+{
+    switch (internalFormat)
+    {
+    case GL_RGBA32F: return 16;
+    case GL_RGBA16F: return 8;
+    case GL_RGBA8:
+    case GL_RG16:
+    case GL_R32F:
+    case GL_DEPTH24_STENCIL8:
+    case GL_DEPTH_COMPONENT32F: return 4;
+    case GL_DEPTH_COMPONENT24: return 4;   // Padded to 32 bits by most drivers
+    case GL_RG8:
+    case GL_R16F:
+    case GL_DEPTH_COMPONENT16: return 2;
+    case GL_R8: return 1;
+    default: return 4;
+    }
+}
+
+void RenderTargetPool::DeleteTexture(GLuint texture)
+{
+    GLState::GetInstance()->OnTextureDeleted(texture);
+    glDeleteTextures(1, &texture);
+}
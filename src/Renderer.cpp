@@ -4,9 +4,97 @@
 #include "SceneObject.h"
 #include "Shader.h"
 #include "ResourceManager.h"
+#include "Profiler.h"
+#include "GLState.h"
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iterator>
 #include <GLFW/glfw3.h>
 
+namespace {
+    // Per-draw uniforms, hashed at compile time
+    constexpr UniformId UNIFORM_MODEL("model");
+    constexpr UniformId UNIFORM_TIME("time");
+    constexpr UniformId UNIFORM_MATERIAL_AMBIENT("material.ambient");
+    constexpr UniformId UNIFORM_MATERIAL_DIFFUSE("material.diffuse");
+    constexpr UniformId UNIFORM_MATERIAL_SPECULAR("material.specular");
+    constexpr UniformId UNIFORM_MATERIAL_SHININESS("material.shininess");
+    constexpr UniformId UNIFORM_TESS_LEVEL_OUTER("tessLevelOuter");
+    constexpr UniformId UNIFORM_TESS_LEVEL_INNER("tessLevelInner");
+    constexpr UniformId UNIFORM_DISPLACE_AMOUNT("displaceAmount");
+    constexpr UniformId UNIFORM_ADAPTIVE_TESSELLATION("adaptiveTessellation");
+    constexpr UniformId UNIFORM_CULL_BACKFACING_PATCHES("cullBackfacingPatches");
+    constexpr UniformId UNIFORM_TRIANGLE_SIZE("triangleSize");
+    constexpr UniformId UNIFORM_MAX_TESS_LEVEL("maxTessLevel");
+    constexpr UniformId UNIFORM_VIEWPORT_SIZE("viewportSize");
+    constexpr UniformId UNIFORM_G_POSITION("gPosition");
+    constexpr UniformId UNIFORM_G_NORMAL("gNormal");
+    constexpr UniformId UNIFORM_G_ALBEDO_SPEC("gAlbedoSpec");
+    constexpr UniformId UNIFORM_G_DEPTH("gDepth");
+    constexpr UniformId UNIFORM_INVERSE_PROJECTION("inverseProjection");
+    constexpr UniformId UNIFORM_INVERSE_VIEW("inverseView");
+    constexpr UniformId UNIFORM_SCENE_COLOR("sceneColor");
+    constexpr UniformId UNIFORM_SHARPNESS("sharpness");
+    constexpr UniformId UNIFORM_SELECTION_MASK("selectionMask");
+    constexpr UniformId UNIFORM_OUTLINE_COLOR("outlineColor");
+    constexpr UniformId UNIFORM_OUTLINE_WIDTH("outlineWidth");
+    
+    const char* const COMPACT_GBUFFER_DEFINE = "COMPACT_GBUFFER";
+    const char* const TILED_LIGHTING_DEFINE = "TILED_LIGHTING";
+    // Looked up for every queued object, kept as a string so the lookup doesn't allocate
+    const std::string CLUSTERED_LIGHTING_DEFINE = "CLUSTERED_LIGHTING";
+    
+    // Units after the G-buffer textures
+    constexpr GLuint LIGHT_GRID_TEXTURE_UNIT = 3;
+    // Forward shaders keep the low units for their own textures
+    constexpr GLuint CLUSTER_GRID_TEXTURE_UNIT = 3;
+    
+    // Strength of the sharpening applied when upscaling a reduced resolution frame
+    constexpr float UPSCALE_SHARPNESS = 0.25f;
+    
+    // Selection outline color and thickness in render target pixels
+    const glm::vec4 SELECTION_OUTLINE_COLOR = glm::vec4(1.0f, 0.6f, 0.0f, 1.0f);
+    constexpr int SELECTION_OUTLINE_WIDTH = 2;
+    
+    // Fraction of the LOD pixel error an object must pass before it changes level
+    constexpr float LOD_HYSTERESIS = 0.25f;
+    
+    // Occluders must cover this fraction of the screen height, and at most this many of the
+    // largest are rasterised. Their LOD may deviate this many occlusion buffer pixels.
+    constexpr float OCCLUDER_MIN_SCREEN_SIZE = 0.1f;
+    constexpr std::size_t MAX_OCCLUDERS = 64;
+    constexpr float OCCLUDER_PIXEL_ERROR = 1.0f;
+    
+    // FNV-1a over the raw material values, folded to the 16 bits of the sort key
+    uint32_t HashMaterial(const Material& material)
+    {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&material);
+        uint32_t hash = 2166136261u;
+        for (std::size_t i = 0; i < sizeof(Material); i++)
+        {
+            hash ^= bytes[i];
+            hash *= 16777619u;
+        }
+        return (hash >> 16) ^ (hash & 0xFFFF);
+    }
+    
+    std::size_t GetTriangleCount(const Mesh* mesh, const Model* model, int lod = 0)
+    {
+        if (mesh)
+            return mesh->GetLodTriangleCount(lod);
+        return model ? model->GetTriangleCount(lod) : 0;
+    }
+    
+    uint32_t QuantizeDepth(float viewDepth, float farPlane)
+    {
+        float normalized = glm::clamp(viewDepth / farPlane, 0.0f, 1.0f);
+        return static_cast<uint32_t>(normalized * 65535.0f);
+    }
+}
+
 Renderer::Renderer() = default;
 
 Renderer::~Renderer()
@@ -22,50 +110,133 @@ bool Renderer::Initialize()
         return false;
     }
 
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_MULTISAMPLE);
+    GLState* state = GLState::GetInstance();
+    state->Initialize();
+    state->SetEnabled(GL_DEPTH_TEST, true);
+    state->SetEnabled(GL_MULTISAMPLE, true);
+    
+    if (GLFWwindow* window = glfwGetCurrentContext())
+    {
+        int width = 0, height = 0;
+        glfwGetFramebufferSize(window, &width, &height);
+        SetDisplaySize(width, height);
+    }
     
     SetupScreenQuad();
+    SetupUniformBuffers();
+    gpuProfiler.Initialize();
+    lightGrid.Initialize();
+    clusterGrid.Initialize();
+    tessellationPrimitives.Initialize();
+    
+    // The tessellator's limit is at least 64
+    GLint maxTessGenLevel = 0;
+    glGetIntegerv(GL_MAX_TESS_GEN_LEVEL, &maxTessGenLevel);
+    if (maxTessGenLevel > 0)
+        maxTessellationLevel = static_cast<float>(maxTessGenLevel);
+    tessellationCache.Initialize(maxTessellationLevel);
     
     return true;
 }
 
 void Renderer::Shutdown()
 {
+    CleanupUniformBuffers();
+    gpuProfiler.Shutdown();
+    lightGrid.Shutdown();
+    clusterGrid.Shutdown();
+    tessellationPrimitives.Shutdown();
+    tessellationCache.Shutdown();
+    
+    if (deferredSetupComplete)
+    {
+        ReleaseGBuffer();
+        deferredSetupComplete = false;
+    }
+    ReleaseSceneTarget();
+    ReleaseSelectionTarget();
+    renderTargets.Clear();
+    
+    if (instanceVBO)
+    {
+        GLState::GetInstance()->OnBufferDeleted(instanceVBO);
+        glDeleteBuffers(1, &instanceVBO);
+    }
+    instanceVBO = 0;
+    instanceBufferCapacity = 0;
+    
+    if (selectionInstanceVBO)
+    {
+        GLState::GetInstance()->OnBufferDeleted(selectionInstanceVBO);
+        glDeleteBuffers(1, &selectionInstanceVBO);
+    }
+    selectionInstanceVBO = 0;
+    selectionBufferCapacity = 0;
 }
 
 void Renderer::BeginFrame()
 {
     currentTime = static_cast<float>(glfwGetTime());
+    stats = RenderStats();
+    gpuProfiler.BeginFrame();
+    tessellationPrimitives.BeginFrame();
+    tessellationCache.BeginFrame();
+    renderTargets.BeginFrame();
+    
+    // Timings arrive a few frames late, so the scale reacts to the frame before last
+    dynamicResolution.Update(gpuProfiler.GetLastFrameMs());
+    UpdateRenderResolution();
+    
+    GLState* state = GLState::GetInstance();
+    state->ResetStats();
     
+    state->BindFramebuffer(sceneFramebuffer);
+    state->Viewport(0, 0, renderWidth, renderHeight);
+    
+    // Clearing respects the depth mask, and the frame starts with opaque geometry
+    state->DepthMask(true);
+    state->SetEnabled(GL_BLEND, false);
     glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    if (depthTestEnabled)
-        glEnable(GL_DEPTH_TEST);
-    else
-        glDisable(GL_DEPTH_TEST);
+    state->SetEnabled(GL_DEPTH_TEST, depthTestEnabled);
 
     switch (renderMode)
     {
     case RenderMode::Wireframe:
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        state->PolygonMode(GL_LINE);
         break;
     case RenderMode::Solid:
     case RenderMode::Deferred:
+    case RenderMode::ClusteredForward:
     case RenderMode::Tessellation:
     case RenderMode::TessellationWithWireframe:
     default:
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        state->PolygonMode(GL_FILL);
         break;
     }
 }
 
 void Renderer::Render(Scene* scene, Camera* camera)
 {
+    PROFILE_SCOPE("Renderer::Render");
+    
     if (!scene || !camera)
         return;
     
+    RenderScene(scene, camera);
+    RenderSelectionOutline(scene);
+    
+    // Below display resolution the scene went to the offscreen target
+    if (sceneFramebuffer)
+        UpscaleToDisplay();
+}
+
+void Renderer::RenderScene(Scene* scene, Camera* camera)
+{
+    UpdateUniformBuffers(scene, camera);
+    frustum.Update(camera->GetProjectionMatrix() * camera->GetViewMatrix());
+    
     if (renderMode == RenderMode::Deferred) {
         Shader* gBufferShader = ResourceManager::GetInstance()->GetShader("deferred/gbuffer");
         Shader* lightingShader = ResourceManager::GetInstance()->GetShader("deferred/deferred_lighting");
@@ -95,6 +266,10 @@ void Renderer::Render(Scene* scene, Camera* camera)
             return;
         }
     }
+    else if (renderMode == RenderMode::ClusteredForward) {
+        RenderClusteredForward(scene, camera);
+        return;
+    }
     else if (renderMode == RenderMode::Tessellation || renderMode == RenderMode::TessellationWithWireframe) {
         Shader* tessShader = ResourceManager::GetInstance()->GetShader("tessellation");
         if (!tessShader) {
@@ -116,11 +291,45 @@ void Renderer::Render(Scene* scene, Camera* camera)
         }
     }
 
+    BuildRenderQueue(scene, camera);
+    SubmitRenderQueue("Forward", true);
+}
+
+void Renderer::BuildRenderQueue(Scene* scene, Camera* camera, Shader* shaderOverride)
+{
+    PROFILE_SCOPE("Renderer::BuildRenderQueue");
+    
+    renderQueue.Clear();
+    queueBuildCount++;
+    queueGeometryCount = 0;
+    
     glm::mat4 viewMatrix = camera->GetViewMatrix();
-    glm::mat4 projectionMatrix = camera->GetProjectionMatrix();
+    float farPlane = camera->GetFarPlane();
+    glm::vec3 cameraPosition = camera->GetPosition();
     
-    // Render each object in the scene
-    for (auto& object : scene->GetObjects())
+    // Pixels covered by one world unit at distance one, for projecting LOD errors
+    float pixelsPerUnit = camera->GetProjectionMatrix()[1][1] * 0.5f * static_cast<float>(renderHeight);
+    
+    // With culling on, only objects the scene's BVH reports inside the frustum are considered
+    cullCandidates.clear();
+    if (frustumCullingEnabled)
+    {
+        scene->QueryFrustum(frustum, cullCandidates);
+        
+        // Culled means indexed but rejected by the query; objects without bounds aren't indexed
+        int indexed = scene->GetSpatialIndex().GetProxyCount();
+        stats.culledObjects += indexed - static_cast<int>(cullCandidates.size());
+    }
+    else
+    {
+        for (auto& object : scene->GetObjects())
+            cullCandidates.push_back(object.get());
+    }
+    
+    if (occlusionCullingEnabled)
+        RasterizeOccluders(camera);
+    
+    for (SceneObject* object : cullCandidates)
     {
         if (!object->IsVisible())
             continue;
@@ -128,74 +337,577 @@ void Renderer::Render(Scene* scene, Camera* camera)
         Shader* shader = object->GetShader();
         if (!shader)
             continue;
+        
+        if (occlusionCullingEnabled && !occlusionCuller.IsVisible(object->GetWorldBounds()))
+        {
+            stats.occludedObjects++;
+            continue;
+        }
+        
+        stats.visibleObjects++;
+        
+        // Passes with a single program (G-buffer) key every item on it so runs group by mesh only
+        if (shaderOverride)
+        {
+            shader = shaderOverride;
+        }
+        else if (renderMode == RenderMode::ClusteredForward)
+        {
+            // Shaders without the shared light include keep reading the first MAX_LIGHTS lights
+            if (Shader* clusteredShader = shader->GetVariant(CLUSTERED_LIGHTING_DEFINE))
+                shader = clusteredShader;
+        }
+        
+        RenderItem item;
+        item.object = object;
+        item.shader = shader;
+        item.mesh = object->GetMesh();
+        item.model = object->GetModel();
+        
+        if (!item.mesh && !item.model)
+            continue;
+        
+        // VAO names can exceed the 13 bits next to the level and collide; numbering geometry in
+        // order of appearance keeps up to 8192 meshes per frame apart
+        GeometryKey& geometryKey = geometryKeys[item.GetGeometry()];
+        if (geometryKey.build != queueBuildCount)
+        {
+            geometryKey.build = queueBuildCount;
+            geometryKey.index = queueGeometryCount++;
+        }
+        
+        glm::vec3 position = glm::vec3(object->GetTransform()[3]);
+        float viewDepth = -(viewMatrix * glm::vec4(position, 1.0f)).z;
+        uint32_t depth = QuantizeDepth(viewDepth, farPlane);
+        
+        item.lod = SelectLod(object, cameraPosition, pixelsPerUnit);
+        stats.lodObjects[item.lod]++;
+        
+        // A single-program pass writes a G-buffer and can't blend, so everything is opaque there
+        RenderPass pass = RenderPass::Opaque;
+        if (!shaderOverride && object->GetMaterial().IsTranslucent())
+        {
+            pass = RenderPass::Transparent;
+            stats.transparentObjects++;
+        }
+        uint32_t depthSlice = frontToBackEnabled ? depth * RenderQueue::DEPTH_SLICES >> 16 : 0;
+        
+        // Levels of one mesh stay adjacent so they still batch per level
+        item.sortKey = RenderQueue::MakeSortKey(pass, depthSlice, shader->GetID(), (geometryKey.index << 3) | static_cast<uint32_t>(item.lod), 
+                                                HashMaterial(object->GetMaterial()), depth);
+        renderQueue.Add(item);
+    }
+    
+    // Unloaded or long-culled geometry keeps its entry until stale ones outnumber the live ones
+    if (geometryKeys.size() > 2 * static_cast<std::size_t>(queueGeometryCount) + 1024)
+    {
+        for (auto it = geometryKeys.begin(); it != geometryKeys.end();)
+            it = it->second.build != queueBuildCount ? geometryKeys.erase(it) : std::next(it);
+    }
+    
+    renderQueue.Sort();
+    stats.renderItems = static_cast<int>(renderQueue.Size());
+    stats.incrementalSort = renderQueue.WasSortIncremental();
+}
+
+bool Renderer::IsInFrustum(SceneObject* object, float margin)
+{
+    if (!frustumCullingEnabled)
+        return true;
+    
+    // Objects without geometry bounds are never culled
+    BoundingSphere sphere = object->GetWorldBoundingSphere();
+    if (!sphere.IsValid())
+        return true;
+    
+    sphere.radius += margin;
+    if (!frustum.Intersects(sphere))
+        return false;
+    
+    // The box is tighter for elongated objects the sphere test lets through
+    BoundingBox box = object->GetWorldBounds();
+    box.min -= glm::vec3(margin);
+    box.max += glm::vec3(margin);
+    return frustum.Intersects(box);
+}
+
+void Renderer::RasterizeOccluders(Camera* camera)
+{
+    PROFILE_SCOPE("Renderer::RasterizeOccluders");
+    
+    glm::vec3 cameraPosition = camera->GetPosition();
+    float projectionScale = camera->GetProjectionMatrix()[1][1];
+    occlusionCuller.BeginFrame(camera->GetProjectionMatrix() * camera->GetViewMatrix());
+    
+    // Only undisplaced geometry occludes: shaders that move vertices don't declare an invariant
+    // position (see the depth pre-pass)
+    occluderCandidates.clear();
+    for (SceneObject* object : cullCandidates)
+    {
+        Shader* shader = object->GetShader();
+        const BoundingSphere& sphere = object->GetWorldBoundingSphere();
+        if (!object->IsVisible() || !shader || !shader->HasInvariantPosition() || !sphere.IsValid() ||
+            object->GetMaterial().IsTranslucent() || (!object->GetMesh() && !object->GetModel()))
+            continue;
+        
+        float distance = std::max(glm::length(sphere.center - cameraPosition), camera->GetNearPlane());
+        float screenSize = sphere.radius * projectionScale / distance;
+        if (screenSize >= OCCLUDER_MIN_SCREEN_SIZE)
+            occluderCandidates.push_back({ screenSize, object });
+    }
+    
+    std::size_t occluderCount = std::min(occluderCandidates.size(), MAX_OCCLUDERS);
+    std::partial_sort(occluderCandidates.begin(), occluderCandidates.begin() + occluderCount, occluderCandidates.end(),
+                      [](const auto& a, const auto& b) { return a.first > b.first; });
+    
+    float pixelsPerUnit = projectionScale * 0.5f * static_cast<float>(occlusionCuller.GetHeight());
+    for (std::size_t i = 0; i < occluderCount; i++)
+    {
+        SceneObject* object = occluderCandidates[i].second;
+        const Mesh* mesh = object->GetMesh();
+        const Model* model = object->GetModel();
+        glm::mat4 transform = object->GetTransform();
+        
+        // Coarsest level that stays within the error bound at the buffer's resolution
+        const BoundingSphere& sphere = object->GetWorldBoundingSphere();
+        const BoundingSphere& localSphere = mesh ? mesh->GetBoundingSphere() : model->GetBoundingSphere();
+        float distance = glm::length(sphere.center - cameraPosition) - sphere.radius;
+        int lodCount = mesh ? mesh->GetLodCount() : model->GetLodCount();
+        int lod = 0;
+        if (distance > 0.0f && localSphere.radius > 0.0f)
+        {
+            float errorScale = sphere.radius / localSphere.radius * pixelsPerUnit / distance;
+            while (lod + 1 < lodCount &&
+                   (mesh ? mesh->GetLodError(lod + 1) : model->GetLodError(lod + 1)) * errorScale <= OCCLUDER_PIXEL_ERROR)
+                lod++;
+        }
+        
+        auto addMesh = [&](const Mesh& occluder) {
+            occlusionCuller.AddOccluder(occluder.GetVertices().data(), occluder.GetVertices().size(), occluder.GetLodIndices(lod),
+                                        occluder.GetLodTriangleCount(lod) * 3, transform);
+        };
+        if (mesh)
+        {
+            addMesh(*mesh);
+        }
+        else
+        {
+            for (const auto& modelMesh : model->GetMeshes())
+            {
+                if (modelMesh)
+                    addMesh(*modelMesh);
+            }
+        }
+    }
+    
+    occlusionCuller.RasterizeOccluders();
+    stats.occluders = occlusionCuller.GetStats().occluders;
+    stats.occluderTriangles = occlusionCuller.GetStats().rasterizedTriangles;
+}
+
+int Renderer::SelectLod(SceneObject* object, const glm::vec3& cameraPosition, float pixelsPerUnit)
+{
+    const Mesh* mesh = object->GetMesh();
+    const Model* model = object->GetModel();
+    int lodCount = mesh ? mesh->GetLodCount() : (model ? model->GetLodCount() : 1);
+    
+    const BoundingSphere& sphere = object->GetWorldBoundingSphere();
+    const BoundingSphere& localSphere = mesh ? mesh->GetBoundingSphere() : model->GetBoundingSphere();
+    float distance = sphere.IsValid() ? glm::length(sphere.center - cameraPosition) - sphere.radius : 0.0f;
+    if (!lodEnabled || lodCount <= 1 || distance <= 0.0f || localSphere.radius <= 0.0f)
+    {
+        object->SetLodLevel(0);
+        return 0;
+    }
+    
+    // LOD errors are in model units, the world sphere carries the object's scale
+    float errorScale = sphere.radius / localSphere.radius * pixelsPerUnit / distance;
+    auto projectedError = [&](int lod) {
+        return (mesh ? mesh->GetLodError(lod) : model->GetLodError(lod)) * errorScale;
+    };
+    
+    // Switch finer once the current level is clearly visible, coarser once the next one is clearly
+    // not, so objects near a threshold don't flicker between levels
+    int lod = std::clamp(object->GetLodLevel(), 0, lodCount - 1);
+    while (lod > 0 && projectedError(lod) > lodPixelError * (1.0f + LOD_HYSTERESIS))
+        lod--;
+    while (lod + 1 < lodCount && projectedError(lod + 1) <= lodPixelError * (1.0f - LOD_HYSTERESIS))
+        lod++;
+    
+    object->SetLodLevel(lod);
+    return lod;
+}
+
+void Renderer::BuildDrawBatches()
+{
+    PROFILE_SCOPE("Renderer::BuildDrawBatches");
+    
+    static const std::string instancedDefine = "INSTANCED";
+    
+    drawBatches.clear();
+    instanceData.clear();
+    
+    const auto& items = renderQueue.GetItems();
+    std::size_t first = 0;
+    while (first < items.size())
+    {
+        const RenderItem& item = items[first];
+        
+        DrawBatch batch;
+        batch.firstItem = first;
+        batch.itemCount = 1;
+        batch.shader = item.shader;
+        batch.transparent = RenderQueue::GetPass(item.sortKey) == RenderPass::Transparent;
+        
+        // Items are sorted by shader then mesh, so instancing candidates are already adjacent.
+        // Transparent items blend with their own opacity, one draw each.
+        if (instancingEnabled && !batch.transparent)
+        {
+            std::size_t last = first + 1;
+            while (last < items.size() &&
+                   RenderQueue::GetPass(items[last].sortKey) == RenderQueue::GetPass(item.sortKey) &&
+                   items[last].shader == item.shader &&
+                   items[last].GetGeometry() == item.GetGeometry() &&
+                   items[last].lod == item.lod)
+            {
+                last++;
+            }
             
-        shader->Use();
-        shader->SetInt("lightingModel", static_cast<int>(lightingModel));
+            Shader* instancedShader = (last - first > 1) ? batch.shader->GetVariant(instancedDefine) : nullptr;
+            if (instancedShader)
+            {
+                batch.itemCount = last - first;
+                batch.firstInstance = instanceData.size();
+                batch.shader = instancedShader;
+                batch.instanced = true;
+                
+                for (std::size_t i = first; i < last; i++)
+                {
+                    SceneObject* object = items[i].object;
+                    const Material& material = object->GetMaterial();
+                    
+                    InstanceData instance;
+                    instance.model = object->GetTransform();
+                    instance.ambient = glm::vec4(material.ambient, 1.0f);
+                    instance.diffuse = glm::vec4(material.diffuse, 1.0f);
+                    instance.specular = glm::vec4(material.specular, material.shininess);
+                    instanceData.push_back(instance);
+                }
+            }
+        }
+        
+        drawBatches.push_back(batch);
+        first += batch.itemCount;
+    }
+}
+
+void Renderer::UploadInstanceData()
+{
+    PROFILE_SCOPE("Renderer::UploadInstanceData");
+    
+    if (instanceData.empty())
+        return;
+    
+    GLState* state = GLState::GetInstance();
+    if (instanceVBO == 0)
+        instanceVBO = state->CreateBuffer();
+    
+    // Grow geometrically, otherwise orphan the old storage so the driver doesn't stall on in-flight draws
+    std::size_t requiredSize = instanceData.size() * sizeof(InstanceData);
+    if (requiredSize > instanceBufferCapacity)
+        instanceBufferCapacity = std::max(requiredSize, instanceBufferCapacity * 2);
+    
+    state->BufferData(GL_ARRAY_BUFFER, instanceVBO, instanceBufferCapacity, nullptr, GL_STREAM_DRAW);
+    state->BufferSubData(GL_ARRAY_BUFFER, instanceVBO, 0, requiredSize, instanceData.data());
+}
 
-        const auto& lights = scene->GetLights();
-        int numLights = static_cast<int>(lights.size());        shader->SetInt("numLights", numLights);
+void Renderer::SubmitRenderQueue(const char* passName, bool allowDepthPrepass)
+{
+    PROFILE_SCOPE(passName);
+    
+    BuildDrawBatches();
+    UploadInstanceData();
+    
+    // Lines don't cover what they occlude, so wireframe never takes the pre-pass
+    bool depthPrepass = allowDepthPrepass && depthPrepassEnabled && depthTestEnabled && renderMode != RenderMode::Wireframe;
+    if (depthPrepass)
+        RenderDepthPrepass();
+    
+    gpuProfiler.BeginPass(passName);
+    
+    GLState* state = GLState::GetInstance();
+    const auto& items = renderQueue.GetItems();
+    Shader* boundShader = nullptr;
+    const void* boundGeometry = nullptr;
+    
+    for (const DrawBatch& batch : drawBatches)
+    {
+        const RenderItem& item = items[batch.firstItem];
+        SceneObject* object = item.object;
+        
+        // Batches are grouped by shader, so this only flips where prepassed and other shaders meet
+        state->DepthFunc(batch.depthPrepassed ? GL_EQUAL : GL_LESS);
+        state->DepthMask(!batch.depthPrepassed && !batch.transparent);
+        
+        // Shaders write opaque colours, the blend constant carries the material opacity
+        state->SetEnabled(GL_BLEND, batch.transparent);
+        if (batch.transparent)
+        {
+            state->BlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+            state->BlendColor(0.0f, 0.0f, 0.0f, object->GetMaterial().opacity);
+        }
+        
+        Shader* shader = batch.shader;
+        if (shader != boundShader)
+        {
+            shader->Use();
+            ApplyFrameUniforms(shader);
+            boundShader = shader;
+            stats.programSwitches++;
+        }
         
-        // Pass each light to the shader
-        for (int i = 0; i < numLights; i++) {
-            const auto& light = lights[i];
-            std::string prefix = "lights[" + std::to_string(i) + "].";
+        if (item.GetGeometry() != boundGeometry)
+        {
+            boundGeometry = item.GetGeometry();
+            stats.vaoSwitches++;
+        }
+        
+        int meshCount = item.model ? static_cast<int>(item.model->GetMeshes().size()) : 1;
+        
+        if (batch.instanced)
+        {
+            std::size_t byteOffset = batch.firstInstance * sizeof(InstanceData);
+            int instanceCount = static_cast<int>(batch.itemCount);
+            if (item.mesh)
+                item.mesh->DrawInstanced(instanceVBO, byteOffset, instanceCount, Mesh::RenderMode::TRIANGLES, item.lod);
+            else if (item.model)
+                item.model->DrawInstanced(instanceVBO, byteOffset, instanceCount, Mesh::RenderMode::TRIANGLES, item.lod);
             
-            shader->SetVec3(prefix + "position", light.position);
-            shader->SetVec3(prefix + "color", light.color);
-            shader->SetFloat(prefix + "intensity", light.intensity);
+            stats.drawCalls += meshCount;
+            stats.triangles += GetTriangleCount(item.mesh, item.model, item.lod) * instanceCount;
+            stats.fullDetailTriangles += GetTriangleCount(item.mesh, item.model) * instanceCount;
+            stats.instancedBatches++;
+            stats.instancedObjects += instanceCount;
+            continue;
         }
         
-        // Set time uniform for all shaders for animations
-        shader->SetFloat("time", currentTime);
+        const Material& material = object->GetMaterial();
+        shader->SetVec3(UNIFORM_MATERIAL_AMBIENT, material.ambient);
+        shader->SetVec3(UNIFORM_MATERIAL_DIFFUSE, material.diffuse);
+        shader->SetVec3(UNIFORM_MATERIAL_SPECULAR, material.specular);
+        shader->SetFloat(UNIFORM_MATERIAL_SHININESS, material.shininess);
+        shader->SetMat4(UNIFORM_MODEL, object->GetTransform());
         
-        shader->SetVec3("viewPos", camera->GetPosition());
-
-        shader->SetVec3("material.ambient", object->GetMaterial().ambient);
-        shader->SetVec3("material.diffuse", object->GetMaterial().diffuse);
-        shader->SetVec3("material.specular", object->GetMaterial().specular);
-        shader->SetFloat("material.shininess", object->GetMaterial().shininess);
+        object->Draw(Mesh::RenderMode::TRIANGLES, item.lod);
+        stats.drawCalls += meshCount;
+        stats.triangles += GetTriangleCount(item.mesh, item.model, item.lod);
+        stats.fullDetailTriangles += GetTriangleCount(item.mesh, item.model);
+    }
+    
+    state->DepthFunc(GL_LESS);
+    state->DepthMask(true);
+    state->SetEnabled(GL_BLEND, false);
+    gpuProfiler.EndPass();
+}
 
-        glm::mat4 modelMatrix = object->GetTransform();
-        shader->SetMat4("model", modelMatrix);
-        shader->SetMat4("view", viewMatrix);
-        shader->SetMat4("projection", projectionMatrix);
+void Renderer::RenderDepthPrepass()
+{
+    PROFILE_SCOPE("Depth Prepass");
+    
+    ResourceManager* resources = ResourceManager::GetInstance();
+    Shader* depthShader = resources->GetShader("depth/depth_prepass");
+    if (!depthShader)
+    {
+        depthShader = resources->LoadShaderFromFile(
+            "depth/depth_prepass",
+            "resources/shaders/depth/depth_prepass.vert",
+            "resources/shaders/depth/depth_prepass.frag"
+        );
+    }
+    if (!depthShader)
+        return;
+    
+    static const std::string instancedDefine = "INSTANCED";
+    Shader* instancedDepthShader = depthShader->GetVariant(instancedDefine);
+    
+    GpuPassScope prepassTimer(gpuProfiler, "Depth Prepass");
+    
+    GLState* state = GLState::GetInstance();
+    state->ColorMask(false);
+    state->DepthFunc(GL_LESS);
+    state->DepthMask(true);
+    
+    const auto& items = renderQueue.GetItems();
+    Shader* boundShader = nullptr;
+    for (DrawBatch& batch : drawBatches)
+    {
+        const RenderItem& item = items[batch.firstItem];
+        Shader* shader = batch.instanced ? instancedDepthShader : depthShader;
+        if (!shader || batch.transparent || !item.shader->HasInvariantPosition())
+            continue;
+        
+        if (shader != boundShader)
+        {
+            shader->Use();
+            ApplyFrameUniforms(shader);
+            boundShader = shader;
+            stats.programSwitches++;
+        }
+        
+        int meshCount = item.model ? static_cast<int>(item.model->GetMeshes().size()) : 1;
+        if (batch.instanced)
+        {
+            std::size_t byteOffset = batch.firstInstance * sizeof(InstanceData);
+            int instanceCount = static_cast<int>(batch.itemCount);
+            if (item.mesh)
+                item.mesh->DrawDepthInstanced(instanceVBO, byteOffset, instanceCount, item.lod);
+            else if (item.model)
+                item.model->DrawDepthInstanced(instanceVBO, byteOffset, instanceCount, item.lod);
+        }
+        else
+        {
+            shader->SetMat4(UNIFORM_MODEL, item.object->GetTransform());
+            if (item.mesh)
+                item.mesh->DrawDepth(item.lod);
+            else if (item.model)
+                item.model->DrawDepth(item.lod);
+        }
         
-        object->Draw();
-        object->DrawHighlight(camera, currentTime);
+        batch.depthPrepassed = true;
+        stats.drawCalls += meshCount;
+        stats.depthPrepassDraws += meshCount;
+        stats.depthPrepassObjects += static_cast<int>(batch.itemCount);
     }
+    
+    state->ColorMask(true);
+}
+
+void Renderer::ApplyFrameUniforms(Shader* shader)
+{
+    // Camera and lights come from the FrameData/LightData blocks, only animation time is per program
+    shader->SetFloat(UNIFORM_TIME, currentTime);
+    
+    if (renderMode == RenderMode::ClusteredForward)
+        clusterGrid.Bind(shader, CLUSTER_GRID_TEXTURE_UNIT);
+}
+
+void Renderer::SetupUniformBuffers()
+{
+    GLState* state = GLState::GetInstance();
+    
+    frameUBO = state->CreateBuffer();
+    state->BufferData(GL_UNIFORM_BUFFER, frameUBO, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+    state->BindBufferBase(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, frameUBO);
+    
+    lightUBO = state->CreateBuffer();
+    state->BufferData(GL_UNIFORM_BUFFER, lightUBO, sizeof(LightData), nullptr, GL_DYNAMIC_DRAW);
+    state->BindBufferBase(GL_UNIFORM_BUFFER, LIGHT_DATA_BINDING, lightUBO);
+    
+    uniformBuffersUploaded = false;
+}
+
+void Renderer::CleanupUniformBuffers()
+{
+    GLState* state = GLState::GetInstance();
+    if (frameUBO)
+    {
+        state->OnBufferDeleted(frameUBO);
+        glDeleteBuffers(1, &frameUBO);
+    }
+    if (lightUBO)
+    {
+        state->OnBufferDeleted(lightUBO);
+        glDeleteBuffers(1, &lightUBO);
+    }
+    frameUBO = 0;
+    lightUBO = 0;
+    uniformBuffersUploaded = false;
+}
+
+void Renderer::UpdateUniformBuffers(Scene* scene, Camera* camera)
+{
+    PROFILE_SCOPE("Renderer::UpdateUniformBuffers");
+    
+    FrameData frameData;
+    frameData.view = camera->GetViewMatrix();
+    frameData.projection = camera->GetProjectionMatrix();
+    frameData.viewPos = camera->GetPosition();
+    frameData.lightingModel = static_cast<int>(lightingModel);
+    
+    const auto& lights = scene->GetLights();
+    int numLights = std::min(static_cast<int>(lights.size()), MAX_LIGHTS);
+    bool unlimitedLights = (renderMode == RenderMode::Deferred && tiledLightingEnabled) || renderMode == RenderMode::ClusteredForward;
+    if (static_cast<int>(lights.size()) > MAX_LIGHTS && !lightLimitWarned && !unlimitedLights) {
+        std::cerr << "Warning: Scene has " << lights.size() << " lights, only the first " << MAX_LIGHTS
+                  << " are used outside tiled deferred and clustered forward lighting" << std::endl;
+        lightLimitWarned = true;
+    }
+    
+    pendingLightData.numLights = numLights;
+    for (int i = 0; i < numLights; i++) {
+        pendingLightData.lights[i].position = lights[i].position;
+        pendingLightData.lights[i].intensity = lights[i].intensity;
+        pendingLightData.lights[i].color = lights[i].color;
+        pendingLightData.lights[i].range = lights[i].range;
+    }
+    
+    // Only upload what changed since the last frame
+    bool frameChanged = !uniformBuffersUploaded || std::memcmp(&frameData, &uploadedFrameData, sizeof(FrameData)) != 0;
+    bool lightsChanged = !uniformBuffersUploaded || pendingLightData.numLights != uploadedLightData.numLights ||
+        std::memcmp(pendingLightData.lights, uploadedLightData.lights, numLights * sizeof(LightBlockEntry)) != 0;
+    
+    GLState* state = GLState::GetInstance();
+    if (frameChanged) {
+        state->BufferSubData(GL_UNIFORM_BUFFER, frameUBO, 0, sizeof(FrameData), &frameData);
+        uploadedFrameData = frameData;
+        stats.uniformBufferUploads++;
+    }
+    
+    if (lightsChanged) {
+        state->BufferSubData(GL_UNIFORM_BUFFER, lightUBO, 0, numLights * sizeof(LightBlockEntry), pendingLightData.lights);
+        state->BufferSubData(GL_UNIFORM_BUFFER, lightUBO, offsetof(LightData, numLights), sizeof(int), &pendingLightData.numLights);
+        uploadedLightData = pendingLightData;
+        stats.uniformBufferUploads++;
+    }
+    
+    uniformBuffersUploaded = true;
 }
 
 void Renderer::EndFrame()
 {
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    glEnable(GL_DEPTH_TEST);
+    GLState* state = GLState::GetInstance();
+    state->PolygonMode(GL_FILL);
+    state->SetEnabled(GL_DEPTH_TEST, true);
 }
 
 void Renderer::PrepareForUIRendering()
 {
-    glDisable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDisable(GL_CULL_FACE);
+    GLState* state = GLState::GetInstance();
+    state->SetEnabled(GL_DEPTH_TEST, false);
+    state->SetEnabled(GL_BLEND, true);
+    state->BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    state->SetEnabled(GL_CULL_FACE, false);
 }
 
 void Renderer::RestoreAfterUIRendering()
 {
-    if (depthTestEnabled)
-        glEnable(GL_DEPTH_TEST);
-    else
-        glDisable(GL_DEPTH_TEST);
+    // ImGui's backend binds its own program, buffers and textures
+    GLState* state = GLState::GetInstance();
+    state->Invalidate();
+    
+    state->SetEnabled(GL_DEPTH_TEST, depthTestEnabled);
     
     switch (renderMode)
     {
     case RenderMode::Wireframe:
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        state->PolygonMode(GL_LINE);
         break;
     case RenderMode::Solid:
     case RenderMode::Deferred:
+    case RenderMode::ClusteredForward:
     case RenderMode::Tessellation:
     default:
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        state->PolygonMode(GL_FILL);
         break;
     }
 }
@@ -210,17 +922,18 @@ void Renderer::SetupScreenQuad()
          1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
     };
     
+    GLState* state = GLState::GetInstance();
     glGenVertexArrays(1, &quadVAO);
     glGenBuffers(1, &quadVBO);
-    glBindVertexArray(quadVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    state->BindVertexArray(quadVAO);
+    state->BindBuffer(GL_ARRAY_BUFFER, quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
     
-    glBindVertexArray(0);
+    state->BindVertexArray(0);
 }
 
 void Renderer::SetupDeferredRendering()
@@ -232,65 +945,65 @@ void Renderer::SetupDeferredRendering()
     
     std::cout << "Setting up deferred rendering..." << std::endl;
     
-    GLFWwindow* window = glfwGetCurrentContext();
-    if (!window) {
-        std::cerr << "Error: No valid GLFW context for setup!" << std::endl;
+    if (renderWidth <= 0 || renderHeight <= 0) {
+        std::cerr << "Error: No render resolution for the G-buffer!" << std::endl;
         return;
     }
     
-    int width, height;
-    glfwGetFramebufferSize(window, &width, &height);
-    
-    std::cout << "Framebuffer size: " << width << "x" << height << std::endl;
+    const int width = renderWidth;
+    const int height = renderHeight;
+    std::cout << "G-buffer size: " << width << "x" << height << std::endl;
+    gBufferWidth = width;
+    gBufferHeight = height;
     
     // G-buffer
+    GLState* state = GLState::GetInstance();
     glGenFramebuffers(1, &gBuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
-    
-    // Position buffer
-    glGenTextures(1, &gPosition);
-    glBindTexture(GL_TEXTURE_2D, gPosition);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gPosition, 0);
-    
-    // Normal buffer 
-    glGenTextures(1, &gNormal);
-    glBindTexture(GL_TEXTURE_2D, gNormal);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gNormal, 0);
-    
-    // Albedo and specular intensity buffer
-    glGenTextures(1, &gAlbedoSpec);
-    glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gAlbedoSpec, 0);
-    
-
-    unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
-    glDrawBuffers(3, attachments);
-    
-    // Create and attach a depth buffer
-    glGenRenderbuffers(1, &gDepth);
-    glBindRenderbuffer(GL_RENDERBUFFER, gDepth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, width, height);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, gDepth);
+    state->BindFramebuffer(gBuffer);
+    
+    auto createTarget = [&](unsigned int& texture, GLenum internalFormat, GLenum format, GLenum type, GLenum attachment) {
+        RenderTargetDesc desc;
+        desc.width = width;
+        desc.height = height;
+        desc.internalFormat = internalFormat;
+        desc.format = format;
+        desc.type = type;
+        texture = renderTargets.Acquire(desc);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture, 0);
+    };
+    
+    if (gBufferLayout == GBufferLayout::Compact)
+    {
+        // 12 bytes per pixel including depth, against 28 for the standard layout
+        createTarget(gNormal, GL_RG16, GL_RG, GL_UNSIGNED_SHORT, GL_COLOR_ATTACHMENT0);
+        createTarget(gAlbedoSpec, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, GL_COLOR_ATTACHMENT1);
+        
+        unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        glDrawBuffers(2, attachments);
+    }
+    else
+    {
+        createTarget(gPosition, GL_RGBA16F, GL_RGBA, GL_FLOAT, GL_COLOR_ATTACHMENT0);
+        createTarget(gNormal, GL_RGBA16F, GL_RGBA, GL_FLOAT, GL_COLOR_ATTACHMENT1);
+        createTarget(gAlbedoSpec, GL_RGBA16F, GL_RGBA, GL_UNSIGNED_BYTE, GL_COLOR_ATTACHMENT2);
+        
+        unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+        glDrawBuffers(3, attachments);
+    }
+    
+    // The compact layout samples depth in the lighting pass to reconstruct position
+    createTarget(gDepthTexture, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, GL_DEPTH_ATTACHMENT);
 
     GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
     if (status != GL_FRAMEBUFFER_COMPLETE) {
         std::cerr << "Error: G-buffer Framebuffer is not complete! Status: 0x" 
                   << std::hex << status << std::dec << std::endl;
    
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        state->BindFramebuffer(0);
         return;
     }
     std::cout << "G-buffer setup complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    state->BindFramebuffer(0);
     
     deferredSetupComplete = true;
 }
@@ -300,26 +1013,347 @@ void Renderer::CleanupDeferredRendering()
     if (!deferredSetupComplete)
         return;
     
-    // Clean up G-buffer resources
-    if (gBuffer) glDeleteFramebuffers(1, &gBuffer);
-    if (gPosition) glDeleteTextures(1, &gPosition);
-    if (gNormal) glDeleteTextures(1, &gNormal);
-    if (gAlbedoSpec) glDeleteTextures(1, &gAlbedoSpec);
-    if (gDepth) glDeleteRenderbuffers(1, &gDepth);
+    ReleaseGBuffer();
     
     // Clean up quad VAO/VBO
+    GLState* state = GLState::GetInstance();
+    state->OnVertexArrayDeleted(quadVAO);
+    state->OnBufferDeleted(quadVBO);
     if (quadVAO) glDeleteVertexArrays(1, &quadVAO);
     if (quadVBO) glDeleteBuffers(1, &quadVBO);
     
+    quadVAO = 0;
+    quadVBO = 0;
+    
+    deferredSetupComplete = false;
+}
+
+void Renderer::ReleaseGBuffer()
+{
+    GLState* state = GLState::GetInstance();
+    state->OnFramebufferDeleted(gBuffer);
+    if (gBuffer) glDeleteFramebuffers(1, &gBuffer);
+    
+    // The textures stay in the pool for the next G-buffer of the same size
+    renderTargets.Release(gPosition);
+    renderTargets.Release(gNormal);
+    renderTargets.Release(gAlbedoSpec);
+    renderTargets.Release(gDepthTexture);
+    
     gBuffer = 0;
     gPosition = 0;
     gNormal = 0;
     gAlbedoSpec = 0;
-    gDepth = 0;
-    quadVAO = 0;
-    quadVBO = 0;
+    gDepthTexture = 0;
+}
+
+void Renderer::SetDisplaySize(int width, int height)
+{
+    // Minimized windows report 0x0, keep the last targets until the window comes back
+    if (width <= 0 || height <= 0)
+        return;
     
-    deferredSetupComplete = false;
+    displayWidth = width;
+    displayHeight = height;
+}
+
+void Renderer::UpdateRenderResolution()
+{
+    if (displayWidth <= 0 || displayHeight <= 0)
+        return;
+    
+    float scale = dynamicResolution.GetScale();
+    int width = std::max(1, static_cast<int>(std::lround(displayWidth * scale)));
+    int height = std::max(1, static_cast<int>(std::lround(displayHeight * scale)));
+    bool needsSceneTarget = width != displayWidth || height != displayHeight;
+    if (width == renderWidth && height == renderHeight && (sceneFramebuffer != 0) == needsSceneTarget)
+        return;
+    
+    renderWidth = width;
+    renderHeight = height;
+    
+    // Both targets are rebuilt at the new size on their next use
+    if (deferredSetupComplete)
+    {
+        ReleaseGBuffer();
+        deferredSetupComplete = false;
+    }
+    
+    ReleaseSceneTarget();
+    ReleaseSelectionTarget();
+    if (needsSceneTarget)
+        SetupSceneTarget();
+}
+
+void Renderer::SetupSceneTarget()
+{
+    GLState* state = GLState::GetInstance();
+    
+    RenderTargetDesc colorDesc;
+    colorDesc.width = renderWidth;
+    colorDesc.height = renderHeight;
+    colorDesc.filter = GL_LINEAR;
+    sceneColor = renderTargets.Acquire(colorDesc);
+    
+    RenderTargetDesc depthDesc;
+    depthDesc.width = renderWidth;
+    depthDesc.height = renderHeight;
+    depthDesc.internalFormat = GL_DEPTH_COMPONENT24;
+    depthDesc.format = GL_DEPTH_COMPONENT;
+    depthDesc.type = GL_UNSIGNED_INT;
+    sceneDepth = renderTargets.Acquire(depthDesc);
+    
+    glGenFramebuffers(1, &sceneFramebuffer);
+    state->BindFramebuffer(sceneFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sceneColor, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, sceneDepth, 0);
+    
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    state->BindFramebuffer(0);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Error: Scene framebuffer is not complete! Status: 0x" << std::hex << status << std::dec
+                  << ", rendering at display resolution" << std::endl;
+        ReleaseSceneTarget();
+        dynamicResolution.SetEnabled(false);
+        renderWidth = displayWidth;
+        renderHeight = displayHeight;
+    }
+}
+
+void Renderer::ReleaseSceneTarget()
+{
+    GLState* state = GLState::GetInstance();
+    state->OnFramebufferDeleted(sceneFramebuffer);
+    if (sceneFramebuffer) glDeleteFramebuffers(1, &sceneFramebuffer);
+    
+    renderTargets.Release(sceneColor);
+    renderTargets.Release(sceneDepth);
+    
+    sceneFramebuffer = 0;
+    sceneColor = 0;
+    sceneDepth = 0;
+}
+
+void Renderer::UpscaleToDisplay()
+{
+    PROFILE_SCOPE("Upscale");
+    
+    Shader* upscaleShader = ResourceManager::GetInstance()->GetShader("postprocess/upscale");
+    if (!upscaleShader) {
+        std::cout << "Loading upscale shader..." << std::endl;
+        upscaleShader = ResourceManager::GetInstance()->LoadShaderFromFile(
+            "postprocess/upscale",
+            "resources/shaders/postprocess/upscale.vert",
+            "resources/shaders/postprocess/upscale.frag"
+        );
+    }
+    
+    GLState* state = GLState::GetInstance();
+    state->BindFramebuffer(0);
+    state->Viewport(0, 0, displayWidth, displayHeight);
+    if (!upscaleShader)
+        return;
+    
+    GpuPassScope upscaleTimer(gpuProfiler, "Upscale");
+    
+    // A full-screen quad rather than a blit, the window's framebuffer is multisampled
+    state->SetEnabled(GL_DEPTH_TEST, false);
+    state->SetEnabled(GL_BLEND, false);
+    state->PolygonMode(GL_FILL);
+    
+    upscaleShader->Use();
+    state->BindTexture(0, GL_TEXTURE_2D, sceneColor);
+    upscaleShader->SetInt(UNIFORM_SCENE_COLOR, 0);
+    upscaleShader->SetFloat(UNIFORM_SHARPNESS, UPSCALE_SHARPNESS);
+    
+    state->BindVertexArray(quadVAO);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    
+    state->SetEnabled(GL_DEPTH_TEST, depthTestEnabled);
+}
+
+void Renderer::SetupSelectionTarget()
+{
+    GLState* state = GLState::GetInstance();
+    
+    RenderTargetDesc maskDesc;
+    maskDesc.width = renderWidth;
+    maskDesc.height = renderHeight;
+    maskDesc.internalFormat = GL_R8;
+    maskDesc.format = GL_RED;
+    selectionMask = renderTargets.Acquire(maskDesc);
+    
+    glGenFramebuffers(1, &selectionFramebuffer);
+    state->BindFramebuffer(selectionFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, selectionMask, 0);
+    
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Error: Selection framebuffer is not complete! Status: 0x" << std::hex << status << std::dec << std::endl;
+        ReleaseSelectionTarget();
+    }
+}
+
+void Renderer::ReleaseSelectionTarget()
+{
+    GLState* state = GLState::GetInstance();
+    state->OnFramebufferDeleted(selectionFramebuffer);
+    if (selectionFramebuffer) glDeleteFramebuffers(1, &selectionFramebuffer);
+    
+    renderTargets.Release(selectionMask);
+    
+    selectionFramebuffer = 0;
+    selectionMask = 0;
+}
+
+void Renderer::RenderSelectionOutline(Scene* scene)
+{
+    PROFILE_SCOPE("Selection Outline");
+    
+    selectedObjects.clear();
+    for (auto& object : scene->GetObjects())
+    {
+        if (object->IsVisible() && object->IsHighlighted() && (object->GetMesh() || object->GetModel()) &&
+            IsInFrustum(object.get()))
+        {
+            selectedObjects.push_back(object.get());
+        }
+    }
+    
+    stats.selectedObjects = static_cast<int>(selectedObjects.size());
+    if (selectedObjects.empty())
+        return;
+    
+    ResourceManager* resources = ResourceManager::GetInstance();
+    Shader* maskShader = resources->GetShader("selection/selection_mask");
+    if (!maskShader)
+    {
+        maskShader = resources->LoadShaderFromFile(
+            "selection/selection_mask",
+            "resources/shaders/selection/selection_mask.vert",
+            "resources/shaders/selection/selection_mask.frag"
+        );
+    }
+    Shader* outlineShader = resources->GetShader("selection/selection_outline");
+    if (!outlineShader)
+    {
+        outlineShader = resources->LoadShaderFromFile(
+            "selection/selection_outline",
+            "resources/shaders/selection/selection_outline.vert",
+            "resources/shaders/selection/selection_outline.frag"
+        );
+    }
+    if (!maskShader || !outlineShader)
+        return;
+    
+    if (!selectionFramebuffer)
+        SetupSelectionTarget();
+    if (!selectionFramebuffer)
+        return;
+    
+    // Group by geometry so every distinct mesh is a single instanced draw into the mask
+    std::sort(selectedObjects.begin(), selectedObjects.end(), [](SceneObject* a, SceneObject* b) {
+        const void* geometryA = a->GetMesh() ? static_cast<const void*>(a->GetMesh()) : static_cast<const void*>(a->GetModel());
+        const void* geometryB = b->GetMesh() ? static_cast<const void*>(b->GetMesh()) : static_cast<const void*>(b->GetModel());
+        return std::less<const void*>()(geometryA, geometryB);
+    });
+    
+    selectionInstances.clear();
+    for (SceneObject* object : selectedObjects)
+    {
+        InstanceData instance;
+        instance.model = object->GetTransform();
+        selectionInstances.push_back(instance);
+    }
+    
+    GLState* state = GLState::GetInstance();
+    if (selectionInstanceVBO == 0)
+        selectionInstanceVBO = state->CreateBuffer();
+    
+    std::size_t requiredSize = selectionInstances.size() * sizeof(InstanceData);
+    if (requiredSize > selectionBufferCapacity)
+        selectionBufferCapacity = std::max(requiredSize, selectionBufferCapacity * 2);
+    
+    state->BufferData(GL_ARRAY_BUFFER, selectionInstanceVBO, selectionBufferCapacity, nullptr, GL_STREAM_DRAW);
+    state->BufferSubData(GL_ARRAY_BUFFER, selectionInstanceVBO, 0, requiredSize, selectionInstances.data());
+    
+    GpuPassScope outlineTimer(gpuProfiler, "Selection Outline");
+    
+    // Silhouettes go into the mask without depth testing, so occluded parts of the selection are outlined too
+    state->BindFramebuffer(selectionFramebuffer);
+    state->Viewport(0, 0, renderWidth, renderHeight);
+    state->SetEnabled(GL_DEPTH_TEST, false);
+    state->SetEnabled(GL_BLEND, false);
+    state->PolygonMode(GL_FILL);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    
+    maskShader->Use();
+    std::size_t first = 0;
+    while (first < selectedObjects.size())
+    {
+        SceneObject* object = selectedObjects[first];
+        std::size_t last = first + 1;
+        while (last < selectedObjects.size() &&
+               selectedObjects[last]->GetMesh() == object->GetMesh() &&
+               selectedObjects[last]->GetModel() == object->GetModel())
+        {
+            last++;
+        }
+        
+        std::size_t byteOffset = first * sizeof(InstanceData);
+        int instanceCount = static_cast<int>(last - first);
+        if (object->GetMesh())
+            object->GetMesh()->DrawInstanced(selectionInstanceVBO, byteOffset, instanceCount);
+        else
+            object->GetModel()->DrawInstanced(selectionInstanceVBO, byteOffset, instanceCount);
+        
+        stats.drawCalls += object->GetModel() ? static_cast<int>(object->GetModel()->GetMeshes().size()) : 1;
+        first = last;
+    }
+    
+    // One full-screen pass blends the outline over the frame
+    state->BindFramebuffer(sceneFramebuffer);
+    state->SetEnabled(GL_BLEND, true);
+    state->BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    
+    outlineShader->Use();
+    state->BindTexture(0, GL_TEXTURE_2D, selectionMask);
+    outlineShader->SetInt(UNIFORM_SELECTION_MASK, 0);
+    outlineShader->SetVec4(UNIFORM_OUTLINE_COLOR, SELECTION_OUTLINE_COLOR);
+    outlineShader->SetInt(UNIFORM_OUTLINE_WIDTH, SELECTION_OUTLINE_WIDTH);
+    outlineShader->SetFloat(UNIFORM_TIME, currentTime);
+    
+    state->BindVertexArray(quadVAO);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    stats.drawCalls++;
+    
+    state->SetEnabled(GL_BLEND, false);
+    state->SetEnabled(GL_DEPTH_TEST, depthTestEnabled);
+    if (renderMode == RenderMode::Wireframe)
+        state->PolygonMode(GL_LINE);
+}
+
+void Renderer::SetGBufferLayout(GBufferLayout layout)
+{
+    if (layout == gBufferLayout)
+        return;
+    
+    gBufferLayout = layout;
+    if (deferredSetupComplete)
+    {
+        ReleaseGBuffer();
+        deferredSetupComplete = false;
+    }
+}
+
+void Renderer::SetDepthPrepassEnabled(bool enable)
+{
+    if (depthPrepassEnabled && !enable)
+        Mesh::ReleaseDepthStreams();
+    depthPrepassEnabled = enable;
 }
 
 void Renderer::RenderWithTessellation(Scene* scene, Camera* camera)
@@ -335,10 +1369,9 @@ void Renderer::RenderWithTessellation(Scene* scene, Camera* camera)
         return;
     }
     
-    if (renderMode == RenderMode::TessellationWithWireframe)
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    else
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    GLState* state = GLState::GetInstance();
+    state->PolygonMode(renderMode == RenderMode::TessellationWithWireframe ? GL_LINE : GL_FILL);
+    state->SetEnabled(GL_BLEND, false);
     
     Shader* tessellationShader = ResourceManager::GetInstance()->GetShader("tessellation");
     if (!tessellationShader) {
@@ -352,78 +1385,121 @@ void Renderer::RenderWithTessellation(Scene* scene, Camera* camera)
         std::cerr << "OpenGL error before setting uniforms: " << std::hex << err << std::dec << std::endl;
     }
       try {
-        tessellationShader->SetFloat("tessLevelOuter", tessellationLevelOuter);
-        tessellationShader->SetFloat("tessLevelInner", tessellationLevelInner);
-        tessellationShader->SetFloat("displaceAmount", displacementAmount);
+        tessellationShader->SetFloat(UNIFORM_TESS_LEVEL_OUTER, tessellationLevelOuter);
+        tessellationShader->SetFloat(UNIFORM_TESS_LEVEL_INNER, tessellationLevelInner);
+        tessellationShader->SetFloat(UNIFORM_DISPLACE_AMOUNT, displacementAmount);
+        tessellationShader->SetBool(UNIFORM_ADAPTIVE_TESSELLATION, adaptiveTessellationEnabled);
+        tessellationShader->SetBool(UNIFORM_CULL_BACKFACING_PATCHES, patchBackfaceCullingEnabled);
+        tessellationShader->SetFloat(UNIFORM_TRIANGLE_SIZE, tessellationTriangleSize);
+        tessellationShader->SetFloat(UNIFORM_MAX_TESS_LEVEL, maxTessellationLevel);
+        tessellationShader->SetVec2(UNIFORM_VIEWPORT_SIZE, glm::vec2(renderWidth, renderHeight));
         
         // Set time uniform for animations
-        tessellationShader->SetFloat("time", currentTime);
+        tessellationShader->SetFloat(UNIFORM_TIME, currentTime);
     } catch (const std::exception& e) {
         std::cerr << "Error setting tessellation parameters: " << e.what() << std::endl;
     }
 
-    const auto& lights = scene->GetLights();
-    try {
-        if (!lights.empty()) {
-            const auto& light = lights[0]; // Use first light for simplicity
-            tessellationShader->SetVec3("lightPos", light.position);
-            tessellationShader->SetVec3("lightColor", light.color);
-            tessellationShader->SetFloat("lightIntensity", light.intensity);
-        }
-        tessellationShader->SetVec3("viewPos", camera->GetPosition());
-    } catch (const std::exception& e) {
-        std::cerr << "Error setting lighting parameters: " << e.what() << std::endl;
-    }
-    
-    while((err = glGetError()) != GL_NO_ERROR) {
-        std::cerr << "OpenGL error after setting uniforms: " << std::hex << err << std::dec << std::endl;
-    }
-    tessellationShader->SetMat4("view", camera->GetViewMatrix());
-    tessellationShader->SetMat4("projection", camera->GetProjectionMatrix());
-    
     while((err = glGetError()) != GL_NO_ERROR) {
         std::cerr << "OpenGL error before simple rendering: " << std::hex << err << std::dec << std::endl;
     }
     
+    // Fixed levels make the tessellated surface independent of the view, so it can be replayed
+    bool useCache = IsTessellationCacheActive();
+    Shader* replayShader = tessellationCache.GetReplayShader();
+    TessellationParams tessellationParams;
+    tessellationParams.outerLevel = tessellationLevelOuter;
+    tessellationParams.innerLevel = tessellationLevelInner;
+    tessellationParams.displacement = displacementAmount;
+    
+    PROFILE_SCOPE("Tessellation");
+    gpuProfiler.BeginPass("Tessellation");
+    tessellationPrimitives.Begin();
     for (auto& object : scene->GetObjects())
     {
         if (!object->IsVisible())
             continue;
         
-        glm::mat4 modelMatrix = object->GetTransform();
-        tessellationShader->SetMat4("model", modelMatrix);
-        tessellationShader->SetVec3("material.ambient", object->GetMaterial().ambient);
-        tessellationShader->SetVec3("material.diffuse", object->GetMaterial().diffuse);
-        tessellationShader->SetVec3("material.specular", object->GetMaterial().specular);
-        tessellationShader->SetFloat("material.shininess", object->GetMaterial().shininess);
-          
-        object->Draw(Mesh::RenderMode::PATCHES);
-        while((err = glGetError()) != GL_NO_ERROR) {
-            std::cerr << "OpenGL error after draw call: " << std::hex << err << std::dec << std::endl;
+        // Displacement can push the surface outside the mesh bounds
+        glm::vec3 scale = glm::abs(object->GetScale());
+        float displacementMargin = displacementAmount * std::max(scale.x, std::max(scale.y, scale.z));
+        if (!IsInFrustum(object.get(), displacementMargin))
+        {
+            stats.culledObjects++;
+            continue;
         }
-                
-    }
+        stats.visibleObjects++;
         
-    // Render highlighted objects (using normal highlighting)
-    Shader* highlightShader = ResourceManager::GetInstance()->GetShader("highlight");
-    for (auto& object : scene->GetObjects())
-    {
-        if (!object->IsVisible() || !object->IsHighlighted())
-            continue;
+        const glm::mat4& modelMatrix = object->GetTransform();
+        const Material& material = object->GetMaterial();
+        auto setObjectUniforms = [&](Shader* shader) {
+            shader->SetMat4(UNIFORM_MODEL, modelMatrix);
+            shader->SetVec3(UNIFORM_MATERIAL_AMBIENT, material.ambient);
+            shader->SetVec3(UNIFORM_MATERIAL_DIFFUSE, material.diffuse);
+            shader->SetVec3(UNIFORM_MATERIAL_SPECULAR, material.specular);
+            shader->SetFloat(UNIFORM_MATERIAL_SHININESS, material.shininess);
+        };
+        
+        if (useCache)
+        {
+            replayShader->Use();
+            setObjectUniforms(replayShader);
             
-        if (highlightShader)
+            auto drawMesh = [&](const Mesh* mesh) {
+                if (tessellationCache.Draw(mesh, tessellationParams))
+                    return;
+                
+                // Meshes over the cache budget are tessellated live
+                tessellationShader->Use();
+                setObjectUniforms(tessellationShader);
+                mesh->Draw(Mesh::RenderMode::PATCHES);
+                replayShader->Use();
+            };
+            
+            if (object->GetMesh())
+                drawMesh(object->GetMesh());
+            else if (object->GetModel())
+                for (const auto& mesh : object->GetModel()->GetMeshes())
+                    drawMesh(mesh.get());
+        }
+        else
         {
-            object->DrawHighlight(camera, currentTime);
+            tessellationShader->Use();
+            setObjectUniforms(tessellationShader);
+            object->Draw(Mesh::RenderMode::PATCHES);
         }
+        stats.drawCalls += object->GetModel() ? static_cast<int>(object->GetModel()->GetMeshes().size()) : 1;
+        stats.triangles += GetTriangleCount(object->GetMesh(), object->GetModel());
+        stats.fullDetailTriangles += GetTriangleCount(object->GetMesh(), object->GetModel());
+        while((err = glGetError()) != GL_NO_ERROR) {
+            std::cerr << "OpenGL error after draw call: " << std::hex << err << std::dec << std::endl;
+        }
+                
     }
-    
+    tessellationPrimitives.End();
+    gpuProfiler.EndPass();
+    stats.tessellatedPrimitives = tessellationPrimitives.GetLastCount();
+        
     // Check for any OpenGL errors at the end
     while((err = glGetError()) != GL_NO_ERROR) {
         std::cerr << "OpenGL error at end of tessellation rendering: " << std::hex << err << std::dec << std::endl;
     }
     
     // Restore polygon mode
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    state->PolygonMode(GL_FILL);
+}
+
+void Renderer::RenderClusteredForward(Scene* scene, Camera* camera)
+{
+    {
+        PROFILE_SCOPE("Light clustering");
+        GpuPassScope clusteringTimer(gpuProfiler, "Light Clustering");
+        clusterGrid.Build(scene->GetLights(), camera->GetViewMatrix(), camera->GetProjectionMatrix(),
+                          camera->GetNearPlane(), camera->GetFarPlane(), renderWidth, renderHeight);
+    }
+    
+    BuildRenderQueue(scene, camera);
+    SubmitRenderQueue("Clustered Forward", true);
 }
 
 void Renderer::RenderDeferred(Scene* scene, Camera* camera)
@@ -432,7 +1508,8 @@ void Renderer::RenderDeferred(Scene* scene, Camera* camera)
         return;
     
     // THIS TOOK ME HOURS, BE CAREFUL
-    glDisable(GL_BLEND);
+    GLState* state = GLState::GetInstance();
+    state->SetEnabled(GL_BLEND, false);
 
     // Ensure G-buffer is set up
     if (!deferredSetupComplete) {
@@ -444,43 +1521,32 @@ void Renderer::RenderDeferred(Scene* scene, Camera* camera)
         }
     }
     
-    glm::mat4 viewMatrix = camera->GetViewMatrix();
-    glm::mat4 projectionMatrix = camera->GetProjectionMatrix();
-    
     // --- GEOMETRY PASS ---
-    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
+    state->BindFramebuffer(gBuffer);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     
+    bool compact = gBufferLayout == GBufferLayout::Compact;
     Shader* gBufferShader = ResourceManager::GetInstance()->GetShader("deferred/gbuffer");
+    if (gBufferShader && compact)
+        gBufferShader = gBufferShader->GetVariant(COMPACT_GBUFFER_DEFINE);
     if (!gBufferShader) {
         std::cerr << "Error: G-buffer shader not found!" << std::endl;
         return;
-    }    gBufferShader->Use();
-    
-    // Render each object in the scene - only geometry
-    for (auto& object : scene->GetObjects())
-    {
-        if (!object->IsVisible())
-            continue;
-        
-        glm::mat4 modelMatrix = object->GetTransform();
-        gBufferShader->SetMat4("model", modelMatrix);
-        gBufferShader->SetMat4("view", viewMatrix);
-        gBufferShader->SetMat4("projection", projectionMatrix);
-        
-        gBufferShader->SetVec3("material.ambient", object->GetMaterial().ambient);
-        gBufferShader->SetVec3("material.diffuse", object->GetMaterial().diffuse);
-        gBufferShader->SetVec3("material.specular", object->GetMaterial().specular);
-        gBufferShader->SetFloat("material.shininess", object->GetMaterial().shininess);
-        
-        object->Draw();
     }
+    
+    // Render each object in the scene - only geometry, batched and instanced like the forward path
+    BuildRenderQueue(scene, camera, gBufferShader);
+    SubmitRenderQueue("Deferred Geometry");
 
     // --- LIGHTING PASS ---
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    state->BindFramebuffer(sceneFramebuffer);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     
     Shader* lightingShader = ResourceManager::GetInstance()->GetShader("deferred/deferred_lighting");
+    if (lightingShader && compact)
+        lightingShader = lightingShader->GetVariant(COMPACT_GBUFFER_DEFINE);
+    if (lightingShader && tiledLightingEnabled)
+        lightingShader = lightingShader->GetVariant(TILED_LIGHTING_DEFINE);
     if (!lightingShader) {
         std::cerr << "Error: Deferred lighting shader not found!" << std::endl;
         return;
@@ -488,57 +1554,44 @@ void Renderer::RenderDeferred(Scene* scene, Camera* camera)
     lightingShader->Use();
     
     // Bind G-buffer textures
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gPosition);
-    lightingShader->SetInt("gPosition", 0);
+    if (compact)
+    {
+        state->BindTexture(0, GL_TEXTURE_2D, gDepthTexture);
+        lightingShader->SetInt(UNIFORM_G_DEPTH, 0);
+        lightingShader->SetMat4(UNIFORM_INVERSE_PROJECTION, glm::inverse(camera->GetProjectionMatrix()));
+        lightingShader->SetMat4(UNIFORM_INVERSE_VIEW, glm::inverse(camera->GetViewMatrix()));
+    }
+    else
+    {
+        state->BindTexture(0, GL_TEXTURE_2D, gPosition);
+        lightingShader->SetInt(UNIFORM_G_POSITION, 0);
+    }
     
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, gNormal);
-    lightingShader->SetInt("gNormal", 1);
+    state->BindTexture(1, GL_TEXTURE_2D, gNormal);
+    lightingShader->SetInt(UNIFORM_G_NORMAL, 1);
     
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
-    lightingShader->SetInt("gAlbedoSpec", 2);
-
-    const auto& lights = scene->GetLights();
-    int numLights = static_cast<int>(lights.size());
-    lightingShader->SetInt("numLights", numLights);
+    state->BindTexture(2, GL_TEXTURE_2D, gAlbedoSpec);
+    lightingShader->SetInt(UNIFORM_G_ALBEDO_SPEC, 2);
+    lightingShader->SetFloat(UNIFORM_TIME, currentTime);
     
-    // Pass each light to the shader
-    for (int i = 0; i < numLights; i++) {
-        const auto& light = lights[i];
-        std::string prefix = "lights[" + std::to_string(i) + "].";
-        
-        lightingShader->SetVec3(prefix + "position", light.position);
-        lightingShader->SetVec3(prefix + "color", light.color);
-        lightingShader->SetFloat(prefix + "intensity", light.intensity);
-    }    
-    lightingShader->SetVec3("viewPos", camera->GetPosition());
-    lightingShader->SetFloat("time", currentTime);
+    if (tiledLightingEnabled)
+    {
+        PROFILE_SCOPE("Light binning");
+        lightGrid.Build(scene->GetLights(), camera->GetViewMatrix(), camera->GetProjectionMatrix(), gBufferWidth, gBufferHeight);
+        lightGrid.Upload();
+        lightGrid.Bind(lightingShader, LIGHT_GRID_TEXTURE_UNIT);
+    }
     
     // Draw full-screen quad
-    glBindVertexArray(quadVAO);
+    gpuProfiler.BeginPass("Deferred Lighting");
+    state->BindVertexArray(quadVAO);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    
-    // --- RENDER HIGHLIGHTED OBJECTS ---
-    for (auto& object : scene->GetObjects())
-    {
-        if (!object->IsVisible() || !object->IsHighlighted())
-            continue;
-            
-        Shader* highlightShader = ResourceManager::GetInstance()->GetShader("highlight");
-        if (highlightShader)
-        {
-            highlightShader->Use();
-            
-            glm::mat4 modelMatrix = object->GetTransform();
-            highlightShader->SetMat4("model", modelMatrix);
-            highlightShader->SetMat4("view", viewMatrix);
-            highlightShader->SetMat4("projection", projectionMatrix);
-            
-            object->DrawHighlight(camera, currentTime);
-        }
-    }
+    gpuProfiler.EndPass();
+}
+
+bool Renderer::IsTessellationCacheActive() const
+{
+    return tessellationCacheEnabled && !adaptiveTessellationEnabled && tessellationCache.IsSupported();
 }
 
 bool Renderer::IsTessellationSupported()
@@ -1,4 +1,5 @@
 #include "ResourceManager.h"
+#include "Profiler.h"
 #include <iostream>
 #include <filesystem>
 #include <fstream>
@@ -160,6 +161,8 @@ void ResourceManager::ReleaseAllModels()
 
 bool ResourceManager::LoadAllShadersFromDirectory(const std::string& directory)
 {
+    PROFILE_SCOPE("ResourceManager::LoadAllShadersFromDirectory");
+    
     namespace fs = std::filesystem;
     
     if (!fs::exists(directory) || !fs::is_directory(directory))
@@ -3,7 +3,9 @@
 #include "Primitives.h"
 #include "ResourceManager.h"
 #include "Shader.h"
+#include "Profiler.h"
 #include <iostream>
+#include <algorithm>
 #include <nlohmann/json.hpp>
 #include <fstream>
 #include <filesystem>
@@ -30,6 +32,10 @@ SceneObject* Scene::AddObject(std::unique_ptr<SceneObject> object)
     if (!object)
         return nullptr;
         
+    object->scene = this;
+    object->spatialIndexDirty = true;
+    movedObjects.push_back(object.get());
+    
     objects.push_back(std::move(object));
     return objects.back().get();
 }
@@ -45,14 +51,135 @@ void Scene::RemoveObject(SceneObject* object)
                          });
                          
     if (it != objects.end())
+    {
+        RemoveFromSpatialIndex(object);
         objects.erase(it);
+    }
 }
 
 void Scene::ClearObjects()
 {
+    spatialIndex.Clear();
+    movedObjects.clear();
     objects.clear();
 }
 
+void Scene::RemoveFromSpatialIndex(SceneObject* object)
+{
+    if (object->spatialProxy != DynamicBVH::NullNode)
+        spatialIndex.DestroyProxy(object->spatialProxy);
+    object->spatialProxy = DynamicBVH::NullNode;
+    object->scene = nullptr;
+    
+    if (object->spatialIndexDirty)
+    {
+        movedObjects.erase(std::remove(movedObjects.begin(), movedObjects.end(), object), movedObjects.end());
+        object->spatialIndexDirty = false;
+    }
+}
+
+void Scene::OnObjectBoundsChanged(SceneObject* object)
+{
+    movedObjects.push_back(object);
+}
+
+void Scene::UpdateSpatialIndex()
+{
+    for (SceneObject* object : movedObjects)
+    {
+        object->spatialIndexDirty = false;
+        const BoundingBox& bounds = object->GetWorldBounds();
+        
+        if (!bounds.IsValid())
+        {
+            if (object->spatialProxy != DynamicBVH::NullNode)
+                spatialIndex.DestroyProxy(object->spatialProxy);
+            object->spatialProxy = DynamicBVH::NullNode;
+        }
+        else if (object->spatialProxy == DynamicBVH::NullNode)
+        {
+            object->spatialProxy = spatialIndex.CreateProxy(bounds, object);
+        }
+        else
+        {
+            spatialIndex.MoveProxy(object->spatialProxy, bounds);
+        }
+    }
+    
+    movedObjects.clear();
+}
+
+void Scene::QueryFrustum(const Frustum& frustum, std::vector<SceneObject*>& results)
+{
+    UpdateSpatialIndex();
+    
+    queryResults.clear();
+    spatialIndex.QueryFrustum(frustum, queryResults);
+    for (void* userData : queryResults)
+    {
+        SceneObject* object = static_cast<SceneObject*>(userData);
+        if (frustum.Intersects(object->GetWorldBounds()))
+            results.push_back(object);
+    }
+}
+
+void Scene::QueryBox(const BoundingBox& box, std::vector<SceneObject*>& results)
+{
+    UpdateSpatialIndex();
+    
+    queryResults.clear();
+    spatialIndex.QueryBox(box, queryResults);
+    for (void* userData : queryResults)
+    {
+        SceneObject* object = static_cast<SceneObject*>(userData);
+        if (box.Intersects(object->GetWorldBounds()))
+            results.push_back(object);
+    }
+}
+
+void Scene::QuerySphere(const BoundingSphere& sphere, std::vector<SceneObject*>& results)
+{
+    UpdateSpatialIndex();
+    
+    queryResults.clear();
+    spatialIndex.QuerySphere(sphere, queryResults);
+    for (void* userData : queryResults)
+    {
+        SceneObject* object = static_cast<SceneObject*>(userData);
+        if (sphere.Intersects(object->GetWorldBounds()))
+            results.push_back(object);
+    }
+}
+
+SceneObject* Scene::Raycast(const Ray& ray, float maxDistance, float* hitDistance)
+{
+    UpdateSpatialIndex();
+    
+    rayHits.clear();
+    spatialIndex.QueryRay(ray, maxDistance, rayHits);
+    
+    // Hits come sorted by fat box distance; the tight box can only be further away
+    SceneObject* closest = nullptr;
+    float closestDistance = maxDistance;
+    for (const auto& hit : rayHits)
+    {
+        if (hit.distance > closestDistance)
+            break;
+        
+        SceneObject* object = static_cast<SceneObject*>(hit.userData);
+        float distance = 0.0f;
+        if (object->GetWorldBounds().IntersectsRay(ray, closestDistance, distance) && distance <= closestDistance)
+        {
+            closest = object;
+            closestDistance = distance;
+        }
+    }
+    
+    if (closest && hitDistance)
+        *hitDistance = closestDistance;
+    return closest;
+}
+
 void Scene::ClearLights()
 {
     lights.clear();
@@ -103,6 +230,8 @@ bool Scene::SaveToFile(const std::string& filepath)
             lightJson["position"] = {light.position.x, light.position.y, light.position.z};
             lightJson["color"] = {light.color.r, light.color.g, light.color.b};
             lightJson["intensity"] = light.intensity;
+            if (light.range > 0.0f)
+                lightJson["range"] = light.range;
             
             lightsJson.push_back(lightJson);
         }
@@ -129,6 +258,7 @@ bool Scene::SaveToFile(const std::string& filepath)
             objectJson["material"]["ambient"] = {material.ambient.r, material.ambient.g, material.ambient.b};            objectJson["material"]["diffuse"] = {material.diffuse.r, material.diffuse.g, material.diffuse.b};
             objectJson["material"]["specular"] = {material.specular.r, material.specular.g, material.specular.b};
             objectJson["material"]["shininess"] = material.shininess;
+            objectJson["material"]["opacity"] = material.opacity;
             
             // Save shader information
             if (object->GetShader()) {
@@ -190,6 +320,8 @@ bool Scene::SaveToFile(const std::string& filepath)
 
 bool Scene::LoadFromFile(const std::string& filepath)
 {
+    PROFILE_SCOPE("Scene::LoadFromFile");
+    
     try
     {
         std::ifstream file(filepath);
@@ -203,7 +335,7 @@ bool Scene::LoadFromFile(const std::string& filepath)
         file >> sceneJson;
         
         // Clear existing scene data
-        objects.clear();
+        ClearObjects();
         lights.clear();
         
         // Load lights
@@ -232,6 +364,11 @@ bool Scene::LoadFromFile(const std::string& filepath)
                     light.intensity = lightJson["intensity"];
                 }
                 
+                if (lightJson.contains("range") && lightJson["range"].is_number())
+                {
+                    light.range = std::max(0.0f, lightJson["range"].get<float>());
+                }
+                
                 lights.push_back(light);
             }
         }
@@ -407,6 +544,11 @@ bool Scene::LoadFromFile(const std::string& filepath)
                     {
                         material.shininess = objectJson["material"]["shininess"];
                     }
+                    
+                    if (objectJson["material"].contains("opacity") && objectJson["material"]["opacity"].is_number())
+                    {
+                        material.opacity = std::clamp(objectJson["material"]["opacity"].get<float>(), 0.0f, 1.0f);
+                    }
                       object->SetMaterial(material);
                 }
                 
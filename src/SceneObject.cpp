@@ -1,10 +1,10 @@
 #include "SceneObject.h"
 #include "Mesh.h"
 #include "Shader.h"
-#include "Camera.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/euler_angles.hpp>
-#include "ResourceManager.h"
+#include "Scene.h"
+#include <algorithm>
 
 SceneObject::SceneObject(const std::string& name)
     : name(name)
@@ -19,70 +19,40 @@ void SceneObject::Update(float deltaTime)
     (void)deltaTime;
 }
 
-void SceneObject::Draw(Mesh::RenderMode mode)
+void SceneObject::Draw(Mesh::RenderMode mode, int lod)
 {
     if (!visible || !shader)
         return;
 
     if (mesh)
     {
-        mesh->Draw(mode);
+        mesh->Draw(mode, lod);
     }
     else if (model)
     {
-        model->Draw(mode);
+        model->Draw(mode, lod);
     }
 }
 
-void SceneObject::DrawHighlight(Camera* camera, float currentTime)
-{
-    if (!visible || !highlighted)
-        return;
-    
-    Shader* highlightShader = ResourceManager::GetInstance()->GetShader("highlight");
-    if (!highlightShader)
-        return;
-    
-    // Enable blending for transparent highlight effect
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    
-    // Use the highlight shader
-    highlightShader->Use();
-    highlightShader->SetVec4("highlightColor", glm::vec4(1.0f, 0.6f, 0.0f, 0.3f));
-    highlightShader->SetMat4("model", transform);
-    highlightShader->SetMat4("view", camera->GetViewMatrix());
-    highlightShader->SetMat4("projection", camera->GetProjectionMatrix());
-    highlightShader->SetFloat("time", currentTime);
-    
-    if (mesh)
-    {
-        mesh->Draw();
-    }
-    else if (model)
-    {
-        model->Draw();
-    }
-
-    glDisable(GL_BLEND);
-}
-
 void SceneObject::SetPosition(const glm::vec3& newPosition)
 {
     position = newPosition;
     transformDirty = true;
+    MarkBoundsDirty();
 }
 
 void SceneObject::SetRotation(const glm::vec3& newRotation)
 {
     rotation = newRotation;
     transformDirty = true;
+    MarkBoundsDirty();
 }
 
 void SceneObject::SetScale(const glm::vec3& newScale)
 {
     scale = newScale;
     transformDirty = true;
+    MarkBoundsDirty();
 }
 
 glm::mat4 SceneObject::GetTransform()
@@ -104,3 +74,61 @@ glm::mat4 SceneObject::GetTransform()
     
     return transform;
 }
+
+const BoundingBox& SceneObject::GetWorldBounds()
+{
+    if (boundsDirty)
+        UpdateWorldBounds();
+    return worldBounds;
+}
+
+const BoundingSphere& SceneObject::GetWorldBoundingSphere()
+{
+    if (boundsDirty)
+        UpdateWorldBounds();
+    return worldBoundingSphere;
+}
+
+void SceneObject::UpdateWorldBounds()
+{
+    boundsDirty = false;
+    worldBounds = BoundingBox();
+    worldBoundingSphere = BoundingSphere();
+    
+    const BoundingBox* localBounds = nullptr;
+    const BoundingSphere* localSphere = nullptr;
+    if (mesh)
+    {
+        localBounds = &mesh->GetBounds();
+        localSphere = &mesh->GetBoundingSphere();
+    }
+    else if (model)
+    {
+        localBounds = &model->GetBounds();
+        localSphere = &model->GetBoundingSphere();
+    }
+    
+    if (!localBounds || !localBounds->IsValid())
+        return;
+    
+    glm::mat4 worldTransform = GetTransform();
+    worldBounds = localBounds->Transformed(worldTransform);
+    
+    // Non-uniform scale stretches the sphere by the largest axis scale
+    float maxScale = std::max(glm::length(glm::vec3(worldTransform[0])),
+                     std::max(glm::length(glm::vec3(worldTransform[1])), glm::length(glm::vec3(worldTransform[2]))));
+    worldBoundingSphere.center = glm::vec3(worldTransform * glm::vec4(localSphere->center, 1.0f));
+    worldBoundingSphere.radius = localSphere->radius * maxScale;
+}
+
+void SceneObject::MarkBoundsDirty()
+{
+    boundsDirty = true;
+    
+    // Queue a single refit of the scene's spatial index, however many setters are called
+    if (scene && !spatialIndexDirty)
+    {
+        spatialIndexDirty = true;
+        scene->OnObjectBoundsChanged(this);
+    }
+}
@@ -1,7 +1,11 @@
 #include "Shader.h"
+#include "UniformBuffers.h"
+#include "GLState.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+#include <filesystem>
 #include <glm/gtc/type_ptr.hpp>
 
 Shader::Shader() = default;
@@ -42,6 +46,13 @@ bool Shader::LoadFromFile(const std::string& vertexPath, const std::string& frag
         return false;
     }
     
+    compilationLog.clear();
+    if (!ResolveIncludes(vertexCode, vertexPath, compilationLog) || !ResolveIncludes(fragmentCode, fragmentPath, compilationLog))
+    {
+        std::cerr << compilationLog << std::endl;
+        return false;
+    }
+    
     return LoadFromSource(vertexCode, fragmentCode);
 }
 
@@ -50,23 +61,162 @@ bool Shader::LoadFromSource(const std::string& vertexSource, const std::string&
     // Delete the previous shader if one exists
     if (id != 0)
         Delete();
+    
+    vertexSourceCode = vertexSource;
+    fragmentSourceCode = fragmentSource;
+    invariantPosition = vertexSource.find("invariant gl_Position") != std::string::npos;
+    variants.clear();
         
     return CompileShader(vertexSource, fragmentSource);
 }
 
+namespace {
+    // Inserts "#define <define>" right after the #version directive, keeping line numbers intact
+    std::string InjectDefine(const std::string& source, const std::string& define)
+    {
+        std::size_t versionPos = source.find("#version");
+        std::size_t insertPos = 0;
+        if (versionPos != std::string::npos)
+        {
+            std::size_t lineEnd = source.find('\n', versionPos);
+            insertPos = (lineEnd == std::string::npos) ? source.size() : lineEnd + 1;
+        }
+        
+        return source.substr(0, insertPos) + "#define " + define + "\n#line 2\n" + source.substr(insertPos);
+    }
+}
+
+bool Shader::ResolveIncludes(std::string& source, const std::string& path, std::string& log, int depth)
+{
+    // Deep nesting almost certainly means a file includes itself
+    if (depth > 8)
+    {
+        log += "ERROR::SHADER::INCLUDE_TOO_DEEP: " + path + "\n";
+        return false;
+    }
+    
+    std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    std::string resolved;
+    resolved.reserve(source.size());
+    
+    std::istringstream lines(source);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(lines, line))
+    {
+        lineNumber++;
+        std::size_t directive = line.find_first_not_of(" \t");
+        if (directive == std::string::npos || line.compare(directive, 8, "#include") != 0)
+        {
+            resolved += line;
+            resolved += '\n';
+            continue;
+        }
+        
+        std::size_t open = line.find('"', directive);
+        std::size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+        if (close == std::string::npos)
+        {
+            log += "ERROR::SHADER::MALFORMED_INCLUDE: " + path + ":" + std::to_string(lineNumber) + "\n";
+            return false;
+        }
+        
+        std::string includePath = (directory / line.substr(open + 1, close - open - 1)).lexically_normal().string();
+        std::ifstream includeFile(includePath);
+        if (!includeFile)
+        {
+            log += "ERROR::SHADER::INCLUDE_NOT_FOUND: " + includePath + " (from " + path + ")\n";
+            return false;
+        }
+        
+        std::stringstream includeStream;
+        includeStream << includeFile.rdbuf();
+        std::string included = includeStream.str();
+        if (!ResolveIncludes(included, includePath, log, depth + 1))
+            return false;
+        
+        // Keep the including file's line numbers in compiler errors
+        resolved += included;
+        resolved += "#line " + std::to_string(lineNumber + 1) + "\n";
+    }
+    
+    source = std::move(resolved);
+    return true;
+}
+
+bool Shader::LoadComputeFromFile(const std::string& computePath)
+{
+    std::ifstream computeFile(computePath);
+    if (!computeFile)
+    {
+        compilationLog = "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " + computePath;
+        std::cerr << compilationLog << std::endl;
+        return false;
+    }
+    
+    std::stringstream computeStream;
+    computeStream << computeFile.rdbuf();
+    std::string computeCode = computeStream.str();
+    
+    compilationLog.clear();
+    if (!ResolveIncludes(computeCode, computePath, compilationLog))
+    {
+        std::cerr << compilationLog << std::endl;
+        return false;
+    }
+    
+    if (id != 0)
+        Delete();
+    
+    // Define variants are only supported for vertex/fragment programs
+    vertexSourceCode.clear();
+    fragmentSourceCode.clear();
+    variants.clear();
+    
+    return CompileComputeShader(computeCode);
+}
+
+Shader* Shader::GetVariant(const std::string& define)
+{
+    auto it = variants.find(define);
+    if (it != variants.end())
+        return it->second.get();
+    
+    // Null entries remember that the variant is unsupported or failed to compile
+    std::unique_ptr<Shader> variant;
+    if (vertexSourceCode.find(define) != std::string::npos || fragmentSourceCode.find(define) != std::string::npos)
+    {
+        variant = std::make_unique<Shader>();
+        variant->SetName(name + "#" + define);
+        // Loading keeps the injected sources, so variants can have variants of their own
+        if (!variant->LoadFromSource(InjectDefine(vertexSourceCode, define), InjectDefine(fragmentSourceCode, define)))
+        {
+            std::cerr << "Failed to compile variant '" << define << "' of shader " << name << ": " << variant->GetCompilationLog() << std::endl;
+            variant.reset();
+        }
+    }
+    
+    Shader* rawPtr = variant.get();
+    variants[define] = std::move(variant);
+    return rawPtr;
+}
+
 void Shader::Use() const
 {
-    glUseProgram(id);
+    GLState::GetInstance()->UseProgram(id);
 }
 
 void Shader::Delete()
 {
+    variants.clear();
     if (id != 0)
     {
+        GLState::GetInstance()->OnProgramDeleted(id);
         glDeleteProgram(id);
         id = 0;
     }
-    uniformLocationCache.clear();
+    uniforms.clear();
+    reportedMissingUniforms.clear();
 }
 
 bool Shader::CompileShader(const std::string& vertexSource, const std::string& fragmentSource)
@@ -86,6 +236,7 @@ bool Shader::CompileShader(const std::string& vertexSource, const std::string& f
     id = glCreateProgram();
     glAttachShader(id, vertexShader);
     glAttachShader(id, fragmentShader);
+    ApplyTransformFeedbackVaryings();
     glLinkProgram(id);
     
     // Check for linking errors
@@ -108,6 +259,38 @@ bool Shader::CompileShader(const std::string& vertexSource, const std::string& f
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
     
+    BindUniformBlocks();
+    ReflectUniforms();
+    return true;
+}
+
+bool Shader::CompileComputeShader(const std::string& computeSource)
+{
+    compilationLog.clear();
+    unsigned int computeShader = CompileShaderModule(GL_COMPUTE_SHADER, computeSource);
+    if (computeShader == 0)
+        return false;
+    
+    id = glCreateProgram();
+    glAttachShader(id, computeShader);
+    glLinkProgram(id);
+    
+    int success;
+    char infoLog[512];
+    glGetProgramiv(id, GL_LINK_STATUS, &success);
+    glDeleteShader(computeShader);
+    if (!success)
+    {
+        glGetProgramInfoLog(id, 512, NULL, infoLog);
+        compilationLog += "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" + std::string(infoLog);
+        std::cerr << compilationLog << std::endl;
+        glDeleteProgram(id);
+        id = 0;
+        return false;
+    }
+    
+    BindUniformBlocks();
+    ReflectUniforms();
     return true;
 }
 
@@ -126,7 +309,7 @@ unsigned int Shader::CompileShaderModule(unsigned int type, const std::string& s
     {
         glGetShaderInfoLog(shader, 512, NULL, infoLog);
         compilationLog += "ERROR::SHADER::" + 
-            std::string(type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT") + 
+            std::string(type == GL_VERTEX_SHADER ? "VERTEX" : type == GL_COMPUTE_SHADER ? "COMPUTE" : "FRAGMENT") + 
             "::COMPILATION_FAILED\n" + std::string(infoLog);
         std::cerr << compilationLog << std::endl;
         glDeleteShader(shader);
@@ -176,6 +359,14 @@ bool Shader::LoadWithTessellationFromFile(const std::string& vertexPath, const s
         return false;
     }
     
+    compilationLog.clear();
+    if (!ResolveIncludes(vertexCode, vertexPath, compilationLog) || !ResolveIncludes(fragmentCode, fragmentPath, compilationLog) ||
+        !ResolveIncludes(tessControlCode, tessControlPath, compilationLog) || !ResolveIncludes(tessEvalCode, tessEvalPath, compilationLog))
+    {
+        std::cerr << compilationLog << std::endl;
+        return false;
+    }
+    
     return LoadWithTessellationFromSource(vertexCode, fragmentCode, tessControlCode, tessEvalCode);
 }
 
@@ -184,6 +375,11 @@ bool Shader::LoadWithTessellationFromSource(const std::string& vertexSource, con
 {
     if (id != 0)
         Delete();
+    
+    // Define variants are only supported for vertex/fragment programs
+    vertexSourceCode.clear();
+    fragmentSourceCode.clear();
+    variants.clear();
         
     return CompileShaderWithTessellation(vertexSource, fragmentSource, tessControlSource, tessEvalSource);
 }
@@ -224,6 +420,7 @@ bool Shader::CompileShaderWithTessellation(const std::string& vertexSource, cons
     glAttachShader(id, tessControlShader);
     glAttachShader(id, tessEvalShader);
     glAttachShader(id, fragmentShader);
+    ApplyTransformFeedbackVaryings();
     glLinkProgram(id);
     
     // Check for linking errors
@@ -251,23 +448,132 @@ bool Shader::CompileShaderWithTessellation(const std::string& vertexSource, cons
     glDeleteShader(tessEvalShader);
     glDeleteShader(fragmentShader);
     
+    BindUniformBlocks();
+    ReflectUniforms();
     return true;
 }
 
-int Shader::GetUniformLocation(const std::string& uniformName) const
+void Shader::ApplyTransformFeedbackVaryings()
 {
-    // Check if the uniform location is already in the cache
-    if (uniformLocationCache.find(uniformName) != uniformLocationCache.end())
-        return uniformLocationCache[uniformName];
+    if (feedbackVaryings.empty())
+        return;
+    
+    std::vector<const char*> names;
+    names.reserve(feedbackVaryings.size());
+    for (const std::string& varying : feedbackVaryings)
+        names.push_back(varying.c_str());
+    
+    glTransformFeedbackVaryings(id, static_cast<GLsizei>(names.size()), names.data(), GL_INTERLEAVED_ATTRIBS);
+}
+
+void Shader::BindUniformBlocks()
+{
+    struct BlockBinding {
+        const char* name;
+        unsigned int binding;
+        std::size_t size;
+    };
+    const BlockBinding blocks[] = {
+        { "FrameData", FRAME_DATA_BINDING, sizeof(FrameData) },
+        { "LightData", LIGHT_DATA_BINDING, sizeof(LightData) }
+    };
+    
+    for (const auto& block : blocks)
+    {
+        unsigned int blockIndex = glGetUniformBlockIndex(id, block.name);
+        if (blockIndex == GL_INVALID_INDEX)
+            continue;
         
-    int location = glGetUniformLocation(id, uniformName.c_str());
-    if (location == -1) {
-        if (uniformName != "lightPos" && uniformName != "lightColor" && uniformName != "lightIntensity") {
-            std::cerr << "Warning: Uniform '" << uniformName << "' not found in shader " << this->name << std::endl;
+        // A size mismatch means the shader's block declaration is out of sync with UniformBuffers.h
+        int blockSize = 0;
+        glGetActiveUniformBlockiv(id, blockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &blockSize);
+        if (static_cast<std::size_t>(blockSize) != block.size) {
+            std::cerr << "Warning: Uniform block '" << block.name << "' in shader " << name << " is " << blockSize
+                      << " bytes, expected " << block.size << std::endl;
+        }
+        
+        glUniformBlockBinding(id, blockIndex, block.binding);
+    }
+}
+
+void Shader::ReflectUniforms()
+{
+    uniforms.clear();
+    reportedMissingUniforms.clear();
+    
+    int uniformCount = 0;
+    int maxNameLength = 0;
+    glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+    
+    std::string uniformName(static_cast<std::size_t>(std::max(maxNameLength, 1)), '\0');
+    for (int i = 0; i < uniformCount; i++)
+    {
+        int length = 0;
+        int size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(id, static_cast<GLuint>(i), maxNameLength, &length, &size, &type, &uniformName[0]);
+        
+        // Uniforms inside blocks have no location and are set through the uniform buffers
+        std::string activeName(uniformName.data(), static_cast<std::size_t>(length));
+        int location = glGetUniformLocation(id, activeName.c_str());
+        if (location == -1)
+            continue;
+        
+        // Arrays of basic types are reported once as "name[0]"; register the plain name and every
+        // element. Struct members, including those of struct arrays, are reported individually.
+        const std::string arraySuffix = "[0]";
+        bool isArray = activeName.size() > arraySuffix.size() &&
+                       activeName.compare(activeName.size() - arraySuffix.size(), arraySuffix.size(), arraySuffix) == 0;
+        if (!isArray)
+        {
+            uniforms.push_back({ HashUniformName(activeName), location });
+            continue;
+        }
+        
+        std::string baseName = activeName.substr(0, activeName.size() - arraySuffix.size());
+        uniforms.push_back({ HashUniformName(baseName), location });
+        for (int element = 0; element < size; element++)
+        {
+            std::string elementName = baseName + "[" + std::to_string(element) + "]";
+            int elementLocation = glGetUniformLocation(id, elementName.c_str());
+            if (elementLocation != -1)
+                uniforms.push_back({ HashUniformName(elementName), elementLocation });
         }
     }
     
-    uniformLocationCache[uniformName] = location;
+    std::sort(uniforms.begin(), uniforms.end(), [](const UniformSlot& a, const UniformSlot& b) {
+        return a.hash < b.hash;
+    });
+    
+    auto duplicate = std::adjacent_find(uniforms.begin(), uniforms.end(), [](const UniformSlot& a, const UniformSlot& b) {
+        return a.hash == b.hash;
+    });
+    if (duplicate != uniforms.end())
+        std::cerr << "Warning: Uniform name hash collision in shader " << name << std::endl;
+}
+
+int Shader::GetUniformLocation(UniformId uniform) const
+{
+    auto it = std::lower_bound(uniforms.begin(), uniforms.end(), uniform.hash, [](const UniformSlot& slot, uint32_t hash) {
+        return slot.hash < hash;
+    });
+    return (it != uniforms.end() && it->hash == uniform.hash) ? it->location : -1;
+}
+
+int Shader::GetUniformLocation(const std::string& uniformName) const
+{
+    int location = GetUniformLocation(UniformId(uniformName));
+    if (location == -1 && uniformName != "lightPos" && uniformName != "lightColor" && uniformName != "lightIntensity")
+    {
+        // Warn once per name, the reflected table already knows every active uniform
+        uint32_t hash = HashUniformName(uniformName);
+        if (std::find(reportedMissingUniforms.begin(), reportedMissingUniforms.end(), hash) == reportedMissingUniforms.end())
+        {
+            std::cerr << "Warning: Uniform '" << uniformName << "' not found in shader " << this->name << std::endl;
+            reportedMissingUniforms.push_back(hash);
+        }
+    }
     return location;
 }
 
@@ -332,4 +638,67 @@ void Shader::SetMat4(const std::string& uniformName, const glm::mat4& value) con
     int location = GetUniformLocation(uniformName);
     if (location != -1)
         glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
-}
\ No newline at end of file
+}
+
+void Shader::SetBool(UniformId uniform, bool value) const
+{
+    int location = GetUniformLocation(uniform);
+    if (location != -1)
+        glUniform1i(location, static_cast<int>(value));
+}
+
+void Shader::SetInt(UniformId uniform, int value) const
+{
+    int location = GetUniformLocation(uniform);
+    if (location != -1)
+        glUniform1i(location, value);
+}
+
+void Shader::SetFloat(UniformId uniform, float value) const
+{
+    int location = GetUniformLocation(uniform);
+    if (location != -1)
+        glUniform1f(location, value);
+}
+
+void Shader::SetVec2(UniformId uniform, const glm::vec2& value) const
+{
+    int location = GetUniformLocation(uniform);
+    if (location != -1)
+        glUniform2fv(location, 1, glm::value_ptr(value));
+}
+
+void Shader::SetVec3(UniformId uniform, const glm::vec3& value) const
+{
+    int location = GetUniformLocation(uniform);
+    if (location != -1)
+        glUniform3fv(location, 1, glm::value_ptr(value));
+}
+
+void Shader::SetVec4(UniformId uniform, const glm::vec4& value) const
+{
+    int location = GetUniformLocation(uniform);
+    if (location != -1)
+        glUniform4fv(location, 1, glm::value_ptr(value));
+}
+
+void Shader::SetMat2(UniformId uniform, const glm::mat2& value) const
+{
+    int location = GetUniformLocation(uniform);
+    if (location != -1)
+        glUniformMatrix2fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void Shader::SetMat3(UniformId uniform, const glm::mat3& value) const
+{
+    int location = GetUniformLocation(uniform);
+    if (location != -1)
+        glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void Shader::SetMat4(UniformId uniform, const glm::mat4& value) const
+{
+    int location = GetUniformLocation(uniform);
+    if (location != -1)
+        glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
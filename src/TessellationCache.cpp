@@ -0,0 +1,229 @@
+#include "TessellationCache.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "GLState.h"
+#include "Profiler.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+    constexpr UniformId UNIFORM_MODEL("model");
+    constexpr UniformId UNIFORM_TESS_LEVEL_OUTER("tessLevelOuter");
+    constexpr UniformId UNIFORM_TESS_LEVEL_INNER("tessLevelInner");
+    constexpr UniformId UNIFORM_DISPLACE_AMOUNT("displaceAmount");
+    constexpr UniformId UNIFORM_ADAPTIVE_TESSELLATION("adaptiveTessellation");
+
+    // Captured vertices share the mesh vertex layout: position, normal, texture coordinates
+    static_assert(sizeof(Vertex) == 8 * sizeof(float), "captured vertices are replayed with the Vertex layout");
+
+    // Segments of an edge with the given level under fractional_odd_spacing: clamped to
+    // [1, maxLevel - 1] and rounded up to the next odd integer
+    int OddSegments(float level, float maxLevel)
+    {
+        int segments = static_cast<int>(std::ceil(std::clamp(level, 1.0f, std::max(maxLevel - 1.0f, 1.0f))));
+        return (segments % 2 == 1) ? segments : segments + 1;
+    }
+
+    // Triangles the tessellator emits for one triangle patch with uniform outer levels. The inner
+    // triangle is cut into concentric rings whose edges shrink by two segments per ring; the strip
+    // between two rings has one triangle per segment on either side.
+    std::size_t TrianglesPerPatch(float outerLevel, float innerLevel, float maxLevel)
+    {
+        int outer = OddSegments(outerLevel, maxLevel);
+        int inner = OddSegments(innerLevel, maxLevel);
+        if (outer == 1 && inner == 1)
+            return 1;
+
+        // An inner level of one with subdivided outer edges is treated as the next level up
+        inner = std::max(inner, 3);
+
+        std::size_t triangles = 3 * static_cast<std::size_t>(outer + inner - 2);
+        for (int ring = inner - 2; ring >= 3; ring -= 2)
+            triangles += 3 * static_cast<std::size_t>(2 * ring - 2);
+        return triangles + 1;
+    }
+}
+
+TessellationCache::~TessellationCache()
+{
+    Shutdown();
+}
+
+bool TessellationCache::Initialize(float maxTessLevel)
+{
+    maxLevel = maxTessLevel;
+
+    // Replaying without reading the vertex count back needs glDrawTransformFeedback (GL 4.0)
+    if (!glad_glDrawTransformFeedback || !glad_glGenTransformFeedbacks)
+    {
+        std::cerr << "Tessellation cache disabled: transform feedback objects are not supported" << std::endl;
+        return false;
+    }
+
+    captureShader = std::make_unique<Shader>();
+    captureShader->SetName("tessellation#capture");
+    captureShader->SetTransformFeedbackVaryings({ "tfPosition", "tfNormal", "tfTexCoord" });
+    replayShader = std::make_unique<Shader>();
+    replayShader->SetName("tessellation/tessellation_cached");
+
+    bool loaded = captureShader->LoadWithTessellationFromFile(
+        "resources/shaders/tessellation/tessellation.vert",
+        "resources/shaders/tessellation/tessellation.frag",
+        "resources/shaders/tessellation/tessellation.tesc",
+        "resources/shaders/tessellation/tessellation.tese");
+    loaded = loaded && replayShader->LoadFromFile(
+        "resources/shaders/tessellation/tessellation_cached.vert",
+        "resources/shaders/tessellation/tessellation_cached.frag");
+
+    if (!loaded)
+    {
+        std::cerr << "Tessellation cache disabled: failed to load its shaders" << std::endl;
+        captureShader.reset();
+        replayShader.reset();
+        return false;
+    }
+
+    return true;
+}
+
+void TessellationCache::Shutdown()
+{
+    Clear();
+    captureShader.reset();
+    replayShader.reset();
+}
+
+void TessellationCache::BeginFrame()
+{
+    frameNumber++;
+    stats.captures = 0;
+    stats.replays = 0;
+
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+        if (frameNumber - it->second.lastUsedFrame > MAX_UNUSED_FRAMES)
+        {
+            DeleteEntry(it->second);
+            it = entries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    stats.meshes = static_cast<int>(entries.size());
+}
+
+void TessellationCache::Clear()
+{
+    for (auto& [mesh, entry] : entries)
+        DeleteEntry(entry);
+    entries.clear();
+    stats = Stats();
+}
+
+void TessellationCache::DeleteEntry(Entry& entry)
+{
+    GLState* state = GLState::GetInstance();
+    state->OnVertexArrayDeleted(entry.vao);
+    state->OnBufferDeleted(entry.buffer);
+    if (entry.vao) glDeleteVertexArrays(1, &entry.vao);
+    if (entry.buffer) glDeleteBuffers(1, &entry.buffer);
+    if (entry.feedback) glDeleteTransformFeedbacks(1, &entry.feedback);
+
+    stats.bytes -= entry.capacity;
+    entry = Entry();
+}
+
+std::size_t TessellationCache::GetCaptureSize(const Mesh* mesh, const TessellationParams& params) const
+{
+    std::size_t triangles = mesh->GetTriangleCount() * TrianglesPerPatch(params.outerLevel, params.innerLevel, maxLevel);
+    return triangles * 3 * sizeof(Vertex);
+}
+
+bool TessellationCache::Draw(const Mesh* mesh, const TessellationParams& params)
+{
+    if (!IsSupported() || !mesh || mesh->GetVAO() == 0)
+        return false;
+
+    Entry& entry = entries[mesh];
+    entry.lastUsedFrame = frameNumber;
+
+    if (!entry.valid || entry.meshRevision != mesh->GetRevision() || entry.params != params)
+    {
+        if (!Capture(mesh, params, entry))
+            return false;
+    }
+
+    GLState::GetInstance()->BindVertexArray(entry.vao);
+    glDrawTransformFeedback(GL_TRIANGLES, entry.feedback);
+    stats.replays++;
+    return true;
+}
+
+bool TessellationCache::Capture(const Mesh* mesh, const TessellationParams& params, Entry& entry)
+{
+    PROFILE_SCOPE("TessellationCache::Capture");
+
+    entry.valid = false;
+
+    std::size_t size = GetCaptureSize(mesh, params);
+    std::size_t grownBytes = stats.bytes + (size > entry.capacity ? size - entry.capacity : 0);
+    if (size == 0 || grownBytes > MAX_BYTES)
+        return false;
+
+    GLState* state = GLState::GetInstance();
+    if (entry.vao == 0)
+    {
+        glGenVertexArrays(1, &entry.vao);
+        glGenTransformFeedbacks(1, &entry.feedback);
+        entry.buffer = state->CreateBuffer();
+
+        state->BindVertexArray(entry.vao);
+        state->BindBuffer(GL_ARRAY_BUFFER, entry.buffer);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
+    }
+
+    // Only grows, shrinking would just reallocate again when the levels go back up
+    if (size > entry.capacity)
+    {
+        state->BufferData(GL_ARRAY_BUFFER, entry.buffer, size, nullptr, GL_STATIC_DRAW);
+        stats.bytes = grownBytes;
+        entry.capacity = size;
+    }
+
+    captureShader->Use();
+    captureShader->SetMat4(UNIFORM_MODEL, glm::mat4(1.0f));
+    captureShader->SetFloat(UNIFORM_TESS_LEVEL_OUTER, params.outerLevel);
+    captureShader->SetFloat(UNIFORM_TESS_LEVEL_INNER, params.innerLevel);
+    captureShader->SetFloat(UNIFORM_DISPLACE_AMOUNT, params.displacement);
+    captureShader->SetBool(UNIFORM_ADAPTIVE_TESSELLATION, false);
+
+    // The feedback object remembers the vertex count for glDrawTransformFeedback
+    glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, entry.feedback);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, entry.buffer);
+    state->SetEnabled(GL_RASTERIZER_DISCARD, true);
+
+    glBeginTransformFeedback(GL_TRIANGLES);
+    mesh->Draw(Mesh::RenderMode::PATCHES);
+    glEndTransformFeedback();
+
+    state->SetEnabled(GL_RASTERIZER_DISCARD, false);
+    glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+
+    replayShader->Use();
+
+    entry.meshRevision = mesh->GetRevision();
+    entry.params = params;
+    entry.valid = true;
+    stats.captures++;
+    stats.meshes = static_cast<int>(entries.size());
+    return true;
+}
@@ -0,0 +1,70 @@
+#include "TextureBuffer.h"
+#include "GLState.h"
+#include <algorithm>
+
+namespace {
+    // glTexBuffer rejects buffers without a data store
+    constexpr std::size_t MIN_BUFFER_SIZE = 16;
+}
+
+TextureBuffer::~TextureBuffer()
+{
+    Delete();
+}
+
+void TextureBuffer::Create(GLenum newFormat)
+{
+    Delete();
+
+    GLState* state = GLState::GetInstance();
+    format = newFormat;
+    buffer = state->CreateBuffer();
+    capacity = MIN_BUFFER_SIZE;
+    state->BufferData(GL_TEXTURE_BUFFER, buffer, capacity, nullptr, GL_STREAM_DRAW);
+
+    glGenTextures(1, &texture);
+    state->BindTextureForEditing(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+}
+
+void TextureBuffer::Delete()
+{
+    GLState* state = GLState::GetInstance();
+    if (texture)
+    {
+        state->OnTextureDeleted(texture);
+        glDeleteTextures(1, &texture);
+    }
+    if (buffer)
+    {
+        state->OnBufferDeleted(buffer);
+        glDeleteBuffers(1, &buffer);
+    }
+    buffer = 0;
+    texture = 0;
+    format = 0;
+    capacity = 0;
+}
+
+void TextureBuffer::Upload(const void* data, std::size_t size)
+{
+    if (size == 0 || !buffer)
+        return;
+
+    // Grow geometrically, otherwise orphan the old storage so in-flight draws don't stall the upload
+    if (size > capacity)
+        capacity = std::max(size, capacity * 2);
+
+    GLState* state = GLState::GetInstance();
+    state->BufferData(GL_TEXTURE_BUFFER, buffer, capacity, nullptr, GL_STREAM_DRAW);
+    state->BufferSubData(GL_TEXTURE_BUFFER, buffer, 0, size, data);
+}
+
+void TextureBuffer::Reserve(std::size_t size)
+{
+    if (size <= capacity || !buffer)
+        return;
+
+    capacity = std::max(size, capacity * 2);
+    GLState::GetInstance()->BufferData(GL_TEXTURE_BUFFER, buffer, capacity, nullptr, GL_DYNAMIC_COPY);
+}
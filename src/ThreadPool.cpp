@@ -0,0 +1,108 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool* ThreadPool::GetInstance()
+{
+    static ThreadPool instance;
+    return &instance;
+}
+
+ThreadPool::ThreadPool()
+{
+    // The calling thread works too, so one core is left for it
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    unsigned int workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+
+    workers.reserve(workerCount);
+    for (unsigned int i = 0; i < workerCount; i++)
+        workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::Run(std::size_t count, std::size_t chunk, ChunkFunction chunkFunction, void* chunkContext)
+{
+    if (count == 0)
+        return;
+
+    chunk = std::max<std::size_t>(chunk, 1);
+    if (workers.empty() || count <= chunk)
+    {
+        chunkFunction(chunkContext, 0, count);
+        return;
+    }
+
+    std::lock_guard<std::mutex> runLock(runMutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        function = chunkFunction;
+        context = chunkContext;
+        itemCount = count;
+        chunkSize = chunk;
+        chunkCount = (count + chunk - 1) / chunk;
+        nextChunk.store(0, std::memory_order_relaxed);
+        finishedChunks = 0;
+        generation++;
+    }
+    workAvailable.notify_all();
+
+    std::size_t ran = RunChunks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finishedChunks += ran;
+    workFinished.wait(lock, [this] { return finishedChunks == chunkCount && activeWorkers == 0; });
+    function = nullptr;
+    context = nullptr;
+}
+
+std::size_t ThreadPool::RunChunks()
+{
+    std::size_t ran = 0;
+    for (;;)
+    {
+        std::size_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= chunkCount)
+            return ran;
+
+        std::size_t begin = chunk * chunkSize;
+        std::size_t end = std::min(begin + chunkSize, itemCount);
+        function(context, begin, end);
+        ran++;
+    }
+}
+
+void ThreadPool::WorkerLoop()
+{
+    unsigned long long seenGeneration = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [&] { return stopping || (generation != seenGeneration && function); });
+            if (stopping)
+                return;
+
+            seenGeneration = generation;
+            activeWorkers++;
+        }
+
+        std::size_t ran = RunChunks();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finishedChunks += ran;
+            activeWorkers--;
+        }
+        workFinished.notify_one();
+    }
+}
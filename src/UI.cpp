@@ -6,6 +6,8 @@
 #include "Shader.h"
 #include "Primitives.h"
 #include "ResourceManager.h"
+#include "Profiler.h"
+#include "GLState.h"
 
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
@@ -246,6 +248,10 @@ void UI::RenderMainMenuBar()
                     if (ImGui::MenuItem("Deferred", nullptr, isDeferred))
                         renderer->SetRenderMode(RenderMode::Deferred);
                         
+                    bool isClusteredForward = renderer->GetRenderMode() == RenderMode::ClusteredForward;
+                    if (ImGui::MenuItem("Clustered forward", nullptr, isClusteredForward))
+                        renderer->SetRenderMode(RenderMode::ClusteredForward);
+                        
                     bool isTessellation = renderer->GetRenderMode() == RenderMode::Tessellation;
                     if (ImGui::MenuItem("Tessellation", nullptr, isTessellation))
                         renderer->SetRenderMode(RenderMode::Tessellation);
@@ -253,6 +259,33 @@ void UI::RenderMainMenuBar()
                     bool isTessellationWireframe = renderer->GetRenderMode() == RenderMode::TessellationWithWireframe;
                     if (ImGui::MenuItem("Tessellation with wireframe", nullptr, isTessellationWireframe))
                         renderer->SetRenderMode(RenderMode::TessellationWithWireframe);
+                    
+                    ImGui::Separator();
+                    bool isCompactGBuffer = renderer->GetGBufferLayout() == GBufferLayout::Compact;
+                    if (ImGui::MenuItem("Compact G-buffer", nullptr, isCompactGBuffer))
+                        renderer->SetGBufferLayout(isCompactGBuffer ? GBufferLayout::Standard : GBufferLayout::Compact);
+                    
+                    bool isTiledLighting = renderer->IsTiledLightingEnabled();
+                    if (ImGui::MenuItem("Tiled light culling", nullptr, isTiledLighting))
+                        renderer->SetTiledLightingEnabled(!isTiledLighting);
+                    
+                    bool isClusterCompute = renderer->IsClusterComputeEnabled();
+                    if (ImGui::MenuItem("Cluster lights on GPU", nullptr, isClusterCompute, renderer->IsClusterComputeSupported()))
+                        renderer->SetClusterComputeEnabled(!isClusterCompute);
+                    
+                    ImGui::Separator();
+                    DynamicResolution& dynamicResolution = renderer->GetDynamicResolution();
+                    bool isDynamicResolution = dynamicResolution.IsEnabled();
+                    if (ImGui::MenuItem("Dynamic resolution", nullptr, isDynamicResolution))
+                        dynamicResolution.SetEnabled(!isDynamicResolution);
+                    
+                    float targetFrameMs = dynamicResolution.GetTargetFrameMs();
+                    if (ImGui::SliderFloat("Target GPU time (ms)", &targetFrameMs, 4.0f, 50.0f, "%.1f"))
+                        dynamicResolution.SetTargetFrameMs(targetFrameMs);
+                    
+                    float minScale = dynamicResolution.GetMinScale();
+                    if (ImGui::SliderFloat("Minimum scale", &minScale, 0.25f, 1.0f, "%.2f"))
+                        dynamicResolution.SetScaleRange(minScale, dynamicResolution.GetMaxScale());
                         
                     ImGui::EndMenu();
                 }
@@ -746,6 +779,7 @@ void UI::RenderObjectProperties()
             ImGui::ColorEdit3("Diffuse", &material.diffuse[0]);
             ImGui::ColorEdit3("Specular", &material.specular[0]);
             ImGui::SliderFloat("Shininess", &material.shininess, 1.0f, 256.0f);
+            ImGui::SliderFloat("Opacity", &material.opacity, 0.0f, 1.0f);
         }
 
         if (ImGui::Button("Unselect"))
@@ -807,6 +841,50 @@ void UI::RenderSceneSettings()
         renderer->SetClearColor(clearColor);
     }
     
+    bool instancing = renderer->IsInstancingEnabled();
+    if (ImGui::Checkbox("GPU Instancing", &instancing))
+    {
+        renderer->SetInstancingEnabled(instancing);
+    }
+    
+    bool frustumCulling = renderer->IsFrustumCullingEnabled();
+    if (ImGui::Checkbox("Frustum Culling", &frustumCulling))
+    {
+        renderer->SetFrustumCullingEnabled(frustumCulling);
+    }
+    
+    bool occlusionCulling = renderer->IsOcclusionCullingEnabled();
+    if (ImGui::Checkbox("Occlusion Culling", &occlusionCulling))
+    {
+        renderer->SetOcclusionCullingEnabled(occlusionCulling);
+    }
+    
+    bool frontToBack = renderer->IsFrontToBackEnabled();
+    if (ImGui::Checkbox("Front-to-back Sorting", &frontToBack))
+    {
+        renderer->SetFrontToBackEnabled(frontToBack);
+    }
+    
+    bool lod = renderer->IsLodEnabled();
+    if (ImGui::Checkbox("Mesh LOD", &lod))
+    {
+        renderer->SetLodEnabled(lod);
+    }
+    if (lod)
+    {
+        float lodPixelError = renderer->GetLodPixelError();
+        if (ImGui::SliderFloat("LOD Pixel Error", &lodPixelError, 0.25f, 8.0f, "%.2f px"))
+        {
+            renderer->SetLodPixelError(lodPixelError);
+        }
+    }
+    
+    bool depthPrepass = renderer->IsDepthPrepassEnabled();
+    if (ImGui::Checkbox("Depth Pre-pass", &depthPrepass))
+    {
+        renderer->SetDepthPrepassEnabled(depthPrepass);
+    }
+    
     ImGui::Separator();
     
     // Light settings
@@ -827,6 +905,7 @@ void UI::RenderSceneSettings()
                     ImGui::DragFloat3("Position", &light->position[0], 0.1f);
                     ImGui::ColorEdit3("Color", &light->color[0]);
                     ImGui::SliderFloat("Intensity", &light->intensity, 0.0f, 10.0f);
+                    ImGui::DragFloat("Range", &light->range, 0.1f, 0.0f, 1000.0f, light->range > 0.0f ? "%.1f" : "unbounded");
                 }
                 
                 ImGui::TreePop();
@@ -855,18 +934,45 @@ void UI::RenderSceneSettings()
             float tessLevelOuter = renderer->GetTessellationLevelOuter();
             float tessLevelInner = renderer->GetTessellationLevelInner();
             float displaceAmount = renderer->GetDisplacementAmount();
+            bool adaptive = renderer->IsAdaptiveTessellationEnabled();
+            
+            if (ImGui::Checkbox("Adaptive (screen-space)", &adaptive))
+                renderer->SetAdaptiveTessellationEnabled(adaptive);
             
-            if (ImGui::SliderFloat("Outer Tessellation Level", &tessLevelOuter, 1.0f, 64.0f))
-                renderer->SetTessellationLevelOuter(tessLevelOuter);
+            if (adaptive)
+            {
+                float triangleSize = renderer->GetTessellationTriangleSize();
+                bool backfaceCulling = renderer->IsPatchBackfaceCullingEnabled();
                 
-            if (ImGui::SliderFloat("Inner Tessellation Level", &tessLevelInner, 1.0f, 64.0f))
-                renderer->SetTessellationLevelInner(tessLevelInner);
+                if (ImGui::SliderFloat("Triangle Size (px)", &triangleSize, 1.0f, 64.0f))
+                    renderer->SetTessellationTriangleSize(triangleSize);
+                
+                if (ImGui::Checkbox("Cull Back-facing Patches", &backfaceCulling))
+                    renderer->SetPatchBackfaceCullingEnabled(backfaceCulling);
+            }
+            else
+            {
+                if (ImGui::SliderFloat("Outer Tessellation Level", &tessLevelOuter, 1.0f, 64.0f))
+                    renderer->SetTessellationLevelOuter(tessLevelOuter);
+                    
+                if (ImGui::SliderFloat("Inner Tessellation Level", &tessLevelInner, 1.0f, 64.0f))
+                    renderer->SetTessellationLevelInner(tessLevelInner);
+                
+                bool cacheEnabled = renderer->IsTessellationCacheEnabled();
+                if (ImGui::Checkbox("Cache Tessellated Meshes", &cacheEnabled))
+                    renderer->SetTessellationCacheEnabled(cacheEnabled);
+            }
                 
             if (ImGui::SliderFloat("Displacement Amount", &displaceAmount, 0.0f, 1.0f))
                 renderer->SetDisplacementAmount(displaceAmount);
                 
+            const RenderStats& stats = renderer->GetStats();
+            if (stats.tessellatedPrimitives >= 0)
+                ImGui::Text("Generated: %lld triangles from %zu patches", stats.tessellatedPrimitives, stats.triangles);
+            
             ImGui::TextWrapped("Tessellation subdivides triangles to create more detailed geometry. "
-                             "Higher tessellation levels create more subdivisions.");
+                             "Adaptive mode splits each edge into segments of roughly the target size on screen "
+                             "and skips patches outside the view.");
         }
         else
         {
@@ -921,6 +1027,83 @@ void UI::RenderPerformanceOverlay()
         ImGui::PlotLines("##FrameTimes", frameTimes, IM_ARRAYSIZE(frameTimes), frameTimeIndex, 
                        overlay, 0.0f, 0.040f, ImVec2(0, 80));
         
+        Application* app = Application::GetInstance();
+        if (app && app->GetRenderer())
+        {
+            const RenderStats& stats = app->GetRenderer()->GetStats();
+            ImGui::Separator();
+            ImGui::Text("Objects: %d visible, %d culled", stats.visibleObjects, stats.culledObjects);
+            if (app->GetRenderer()->IsOcclusionCullingEnabled())
+            {
+                ImGui::Text("Occluded: %d (%d occluders, %zu triangles, %s)", stats.occludedObjects, stats.occluders,
+                            stats.occluderTriangles,
+                            OcclusionCuller::GetSimdPathName(app->GetRenderer()->GetOcclusionCuller().GetSimdPath()));
+            }
+            if (stats.selectedObjects > 0)
+                ImGui::Text("Selected: %d (outlined in one pass)", stats.selectedObjects);
+            ImGui::Text("Draw calls: %d", stats.drawCalls);
+            ImGui::Text("Queue: %d items, %d transparent, %s sort", stats.renderItems, stats.transparentObjects,
+                        stats.incrementalSort ? "incremental" : "full");
+            ImGui::Text("Triangles: %zu", stats.triangles);
+            if (stats.fullDetailTriangles > stats.triangles)
+                ImGui::Text("  %zu at full detail", stats.fullDetailTriangles);
+            if (app->GetRenderer()->IsLodEnabled())
+            {
+                std::string lodLine = "LOD objects:";
+                for (int level = 0; level < Mesh::MAX_LODS; level++)
+                    lodLine += " " + std::to_string(stats.lodObjects[level]);
+                ImGui::TextUnformatted(lodLine.c_str());
+            }
+            if (stats.tessellatedPrimitives >= 0)
+                ImGui::Text("Tessellated primitives: %lld", stats.tessellatedPrimitives);
+            if (app->GetRenderer()->IsTessellationCacheActive())
+            {
+                const TessellationCache::Stats& cacheStats = app->GetRenderer()->GetTessellationCacheStats();
+                ImGui::Text("Tessellation cache: %d meshes, %.1f MB, %d captured", cacheStats.meshes,
+                            cacheStats.bytes / (1024.0 * 1024.0), cacheStats.captures);
+            }
+            if (stats.depthPrepassDraws > 0)
+                ImGui::Text("Depth pre-pass: %d objects in %d draws", stats.depthPrepassObjects, stats.depthPrepassDraws);
+            ImGui::Text("Instanced: %d objects in %d batches", stats.instancedObjects, stats.instancedBatches);
+            ImGui::Text("Program switches: %d", stats.programSwitches);
+            ImGui::Text("VAO switches: %d", stats.vaoSwitches);
+            const GLStateStats& stateStats = GLState::GetInstance()->GetStats();
+            ImGui::Text("State changes: %d issued, %d skipped", stateStats.issued, stateStats.skipped);
+            
+            Renderer* renderer = app->GetRenderer();
+            ImGui::Text("Render resolution: %dx%d (%.0f%%)", renderer->GetRenderWidth(), renderer->GetRenderHeight(),
+                        renderer->GetDynamicResolution().GetScale() * 100.0f);
+            RenderTargetPool::Stats targetStats = renderer->GetRenderTargetStats();
+            ImGui::Text("Render targets: %d textures (%d in use), %.1f MB", targetStats.textures, targetStats.texturesInUse,
+                        targetStats.bytes / (1024.0 * 1024.0));
+            if (renderer->GetRenderMode() == RenderMode::Deferred && renderer->IsTiledLightingEnabled())
+            {
+                const LightGrid::Stats& gridStats = renderer->GetLightGridStats();
+                ImGui::Text("Light tiles: %d lights, %.1f avg / %d max per tile", gridStats.lights, gridStats.avgLightsPerTile, gridStats.maxLightsPerTile);
+            }
+            else if (renderer->GetRenderMode() == RenderMode::ClusteredForward)
+            {
+                const ClusterGrid::Stats& clusterStats = renderer->GetClusterGridStats();
+                if (clusterStats.computeAssignment)
+                    ImGui::Text("Light clusters: %d lights in %d clusters, assigned on GPU", clusterStats.lights, clusterStats.clusters);
+                else
+                    ImGui::Text("Light clusters: %d lights, %d/%d clusters lit, %.1f avg / %d max per cluster", clusterStats.lights,
+                                clusterStats.activeClusters, clusterStats.clusters, clusterStats.avgLightsPerActiveCluster, clusterStats.maxLightsPerCluster);
+            }
+            
+            GpuProfiler& gpuProfiler = app->GetRenderer()->GetGpuProfiler();
+            if (gpuProfiler.IsSupported())
+            {
+                ImGui::Separator();
+                ImGui::Text("GPU (ms)        last    min    avg    p99");
+                for (const auto& pass : gpuProfiler.GetPassStats())
+                {
+                    ImGui::Text("%-14s %6.3f %6.3f %6.3f %6.3f", pass.name.c_str(),
+                                pass.lastMs, pass.minMs, pass.avgMs, pass.p99Ms);
+                }
+            }
+        }
+        
         if (ImGui::BeginPopupContextWindow())
         {
             if (ImGui::MenuItem("Custom", NULL, corner == -1)) corner = -1;
@@ -928,6 +1111,12 @@ void UI::RenderPerformanceOverlay()
             if (ImGui::MenuItem("Top-right", NULL, corner == 1)) corner = 1;
             if (ImGui::MenuItem("Bottom-left", NULL, corner == 2)) corner = 2;
             if (ImGui::MenuItem("Bottom-right", NULL, corner == 3)) corner = 3;
+            if (app && app->GetRenderer() && ImGui::MenuItem("Dump GPU timings"))
+                app->GetRenderer()->GetGpuProfiler().DumpToFile("gpu_timings.json");
+#ifdef ENABLE_PROFILER
+            if (ImGui::MenuItem("Capture CPU trace (120 frames)", NULL, false, !Profiler::GetInstance()->IsCapturing()))
+                Profiler::GetInstance()->BeginCapture(120, "cpu_trace.json");
+#endif
             if (ImGui::MenuItem("Close")) showPerformanceOverlay = false;
             ImGui::EndPopup();
         }
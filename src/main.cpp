@@ -4,14 +4,26 @@
 #include "SceneObject.h"
 #include "Shader.h"
 #include "Model.h"
+#include "Profiler.h"
 #include <iostream>
 #include <memory>
 #include <string>
 #include <filesystem>
+#include <cstdlib>
 
 
-int main()
+int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
 {
+#ifdef ENABLE_PROFILER
+    // --trace-frames N records startup and the first N frames to cpu_trace.json
+    Profiler::GetInstance()->SetThreadName("Main");
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (std::string(argv[i]) == "--trace-frames")
+            Profiler::GetInstance()->BeginCapture(std::atoi(argv[i + 1]), "cpu_trace.json");
+    }
+#endif
+
     Application app("OpenGL Learning", 1920, 1080);
     if (!app.Initialize())
     {